@@ -1,14 +1,120 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include <limits.h>
+#include <float.h>
 #include <stdint.h>
+#include <math.h>
 #include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "sorting.h"
 #ifdef _WIN32
     #include <windows.h>
+    #include <io.h>
+    #include <process.h>
+#else
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <poll.h>
+    #include <signal.h>
+#endif
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #define HARDWARE_COUNTERS_SUPPORTED
 #endif
 
 #define MAX_RANGE ULONG_MAX
+// Size of the chunks the output files are formatted into before each write
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+// Smallest read buffer per run during the merge phase of the external sort
+#define EXTERNAL_MIN_BUFFER_KEYS (64 * 1024)
+// Keys sorted once to measure the scratch memory per key of the algorithm of the external sort
+#define EXTERNAL_SCRATCH_PROBE_KEYS (1 << 18)
+// Bytes of text the streaming sort reads from its input at a time
+#define STREAM_READ_SIZE (1 << 20)
+// Sorted runs a tier of the streaming sort holds before they are merged into one run of the next tier
+#define STREAM_TIER_FANOUT 4
+// Tiers of the streaming sort, the last one merges into itself
+#define STREAM_MAX_TIERS 24
+// Size of a huge page on x86-64 and ARM64 Linux
+#define HUGE_PAGE_SIZE (2UL << 20)
+// Last level cache size assumed when the system doesn't report it
+#define DEFAULT_LAST_LEVEL_CACHE_SIZE (32UL << 20)
+// The cold timing mode reads this many times the last level cache before each run, the
+// caches are not strictly LRU and a single pass can leave some of the data in them
+#define CACHE_FLUSH_FACTOR 2
+// Keys sorted per timing by the calibration run, split into arrays of the calibrated N
+#define CALIBRATION_KEYS (1 << 20)
+// Largest N the calibration run times
+#define CALIBRATION_MAX_SIZE (1 << 22)
+// How the data is prepared before the timer starts (see timingModeNames): written just before
+// the run (warm), evicted from the caches (cold), or written just before the run into huge pages
+#define TIMING_WARM 0
+#define TIMING_COLD 1
+#define TIMING_HUGE_PAGES 2
+// Formats of the sorted output files
+#define OUTPUT_FORMAT_NONE 0
+#define OUTPUT_FORMAT_TEXT 1
+#define OUTPUT_FORMAT_BINARY 2
+// Data generation methods, numbered as in the menu (see dataGenerationMethods)
+#define METHOD_RANDOM 1
+#define METHOD_INCREASING 2
+#define METHOD_FILE 3
+#define METHOD_REVERSED 4
+#define METHOD_NEARLY_SORTED 5
+#define METHOD_FEW_UNIQUE 6
+#define METHOD_ORGAN_PIPE 7
+#define METHOD_SAWTOOTH 8
+#define METHOD_ZIPF 9
+#define METHOD_UNIFORM_64 10
+// Keys per block of generated data. Every block has its own random stream derived from the
+// seed, so blocks are generated in parallel and any block can be reproduced on its own.
+#define GENERATION_BLOCK_SIZE (1 << 16)
+// Growth rate of the running time of an algorithm, used to predict its time at larger N
+#define COMPLEXITY_LINEAR 1
+#define COMPLEXITY_N_LOG_N 2
+#define COMPLEXITY_QUADRATIC 3
+// Outcome of one algorithm in one cell of the batch
+#define RESULT_COMPLETED 0
+#define RESULT_TIMED_OUT 1
+#define RESULT_SKIPPED 2
+// Tables of the scaling benchmark: fixed N (strong) and fixed N per thread (weak)
+#define SCALING_STRONG 1
+#define SCALING_WEAK 2
+// Operations of the selection benchmark: the k-th smallest key, the k smallest keys, or the k smallest in order
+#define SELECTION_NTH_ELEMENT 0
+#define SELECTION_TOP_K 1
+#define SELECTION_PARTIAL_SORT 2
+// How the record benchmark sorts records: moving whole records, or sorting (key, index) pairs
+// and then moving every record once, either into a new array or in place along the cycles
+#define RECORD_SORT_DIRECT 0
+#define RECORD_SORT_GATHER 1
+#define RECORD_SORT_CYCLES 2
+// Records ahead of the current one fetched into the cache while gathering records
+#define GATHER_PREFETCH_DISTANCE 8
+// Number of hardware events counted around each sort (see hardwareCounterNames)
+#define HARDWARE_COUNTERS_SIZE 6
+// Commit the program was built from, recorded with every result,
+// e.g. gcc -DBUILD_COMMIT="\"$(git rev-parse --short HEAD)\"" ...
+#ifndef BUILD_COMMIT
+    #define BUILD_COMMIT "unknown"
+#endif
+// Compiler the program was built with, recorded with every result
+#if defined(__clang__)
+    #define COMPILER_VERSION "clang " __clang_version__
+#elif defined(__GNUC__)
+    #define COMPILER_VERSION "gcc " __VERSION__
+#else
+    #define COMPILER_VERSION "unknown"
+#endif
 
 /**
  * @struct SortingAlgorithm
@@ -17,153 +123,1247 @@
  * @var outputFile Name of the file where the sorted integers will be stored
  * @var time Time taken for the algorithms to sort
  * @var function Function pointer to its algorithm
+ * @var isParallel 1 if the algorithm uses sortingThreads threads, 0 if it is serial
+ * @var complexity Growth rate of its worst case (COMPLEXITY_*)
+ * @var elementType Element type of typedFunction, NULL for the algorithms on unsigned long int keys
+ * @var typedFunction The algorithm specialized for elementType, used instead of function
  * 
  * This object gives us OOP-like features, encapsulating related data and
  * improves maintainability. It also allows us to perform more complex logic
  *  such as iteration on the algorithms, and sorting by a member.
  */
+typedef struct ElementType ElementType;
 typedef struct {
     const char *name;
     const char *outputFile;
     double time;
     void (*function)(unsigned long int*, int);
+    int isParallel;
+    int complexity;
+    const ElementType *elementType;
+    void (*typedFunction)(void*, int);
 } SortingAlgorithm;
 
 /**
- * @brief Generates an array of random integers.
+ * @struct ElementType
+ * @brief An element type the typed sorting algorithms are specialized for
+ * @var size Bytes per element
+ * @var fill Converts the generated keys into elements of this type, keeping their order
+ * @var isSorted Checks that the elements are in non-decreasing order of their keys
+ * @var sortKey The key of an element as an unsigned integer in the same order as the elements
+ */
+struct ElementType {
+    const char *name;
+    const char *description;
+    size_t size;
+    void (*fill)(void *array, const unsigned long int *keys, int n);
+    int (*isSorted)(const void *array, int n);
+    uint64_t (*sortKey)(const void *array, int i);
+};
+
+/**
+ * @struct BenchmarkStats
+ * @brief Summary statistics of the repeated timings of one algorithm
+ * @var min Fastest recorded time
+ * @var median Median of the recorded times
+ * @var mean Average of the recorded times
+ * @var stddev Sample standard deviation of the recorded times
+ * @var samples Number of recorded times
+ */
+typedef struct {
+    double min;
+    double median;
+    double mean;
+    double stddev;
+    int samples;
+} BenchmarkStats;
+
+/**
+ * @struct HardwareCounters
+ * @brief The hardware events counted while an algorithm sorts
+ * @var values Count of each event of hardwareCounterNames, scaled up if the event was multiplexed
+ * @var runs Number of runs added into values, 0 if nothing was counted
+ */
+typedef struct {
+    double values[HARDWARE_COUNTERS_SIZE];
+    int runs;
+} HardwareCounters;
+
+/**
+ * @struct BenchmarkResult
+ * @brief The statistics of one algorithm in one cell of the batch
+ * @var algorithm The algorithm that was run
+ * @var threads The thread count it ran with, 0 for serial algorithms
+ * @var speedup Median time with the first thread count of the sweep divided by this median
+ * @var stats The statistics of its timed runs
+ * @var counters The hardware events of its timed runs, summed over the runs
+ * @var operations The key operations of its timed runs, summed over the runs
+ * @var memory The scratch memory of its timed runs: the allocations and their time are
+ * summed over the runs, the peak is the largest of any run
+ * @var status RESULT_COMPLETED, or why there are no statistics (RESULT_TIMED_OUT or RESULT_SKIPPED)
+ * @var predictedTime Time per run predicted from the smaller N, when it was skipped
+ */
+typedef struct {
+    const SortingAlgorithm *algorithm;
+    int threads;
+    double speedup;
+    BenchmarkStats stats;
+    HardwareCounters counters;
+    OperationCounts operations;
+    MemoryCounts memory;
+    int status;
+    double predictedTime;
+} BenchmarkResult;
+
+/**
+ * @struct TimingHistory
+ * @brief The median times of one algorithm (and thread count) at the N already run with one method
+ * @var timedOutSize The smallest N where it ran out of time, 0 if it never did
+ */
+typedef struct {
+    int count;
+    double *sizes;
+    double *times;
+    int timedOutSize;
+} TimingHistory;
+
+/**
+ * @struct RunEnvironment
+ * @brief What the results were measured with. It is recorded with every result so that
+ * results from different builds and machines can be told apart.
+ * @var build "timing", or "counting" when built with -DCOUNT_OPERATIONS
+ * @var timestamp Start of the benchmarks, in UTC (ISO 8601)
+ */
+typedef struct {
+    const char *commit;
+    const char *compiler;
+    const char *build;
+    char cpu[128];
+    int processors;
+    char timestamp[32];
+} RunEnvironment;
+
+/**
+ * @struct StoredResult
+ * @brief One result record read back from a results file. Cells are matched by
+ * (algorithm, threads, N, method, timing mode, mode) when two results files are compared.
+ * @var mode "batch" or "interactive", the mode of the benchmark that measured it
+ * @var isCompleted 0 if the algorithm timed out or was skipped, it then has no samples
+ * @var samples The timed runs, in the order they were run
+ */
+typedef struct {
+    char algorithm[64];
+    char method[128];
+    char timing[16];
+    char mode[16];
+    int n;
+    int threads;
+    int isCompleted;
+    double *samples;
+    int samplesCount;
+} StoredResult;
+
+/**
+ * @struct GenerationParameters
+ * @brief The settings of the data generation methods
+ * @var seed Seed of the random streams. The same seed gives the same data.
+ * @var startingValue Smallest key (X) of the increasing, reversed, nearly sorted, organ pipe and sawtooth data
+ * @var swapPercent Random swaps applied to the nearly sorted data, in percent of N
+ * @var uniqueKeys Number of distinct keys of the few unique data
+ * @var sawtoothRuns Number of increasing runs of the sawtooth data
+ * @var zipfExponent Exponent (s) of the Zipf distribution, larger values repeat the frequent keys more
+ */
+typedef struct {
+    unsigned int seed;
+    unsigned long int startingValue;
+    double swapPercent;
+    int uniqueKeys;
+    int sawtoothRuns;
+    double zipfExponent;
+} GenerationParameters;
+
+/**
+ * @struct ZipfSampler
+ * @brief The precomputed constants of the rejection-inversion Zipf sampler (Hormann and Derflinger)
+ * @var n Number of ranks, the keys are drawn from ranks 1..n
+ */
+typedef struct {
+    int n;
+    double exponent;
+    double hIntegralX1;
+    double hIntegralN;
+    double threshold;
+} ZipfSampler;
+
+/**
+ * @struct GenerationTask
+ * @brief The shared state and thread id passed to each generationWorker
+ * @var uniqueKeys The distinct keys of the few unique data, NULL for other methods
+ */
+typedef struct {
+    unsigned long int *array;
+    int n;
+    int method;
+    const GenerationParameters *parameters;
+    const unsigned long int *uniqueKeys;
+    const ZipfSampler *zipf;
+    int threads;
+    int id;
+} GenerationTask;
+
+/**
+ * @struct BatchOptions
+ * @brief The parsed command-line options of the batch mode
+ * @var sizes The values of N to benchmark
+ * @var methods The data generation methods to benchmark (1-based, same as the menu)
+ * @var selectedAlgorithms Flags for each entry in algorithms[], 1 if it should be run
+ * @var threads The thread counts that parallel algorithms are run with
+ * @var generation Seed and settings of the data generation methods
+ * @var repetitions Number of timed runs per algorithm
+ * @var warmups Number of untimed runs per algorithm before the timed runs
+ * @var csvFile Optional file where a row per (N, method, algorithm) is appended
+ * @var outputFormat Format of the unsorted and sorted output files (OUTPUT_FORMAT_*)
+ * @var inputFile Data file used by the "From file" method, NULL if not given
+ * @var externalInput File of raw 64-bit keys to sort out of core, NULL to run the benchmarks instead
+ * @var externalOutput Where the external sort writes the sorted keys
+ * @var temporaryDirectory Where the external sort writes its sorted runs
+ * @var memoryBudget Bytes of keys the external sort may hold in memory at once
+ * @var timeBudget Seconds a single run of an algorithm may take, 0 for no limit
+ * @var selectedElementTypes Flags for each entry in elementTypes[], NULL to run algorithms[] instead of the typed algorithms
+ * @var selectedRecordTypes Flags for each entry in elementTypes[] of the record benchmark, NULL to not run it
+ * @var resultsFile File where a record per (N, method, algorithm) is appended, NULL for none
+ * @var compareBaseline Results file to compare compareCandidate with, NULL to run the benchmarks instead
+ * @var regressionThreshold Smallest slowdown of the median reported as a regression, in percent
+ * @var significanceLevel Largest p-value of a slowdown reported as a regression
+ * @var scalingMode SCALING_STRONG and/or SCALING_WEAK to run the scaling benchmark, 0 to not run it
+ * @var calibrationFile Where the calibration run saves the thresholds of sort_u64, NULL to run the benchmarks instead
+ * @var selectRatios The values of k / N of the selection benchmark, NULL to not run it
+ * @var streamFormat Format of the keys the streaming sort reads from stdin (OUTPUT_FORMAT_*),
+ * OUTPUT_FORMAT_NONE to run the benchmarks instead
+ * @var streamOutput Where the streaming sort writes the sorted keys, NULL to only merge them
+ * @var streamBatchSize Bytes of keys per batch sorted by the background thread of the streaming sort
+ * @var streamSnapshotSize Bytes of keys read between the sorted outputs written while the input
+ * is still arriving, 0 to write it only at the end
+ */
+typedef struct {
+    int *sizes;
+    int sizesCount;
+    int *methods;
+    int methodsCount;
+    int *selectedAlgorithms;
+    int *threads;
+    int threadsCount;
+    GenerationParameters generation;
+    int repetitions;
+    int warmups;
+    const char *csvFile;
+    int outputFormat;
+    const char *inputFile;
+    const char *externalInput;
+    const char *externalOutput;
+    const char *temporaryDirectory;
+    unsigned long long memoryBudget;
+    double timeBudget;
+    int *selectedElementTypes;
+    int *selectedRecordTypes;
+    const char *resultsFile;
+    const char *compareBaseline;
+    const char *compareCandidate;
+    double regressionThreshold;
+    double significanceLevel;
+    int scalingMode;
+    const char *calibrationFile;
+    double *selectRatios;
+    int selectRatiosCount;
+    int streamFormat;
+    const char *streamOutput;
+    unsigned long long streamBatchSize;
+    unsigned long long streamSnapshotSize;
+} BatchOptions;
+
+/**
+ * @struct ExternalRun
+ * @brief A sorted run file being read during the merge phase of the external sort. Each run
+ * has two buffers: one is consumed by the merge while the other is filled in the background.
+ * @var counts Keys in each buffer, 0 once the end of the file was reached
+ * @var ready 1 when the background thread has filled the buffer
+ * @var current The buffer being consumed
+ * @var position The next key of the current buffer
+ * @var finished 1 when every key of the run has been merged
+ */
+typedef struct {
+    FILE *file;
+    unsigned long int *buffers[2];
+    size_t counts[2];
+    int ready[2];
+    int current;
+    size_t position;
+    int finished;
+} ExternalRun;
+
+/**
+ * @struct PrefetchQueue
+ * @brief The buffers waiting to be filled by the background thread of the external sort
+ * @var requests Ring of requested buffers, encoded as run * 2 + buffer. It has one spare
+ * slot so that a full ring is not mistaken for an empty one.
+ * @var bufferKeys The capacity of each run buffer, in keys
+ * @var isReadFailed 1 once reading a run failed, the merge stops at the next buffer
+ */
+typedef struct {
+    ExternalRun *runs;
+    int runsCount;
+    size_t bufferKeys;
+    int isReadFailed;
+    int *requests;
+    int requestsHead;
+    int requestsTail;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t requested;
+    pthread_cond_t filled;
+} PrefetchQueue;
+
+/**
+ * @struct StreamSorter
+ * @brief The state shared by the reader and the background thread of the streaming sort. The
+ * reader hands over full batches, the background thread sorts them and keeps the sorted runs
+ * in tiers like an LSM tree: a tier that reaches STREAM_TIER_FANOUT runs is merged into one run
+ * of the next tier. The runs are in memory, as ExternalRuns with only their first buffer used.
+ * @var pending Full batch waiting for the background thread, NULL when there is none
+ * @var isBusy 1 while the background thread sorts a batch or merges tiers
+ * @var isEnd 1 once the input is exhausted and the background thread should stop
+ * @var tierCounts The number of runs in each tier
+ * @var sortTime Seconds the background thread spent sorting batches
+ * @var mergeTime Seconds the background thread spent merging tiers
+ * @var mergedKeys Keys written by the tier merges, counted once per merge they took part in
+ */
+typedef struct {
+    const SortingAlgorithm *algorithm;
+    unsigned long int *pending;
+    size_t pendingCount;
+    int isBusy;
+    int isEnd;
+    ExternalRun tiers[STREAM_MAX_TIERS][STREAM_TIER_FANOUT];
+    int tierCounts[STREAM_MAX_TIERS];
+    double sortTime;
+    double mergeTime;
+    unsigned long long mergedKeys;
+    pthread_mutex_t lock;
+    pthread_cond_t batchReady;
+    pthread_cond_t batchTaken;
+} StreamSorter;
+
+/**
+ * @struct StreamReader
+ * @brief Keys read from a file descriptor in large chunks. Text is parsed like the data files:
+ * lines that don't start with a digit are skipped, keys may be split across two chunks.
+ * Lines with a key too large for an unsigned long int are rejected whole.
+ * @var format OUTPUT_FORMAT_BINARY or OUTPUT_FORMAT_TEXT
+ * @var buffer The chunk of text being parsed, unused for binary keys
+ * @var key The digits of the current key parsed so far, if isInKey
+ * @var isLineSkipped 1 on a line that doesn't start with a digit or that was rejected
+ * @var carry The keys of the line a full batch stopped in, moved to the start of the next batch
+ * @var rejectedLines Lines rejected for a key that doesn't fit
+ * @var bytesRead Bytes read since the beginning
+ * @var isEnd 1 once the end of the input was reached
+ */
+typedef struct {
+    int fileDescriptor;
+    int format;
+    char *buffer;
+    size_t size;
+    size_t position;
+    unsigned long int key;
+    int isInKey;
+    int isAtLineStart;
+    int isLineSkipped;
+    unsigned long int *carry;
+    size_t carryCount;
+    size_t carryCapacity;
+    unsigned long long rejectedLines;
+    unsigned long long bytesRead;
+    int isEnd;
+} StreamReader;
+
+/**
+ * @struct Dataset
+ * @brief Keys loaded from a data file
+ * @var keys The loaded keys. They may point straight into the mapped file, so they are read-only.
+ * @var n The number of keys
+ * @var mapping The mapped file, NULL once it is no longer needed
+ * @var mappingSize The size of the mapped file in bytes
+ * @var ownsKeys 1 if keys was allocated (parsed or converted) and needs to be freed
+ */
+typedef struct {
+    unsigned long int *keys;
+    int n;
+    void *mapping;
+    size_t mappingSize;
+    int ownsKeys;
+} Dataset;
+
+/**
+ * @brief Generates the data of a generation method, in parallel blocks on sortingThreads threads.
+ * The data only depends on the method and the parameters, not on the number of threads.
+ * @param method The generation method (METHOD_*), anything but METHOD_FILE
  * @param n The size of the resulting array.
- * @return The dynamically allocated array. It needs to be manually freed when used.
+ * @param parameters The seed and settings of the methods
+ * @return The dynamically allocated array, or NULL if it can't be allocated. It needs to be manually freed when used.
+ */
+unsigned long int *generateData(int method, int n, const GenerationParameters *parameters);
+/**
+ * @brief The work of one thread of generateData (argument is a GenerationTask). It fills
+ * the blocks id, id + threads, id + 2 * threads...
+ */
+void *generationWorker(void *argument);
+/**
+ * @brief Fills one block of GENERATION_BLOCK_SIZE keys, or less for the last block.
+ */
+void generateBlock(const GenerationTask *task, int block);
+/**
+ * @brief Precomputes the constants to draw ranks 1..n with probability proportional to 1 / rank^exponent.
+ */
+void initializeZipfSampler(ZipfSampler *sampler, int n, double exponent);
+/**
+ * @brief Draws a Zipf distributed rank in 1..n with rejection-inversion, in constant expected time.
+ */
+int sampleZipf(const ZipfSampler *sampler, RandomGenerator *generator);
+/**
+ * @brief Writes the name of a generation method with its settings, e.g. "Nearly Sorted (1% swaps)".
+ */
+void describeGenerationMethod(int method, const GenerationParameters *parameters, char *buffer, size_t size);
+/**
+ * @brief Prints the generation method of a benchmark with the seed, starting value or data file it used.
+ * @param inputFile The data file of METHOD_FILE, unused by the other methods
  */
-unsigned long int *generateRandomIntegers(int n);
+void displayGenerationMethod(int method, const GenerationParameters *parameters, const char *inputFile);
+
+/**
+ * @brief Loads the keys of a data file. Files ending in .bin hold raw little-endian 64-bit
+ * keys and are used in place through a memory mapping. Any other file is parsed as the
+ * text format of appendArrayToFile, where lines not starting with a digit are titles.
+ * @param filename The name of the data file
+ * @param dataset Where the loaded keys are stored
+ * @return 1 on success, 0 if the file can't be read or holds no keys
+ */
+int loadDataset(const char *filename, Dataset *dataset);
+/**
+ * @brief Parses keys separated by commas, spaces or newlines. It counts the keys in a first
+ * pass so the array is allocated once at its exact size.
+ * @param text The text to parse
+ * @param size The size of the text in bytes
+ * @param filename The name of the file of the text, for the error messages
+ * @param dataset Where the parsed keys are stored
+ * @return 1 on success, 0 on error: no keys, a key larger than an unsigned long int, or no memory
+ */
+int parseTextDataset(const char *text, size_t size, const char *filename, Dataset *dataset);
 /**
- * @brief Generates an array of integers in increasing order
- * @param n The size of the resulting array
- * @param startingValue The value of the first element of the ordered array.
- * @return The dynamically allocated array. It needs to be manually freed when used.
+ * @brief Releases the keys and the mapping of a dataset.
  */
-unsigned long int *generateIncreasingSequence(int n, unsigned long int startingValue);
+void freeDataset(Dataset *dataset);
 
 /**
  * @brief The function that runs each algorithms and records the time
  * @param array The unsorted array used on the sorting algorithms
  * @param n The size of the unsorted array
+ * @param methodName The generation method of the array, recorded in results.jsonl with the seed
+ */
+void runBenchmark(unsigned long int *array, int n, const char *methodName, unsigned int seed);
+/**
+ * @brief Times a single run of an algorithm on a copy of the array
+ * @param algorithm The algorithm to run
+ * @param array The unsorted array. It is left untouched.
+ * @param n The size of the unsorted array
+ * @param sortedArray If not NULL, receives the sorted copy, which then needs to be freed.
+ * @param result If not NULL, the hardware events and key operations of the run are added to it.
+ * @return The time taken to sort, in seconds
  */
-void runBenchmark(unsigned long int *array, int n);
+double timeSortingAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, unsigned long int **sortedArray, BenchmarkResult *result);
+/**
+ * @brief Writes a one byte marker to sortBoundaryFd, if set, right before and after a timed sort.
+ */
+void reportSortBoundary(void);
+/**
+ * @brief Times a single run of a typed algorithm on the keys converted to its element type.
+ * The conversion is not timed. sortedArray, if not NULL, is set to NULL.
+ */
+double timeTypedSortingAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, unsigned long int **sortedArray, BenchmarkResult *result);
+/**
+ * @brief Computes the min/median/mean/stddev of a set of timings
+ * @param samples The recorded times. They are sorted in place.
+ * @param count The number of recorded times
+ * @return The computed statistics
+ */
+BenchmarkStats computeBenchmarkStats(double *samples, int count);
 
 /*
 *
-* SORTING ALGORITHMS
+* BATCH MODE
 *
 */
-void selectionSort(unsigned long int *array, int n);
-void bubbleSort(unsigned long int *array, int n);
-void insertionSort(unsigned long int *array, int n);
-void merge(unsigned long int *array, int left, int mid, int right);
-void mergeSortHelper(unsigned long int *array, int left, int right);
-void mergeSort(unsigned long int *array, int n);
-int medianOfThree(unsigned long int *array, int low, int high);
-int quickSortPartition(unsigned long int *array, int low, int high);
-void quickSortHelper(unsigned long int *array, int low, int high);
-void quickSort(unsigned long int *array, int n);
-void heapSort(unsigned long int *array, int n);
-
 /**
- * @brief Clears the contents of a file.
- * @param filename The name of the file to be cleared.
-*/
-void clearFile(const char *filename);
+ * @brief Parses the command-line arguments of the batch mode
+ * @param argc The argument count passed to main()
+ * @param argv The arguments passed to main()
+ * @param options Where the parsed options are stored
+ * @return 1 if the arguments are valid, 0 otherwise
+ */
+int parseBatchOptions(int argc, char *argv[], BatchOptions *options);
 /**
- * @brief Appends a formatted string to a file.
- * @param filename The name of the file to append to.
- * @param format The format string (supports printf-style formatting).
- * @param ... Additional arguments for formatting.
+ * @brief Parses a comma separated list of N values. Each item is either a single
+ * value or a range START:END[:STEP], where STEP is added (e.g. 1000) or multiplied (e.g. x10).
+ * @param text The text to parse
+ * @param count Where the number of parsed values is stored
+ * @return The dynamically allocated values, or NULL if the text is invalid.
  */
-void appendStringToFile(const char *filename, const char *format, ...);
+int *parseSizesList(const char *text, int *count);
 /**
- * @brief Appends an array of unsigned long integers to a file.
- * @param filename The name of the file to append to.
- * @param array The array of unsigned long integers.
- * @param n The number of elements in the array.
+ * @brief Runs every (method, N, algorithm) cell of the batch without any prompts
+ * @param options The parsed batch options
  */
-void appendArrayToFile(const char *filename, unsigned long int *array, int n);
+void runBatchBenchmark(const BatchOptions *options);
 /**
- * @brief Creates a duplicate of an unsigned long int array.
- * @param array The original array to be duplicated.
- * @param n The number of elements in the array.
- * @return A pointer to the newly allocated duplicate array.
+ * @brief Compares sorting records directly (moving whole records) with sorting them indirectly
+ * (sorting (key, index) pairs then moving each record once, gathered or in place), for every
+ * selected record size and algorithm.
+ * @param options The parsed batch options, with the record sizes in selectedRecordTypes
  */
-unsigned long int *duplicateArray(const unsigned long int *array, int n);
+void runRecordBenchmark(const BatchOptions *options);
 /**
- * @brief Creates a duplicate of an array of SortingAlgorithm structures.
- * @param array The original array of SortingAlgorithm structures.
- * @param n The number of elements in the array.
- * @return A pointer to the newly allocated duplicate array.
+ * @brief Times introSelect, topK and partialSort at every k / N of selectRatios against a full
+ * sort of the same keys by the first selected algorithm (Intro Sort by default), for every method and N.
+ * @param options The parsed batch options, with the ratios in selectRatios
  */
-SortingAlgorithm *duplicateAlgorithmsArray(SortingAlgorithm *array, int n);
-unsigned long int getPositiveInteger(const char *prompt);
+void runSelectionBenchmark(const BatchOptions *options);
+/**
+ * @brief Runs the selected parallel algorithms at every thread count of the sweep and prints a
+ * strong scaling table (the same N on more threads) and/or a weak scaling table (the same N per
+ * thread, N growing with the threads) for every method and N.
+ * @param options The parsed batch options, with the tables in scalingMode
+ */
+void runScalingBenchmark(const BatchOptions *options);
+/**
+ * @brief Measures one parallel algorithm at one thread count for the scaling benchmark and
+ * appends the result to the CSV and results files.
+ * @param orderedSamples Where the timed runs are copied in the order they were run
+ * @return RESULT_COMPLETED, or RESULT_TIMED_OUT if a run took longer than the time budget
+ */
+int measureScalingCell(const SortingAlgorithm *algorithm, int threads, const unsigned long int *array, int n, const char *methodName, const BatchOptions *options, const RunEnvironment *environment, double *samples, double *orderedSamples, BenchmarkResult *result);
+/**
+ * @brief Measures the crossovers of sort_u64 on this machine (insertion vs SIMD quick sort,
+ * the N where LSD radix beats SIMD quick sort, serial vs parallel) on uniform 64-bit keys, and saves them to
+ * options->calibrationFile.
+ * @return 1 if the thresholds were saved, 0 otherwise.
+ */
+int runCalibration(const BatchOptions *options);
+/**
+ * @brief Times a sorting function on arrays of n keys, sorting consecutive slices of keys so
+ * that even the smallest n take long enough to time. The best of 3 timings is kept.
+ * @param keys At least CALIBRATION_KEYS keys, or n if n is larger
+ * @param work Room for as many keys as keys
+ * @return The time of one sort of n keys, in seconds
+ */
+double timeCalibrationSort(void (*function)(unsigned long int *, int), const unsigned long int *keys, unsigned long int *work, int n);
+/**
+ * @brief Finds the longest run of consecutive sizes where the second algorithm is faster.
+ * @param times Pairs of times (first, second) at each of the sizes
+ * @param first Where the smallest N of the run is stored, INT_MAX if the second is never faster
+ * @param last Where the largest N of the run is stored, INT_MAX if the run reaches the largest N timed
+ */
+void findFasterRange(const int *sizes, const double *times, int sizesCount, int *first, int *last);
+/**
+ * @brief Times a single run of sorting records of one type, on the keys converted to records.
+ * @param algorithm The typed algorithm of recordType for RECORD_SORT_DIRECT, the algorithm
+ * sorting the (key, index) pairs otherwise
+ * @param mode RECORD_SORT_DIRECT, RECORD_SORT_GATHER or RECORD_SORT_CYCLES
+ * @param result If not NULL, the hardware events and key operations of the run are added to it.
+ * @return The time taken to sort, in seconds
+ */
+double timeRecordSort(const SortingAlgorithm *algorithm, int mode, const ElementType *recordType, const unsigned long int *keys, int n, BenchmarkResult *result);
+/**
+ * @brief Times a single selection of the k smallest of a copy of the keys, then checks the result.
+ * @param operation SELECTION_NTH_ELEMENT, SELECTION_TOP_K or SELECTION_PARTIAL_SORT
+ * @param sortedKeys The keys sorted, to check the result with
+ * @param result If not NULL, the hardware events and key operations of the run are added to it.
+ * @return The time taken to select, in seconds
+ */
+double timeSelection(int operation, const unsigned long int *keys, int n, int k, const unsigned long int *sortedKeys, BenchmarkResult *result);
+/**
+ * @brief Checks if a typed algorithm is a version of an algorithm of algorithms[],
+ * e.g. "Intro Sort (u32)" of "Intro Sort".
+ */
+int isTypedVersionOf(const SortingAlgorithm *typedAlgorithm, const SortingAlgorithm *algorithm);
+/**
+ * @brief Appends the header row of the batch CSV file.
+ */
+void appendCsvHeader(const BatchOptions *options);
+/**
+ * @brief Runs the warm-up and timed runs of one algorithm on one array and writes the sorted
+ * output of the last run.
+ * @param samples Where the time of each timed run is stored
+ * @param result Where the hardware events and key operations are added
+ * @param reportFd If not -1, every run (warm-ups included) marks the start and end of its sort on it
+ * (see reportSortBoundary()), then writes its time as a double
+ */
+void measureAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, const BatchOptions *options, double *samples, BenchmarkResult *result, int reportFd);
+/**
+ * @brief Runs measureAlgorithm() in a child process under a watchdog. The child is killed as soon as
+ * a single sort takes longer than the time budget. On Windows it runs in-process without a watchdog.
+ * @return RESULT_COMPLETED, or RESULT_TIMED_OUT if the child was killed
+ */
+int measureAlgorithmWithBudget(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, const BatchOptions *options, double *samples, BenchmarkResult *result);
+/**
+ * @brief Reads exactly size bytes from a file descriptor, waiting at most until the deadline.
+ * @param deadline Time (as getTimeInSeconds()) after which the read gives up, INFINITY to wait without one
+ * @return 1 on success, 0 if the other end was closed, -1 if the deadline passed
+ */
+int readWithDeadline(int fileDescriptor, void *buffer, size_t size, double deadline);
+/**
+ * @brief The growth of the running time at n for a complexity class, e.g. n log2 n for COMPLEXITY_N_LOG_N.
+ */
+double complexityGrowth(int complexity, double n);
+/**
+ * @brief Predicts the time per run of an algorithm at n by fitting c * growth(N) to its earlier
+ * times. Every class up to the algorithm's own is tried and the one that fits best is used.
+ * @return The predicted time in seconds, 0 when there is nothing to predict from
+ */
+double predictSortingTime(const TimingHistory *history, int complexity, int n);
+/**
+ * @brief Appends the row of one result to the CSV file of the batch.
+ */
+void appendResultToCsv(const BatchOptions *options, int n, const char *methodName, const BenchmarkResult *result);
+/**
+ * @brief Parses a size in bytes with an optional K, M or G suffix (e.g. 512M).
+ * @return The size in bytes, or 0 if the text is invalid or the size doesn't fit.
+ */
+unsigned long long parseByteSize(const char *text);
+/**
+ * @brief Parses a whole number written with digits only, e.g. the value of --seed.
+ * @param maximum The largest value accepted
+ * @param number Where the number is stored
+ * @return 1 on success, 0 if the text is not only digits or the number is above maximum.
+ */
+int parseWholeNumber(const char *text, unsigned long int maximum, unsigned long int *number);
 /**
- * @brief Gives the current time in seconds.
- * @returns The calculated time.
+ * @brief Parses a number that may have decimals, e.g. the value of --budget.
+ * @param minimum The smallest value accepted
+ * @param maximum The largest value accepted
+ * @param number Where the number is stored
+ * @return 1 on success, 0 if the text is not only a finite number or the number is out of range.
+ */
+int parseDecimalNumber(const char *text, double minimum, double maximum, double *number);
+
+/*
+*
+* EXTERNAL SORT
+*
 */
-double getTimeInSeconds(void);
 /**
- * @brief The callback function used in qsort()
- * @param a Pointer to the first element.
- * @param b Pointer to the second element.
- * @return A negative value if a < b, 0 if equal, a positive value if a > b.
+ * @brief Sorts a file of raw 64-bit keys that may be larger than memory. The input is read in
+ * chunks that fit the memory budget, each chunk is sorted and written as a run file, then the
+ * runs are merged with a loser tree while a background thread reads ahead in every run. Too
+ * many runs for the budget are merged in groups first.
+ * @param options The batch options with the external sort files and memory budget
+ * @return 1 on success, 0 on error
  */
-int compareByTime(const void *a, const void *b);
+int runExternalSort(const BatchOptions *options);
 /**
- * @brief Clears the terminal screen.
+ * @brief Merges sorted run files into one sorted file with a loser tree, while a background
+ * thread reads ahead in every run. Takes 2k + 1 buffers of bufferKeys keys.
+ * @param runNames The names of the k run files
+ * @param output The file the merged keys are written to, named outputName in the errors
+ * @return 1 on success, 0 on error
  */
-void clearScreen(void);
+int mergeRunFiles(char (*runNames)[512], int k, size_t bufferKeys, FILE *output, const char *outputName, const char *temporaryDirectory);
 /**
- * @brief Displays the program header.
+ * @brief Sorts EXTERNAL_SCRATCH_PROBE_KEYS random keys to measure the scratch memory the
+ * algorithm allocates per key, so that a chunk and its scratch fit the memory budget together.
+ * @return Peak scratch bytes per key, 0 for the algorithms that sort in place
  */
-void displayHeader(void);
+double measureScratchPerKey(const SortingAlgorithm *algorithm);
 /**
- * @brief Displays a confirmation message before exiting the program.
+ * @brief Rebuilds the loser tree from scratch. tree[0] is the run with the smallest key,
+ * tree[1..k-1] hold the loser of each match. Runs are the leaves k..2k-1.
  */
-void displayConfirmExit(void);
+void initializeLoserTree(int *tree, const ExternalRun *runs, int k);
 /**
- * @brief Pauses the program execution for a specified duration.
- * @param milliseconds The duration to sleep in milliseconds.
+ * @brief Replays the matches from the leaf of a run up to the root after its key changed.
  */
-void sleepProgram(int milliseconds);
+void replayLoserTree(int *tree, const ExternalRun *runs, int k, int run);
+/**
+ * @brief Asks the background thread to fill one buffer of a run.
+ */
+void requestRunBuffer(PrefetchQueue *queue, int run, int buffer);
+/**
+ * @brief The background thread of the merge phase (argument is a PrefetchQueue).
+ */
+void *prefetchWorker(void *argument);
+/**
+ * @brief Moves a run to its next key, switching buffers and waiting for the background
+ * thread when the current buffer is used up.
+ * @return 1 on success, 0 if the background thread failed to read a run
+ */
+int advanceRun(PrefetchQueue *queue, int run);
 
 /**
- * Initialize the algorithms array. This is made global as multiple functions access it.
-*/
-SortingAlgorithm algorithms[] = {
-    {"Selection Sort", "output/selection-sort.txt", 0.0, selectionSort},
-    {"Bubble Sort", "output/bubble-sort.txt", 0.0,  bubbleSort},
-    {"Insertion Sort", "output/insertion-sort.txt", 0.0, insertionSort},
-    {"Merge Sort", "output/merge-sort.txt", 0.0, mergeSort},
-    {"Quick Sort", "output/quick-sort.txt", 0.0, quickSort},
-    {"Heap Sort", "output/heap-sort.txt", 0.0, heapSort},
-};
-int algorithmsSize = sizeof(algorithms)/sizeof(algorithms[0]);
+ * @brief Displays the usage of the batch mode
+ * @param programName The name of the executable (argv[0])
+ */
+void displayBatchUsage(const char *programName);
 
-int main(void) { 
-    int isExit = 0;
-    while(!isExit) {
-        clearScreen();
-        displayHeader();
+/*
+*
+* STREAMING SORT
+*
+*/
+/**
+ * @brief Sorts the keys arriving on stdin while they are read. Batches are sorted by a
+ * background thread as they fill and kept in tiers of sorted runs merged incrementally, so
+ * that the sorted output is only a k-way merge away at any point. Reports the throughput and
+ * the latency from the end of the input to the sorted output.
+ * @param options The batch options with the input format, output file and batch size
+ * @return 1 on success, 0 on error
+ */
+int runStreamSort(const BatchOptions *options);
+/**
+ * @brief Reads keys until the array is full or the input ends (reader->isEnd).
+ * @return The number of keys read
+ */
+size_t readStreamKeys(StreamReader *reader, unsigned long int *keys, size_t capacity);
+/**
+ * @brief Waits until the background thread has taken the previous batch, then hands it the
+ * next one. The batch belongs to the sorter afterwards.
+ */
+void handOffStreamBatch(StreamSorter *sorter, unsigned long int *batch, size_t n);
+/**
+ * @brief Waits until the background thread has sorted every batch handed to it.
+ */
+void waitForStreamSorter(StreamSorter *sorter);
+/**
+ * @brief The background thread of the streaming sort (argument is a StreamSorter).
+ */
+void *streamSortWorker(void *argument);
+/**
+ * @brief Adds a sorted run to the first tier and merges every tier that fills up.
+ */
+void addStreamRun(StreamSorter *sorter, unsigned long int *keys, size_t n);
+/**
+ * @brief Merges in-memory runs into output with a loser tree initialized on them, stopping
+ * after capacity keys. Called again it carries on where it stopped.
+ * @return The number of keys written
+ */
+size_t mergeMemoryRuns(int *tree, ExternalRun *runs, int k, unsigned long int *output, size_t capacity);
+/**
+ * @brief Writes every key sorted so far with a k-way merge of all the tiers, which are left
+ * as they are. The background thread must be idle.
+ * @param filename The output file, NULL to merge without writing the keys
+ * @return 1 on success, 0 if the file could not be written
+ */
+int writeStreamSnapshot(StreamSorter *sorter, const char *filename);
 
-        // Prompt for N
-        printf("\n");
-        int numOfIntegers = (int)getPositiveInteger("Number of integers (N): ");
+/*
+*
+* RESULTS STORE
+*
+*/
+/**
+ * @brief Fills in the commit, compiler, CPU and start time the results are measured with.
+ */
+void collectRunEnvironment(RunEnvironment *environment);
+/**
+ * @brief Appends the record of one result to a results file, as a single line of JSON with
+ * the run environment, the cell and every timed run. Each record is written at once, so an
+ * aborted benchmark leaves no partial line.
+ * @param mode "batch" or "interactive"
+ * @param samples The timed runs in the order they were run, NULL if the result has none
+ */
+void appendResultRecord(const char *filename, const RunEnvironment *environment, const char *mode, int n, const char *methodName, unsigned int seed, int warmups, const BenchmarkResult *result, const double *samples, int samplesCount);
+/**
+ * @brief Appends formatted text to a growing buffer, reallocating it when full.
+ */
+void appendToBuffer(char **buffer, size_t *length, size_t *capacity, const char *format, ...);
+/**
+ * @brief Appends a string to a growing buffer as a quoted JSON string.
+ */
+void appendJsonString(char **buffer, size_t *length, size_t *capacity, const char *text);
+/**
+ * @brief Reads the records of a results file, one JSON object each. They may be spread over several
+ * lines or spaced out, e.g. by jq. Objects that are not result records are skipped.
+ * @param records Where the dynamically allocated records are stored, freed with freeResultRecords()
+ * @return The number of records, or -1 if the file can't be read
+ */
+int loadResultRecords(const char *filename, StoredResult **records);
+void freeResultRecords(StoredResult *records, int count);
+/**
+ * @brief Finds the value of a field of a JSON object, such as a record of appendResultRecord.
+ * Only the fields of the outer object are looked at, and there may be spaces around the colon.
+ * @return The first character of the value, or NULL if the object has no such field
+ */
+const char *findJsonField(const char *object, const char *name);
+/**
+ * @brief Skips a JSON string starting at its opening quote.
+ * @return The character after the closing quote, or NULL if the string doesn't end
+ */
+const char *skipJsonString(const char *value);
+/**
+ * @brief Reads a quoted JSON string, undoing the escapes of appendJsonString.
+ * @return 1 on success, 0 if the value is not a string
+ */
+int readJsonString(const char *value, char *destination, size_t size);
+/**
+ * @brief Finds the last record of a cell, the most recent measurement of it.
+ * @return Its index, or -1 if no record matches
+ */
+int findResultRecord(const StoredResult *records, int count, const StoredResult *cell);
+/**
+ * @brief One-sided Mann-Whitney U test of the candidate times being larger than the baseline
+ * times. It only assumes the runs are independent, not that their times are normally
+ * distributed. The normal approximation with tie and continuity corrections is used.
+ * @return The p-value, 1 when there are not enough runs to tell
+ */
+double mannWhitneyPValue(const double *baseline, int baselineCount, const double *candidate, int candidateCount);
+/**
+ * @brief Compares the latest record of every cell of two results files and reports the
+ * cells whose median got significantly slower.
+ * @return 1 if there is no regression, 0 otherwise or on error
+ */
+int compareResultFiles(const BatchOptions *options);
 
-        // Print data generation methods
-        char *dataGenerationMethods[] = {
-            "Random integers",
-            "Increasing Sequence"
-        };
-        int dataGenerationMethodsSize = sizeof(dataGenerationMethods)/sizeof(dataGenerationMethods[0]);
-        printf("Data Generation Method:");
-        for(int i = 0; i < dataGenerationMethodsSize; i++) {
-            printf("\n\t%d) %s", i+1, dataGenerationMethods[i]);
-        }
+/*
+*
+* INDIRECT SORT
+*
+*/
+/**
+ * @brief Sorts records by sorting a compact array of (key, index) pairs and then moving every
+ * record once to its final position, instead of moving whole records at every step.
+ * When the keys leave room for the index bits, each pair is packed into one unsigned long int
+ * (key above the index) so that any algorithm of algorithms[] sorts them. Otherwise the pairs
+ * are sorted as KeyValueRecords with the typed merge sort.
+ * @param recordType The element type of the records
+ * @param keyAlgorithm The algorithm sorting the packed pairs
+ * @param mode RECORD_SORT_GATHER or RECORD_SORT_CYCLES
+ */
+void indirectSort(void *records, int n, const ElementType *recordType, const SortingAlgorithm *keyAlgorithm, int mode);
+/**
+ * @brief Moves the records into sorted order through a new array: order[j] is the record that
+ * goes to position j. Reads are random, so the records a few positions ahead are prefetched.
+ * The sorted records are copied back at the end.
+ */
+void gatherRecords(void *records, int n, size_t size, const int *order);
+/**
+ * @brief Moves the records into sorted order in place, following each cycle of the permutation
+ * with a single record of extra memory. order[] is reset to the identity on the way.
+ */
+void permuteRecordsInPlace(void *records, int n, size_t size, int *order);
+/**
+ * @brief Checks that every record still carries the key it was generated with at its index,
+ * and that no index appears twice.
+ */
+int isRecordPermutation(const void *records, int n, size_t size, const unsigned long int *keys);
+
+/*
+*
+* HARDWARE COUNTERS
+*
+*/
+/**
+ * @brief Opens the hardware event counters of this process with perf_event_open. Events the
+ * CPU, the kernel or its perf_event_paranoid setting don't allow are left out.
+ * @return The number of events that can be counted, 0 if there are none (e.g. in most VMs or on Windows)
+ */
+int openHardwareCounters(void);
+/**
+ * @brief Resets the open counters and starts counting. Threads created afterwards are counted too.
+ */
+void startHardwareCounters(void);
+/**
+ * @brief Stops counting and adds the counted events to counters.
+ */
+void stopHardwareCounters(HardwareCounters *counters);
+/**
+ * @brief Closes the counters opened by openHardwareCounters().
+ */
+void closeHardwareCounters(void);
+/**
+ * @brief Prints a table of the hardware events per run of each result.
+ * @param results The results to print, in the order they are printed
+ * @param resultsSize The number of results
+ */
+void displayHardwareCounters(const BenchmarkResult *results, int resultsSize);
+
+/*
+*
+* OPERATION COUNTING
+*
+*/
+/**
+ * @brief Prints a table of the key operations per run of each result, next to n log2 n and n^2
+ * to compare with the expected complexity. Prints nothing when not built with -DCOUNT_OPERATIONS.
+ * @param results The results to print, in the order they are printed
+ * @param resultsSize The number of results
+ * @param n The number of sorted keys
+ */
+void displayOperationCounts(const BenchmarkResult *results, int resultsSize, int n);
+
+/*
+*
+* SCRATCH MEMORY
+*
+*/
+/**
+ * @brief Starts counting the scratch memory of a new run. Called before every timed sort,
+ * outside of the timing: when the last runs needed more than the arena holds, the arena is
+ * reallocated to that size and its pages are touched, so later runs don't call malloc or
+ * fault pages in.
+ */
+void resetScratchMemory(void);
+/**
+ * @brief Adds the counts of one run into the counts of a result.
+ */
+void addMemoryCounts(MemoryCounts *total, const MemoryCounts *run);
+/**
+ * @brief Prints a table of the scratch memory per run of each result: peak bytes (also per key),
+ * allocations, how many came from malloc and the time spent allocating.
+ * @param n The number of sorted keys
+ */
+void displayMemoryUsage(const BenchmarkResult *results, int resultsSize, int n);
+
+/**
+ * @brief Maps a whole file into memory for reading. On Windows the file is read into memory instead.
+ * @param filename The name of the file
+ * @param size Where the size of the file is stored
+ * @return The start of the file contents, or NULL on error or if the file is empty
+ */
+void *mapFile(const char *filename, size_t *size);
+/**
+ * @brief Releases memory returned by mapFile().
+ */
+void unmapFile(void *mapping, size_t size);
+/**
+ * @brief Maps memory backed by huge pages: reserved ones (MAP_HUGETLB) if there are, transparent
+ * ones (MADV_HUGEPAGE) otherwise. Warns once when neither is available. Without mmap, it is
+ * allocateCacheAligned().
+ * @return The memory, aligned on a huge page, to be released with freeHugePages(), or NULL on error.
+ */
+void *allocateHugePages(size_t size);
+/**
+ * @brief Releases memory returned by allocateHugePages() of the same size.
+ */
+void freeHugePages(void *memory, size_t size);
+/**
+ * @brief Allocates the arrays sorted by the timed runs and the scratch arena: on huge pages in the
+ * huge timing mode, cache line aligned otherwise. timingMode must not change while any is allocated.
+ */
+void *allocateTimedArray(size_t size);
+/**
+ * @brief Releases memory returned by allocateTimedArray() of the same size.
+ */
+void freeTimedArray(void *memory, size_t size);
+/**
+ * @brief Puts the caches in the state of the timing mode, right before the timer starts. In the
+ * cold mode it reads a buffer of CACHE_FLUSH_FACTOR times the last level cache, the other modes
+ * leave the freshly written data in the caches.
+ */
+void prepareCaches(void);
+/**
+ * @brief Size of the largest cache of the processor, DEFAULT_LAST_LEVEL_CACHE_SIZE if unknown.
+ */
+size_t getLastLevelCacheSize(void);
+/**
+ * @brief Clears the contents of a file.
+ * @param filename The name of the file to be cleared.
+*/
+void clearFile(const char *filename);
+/**
+ * @brief Appends a formatted string to a file.
+ * @param filename The name of the file to append to.
+ * @param format The format string (supports printf-style formatting).
+ * @param ... Additional arguments for formatting.
+ */
+void appendStringToFile(const char *filename, const char *format, ...);
+/**
+ * @brief Appends an array of unsigned long integers to a file.
+ * @param filename The name of the file to append to.
+ * @param array The array of unsigned long integers.
+ * @param n The number of elements in the array.
+ */
+void appendArrayToFile(const char *filename, unsigned long int *array, int n);
+/**
+ * @brief Creates a duplicate of an unsigned long int array.
+ * @param array The original array to be duplicated.
+ * @param n The number of elements in the array.
+ * @return A pointer to the newly allocated duplicate array.
+ */
+unsigned long int *duplicateArray(const unsigned long int *array, int n);
+/**
+ * @brief Formats an unsigned long integer in decimal, two digits at a time.
+ * @param value The value to format.
+ * @param buffer Where the digits are written, at least 20 characters. It is not null-terminated.
+ * @return The number of digits written.
+ */
+int formatUnsignedLong(unsigned long int value, char *buffer);
+/**
+ * @brief Writes the whole buffer at the end of an open file, retrying on partial writes.
+ * @return 1 on success, 0 on error.
+ */
+int writeChunk(int fileDescriptor, const char *buffer, size_t size);
+/**
+ * @brief Replaces a file with the raw keys of an array, as little-endian 64-bit integers.
+ * @param filename The name of the file to write.
+ * @param array The array of unsigned long integers.
+ * @param n The number of elements in the array.
+ */
+void writeArrayToBinaryFile(const char *filename, const unsigned long int *array, int n);
+/**
+ * @brief Replaces an output file with an array in the selected outputFormat. The text format
+ * has a title line followed by 20 comma separated keys per line. The binary format writes to
+ * the same name with a .bin extension. Nothing is written for OUTPUT_FORMAT_NONE.
+ * @param filename The name of the text output file (e.g. "output/merge-sort.txt").
+ * @param title The line written before the keys in the text format.
+ * @param array The array of unsigned long integers.
+ * @param n The number of elements in the array.
+ */
+void writeArrayOutput(const char *filename, const char *title, const unsigned long int *array, int n);
+/**
+ * @brief Checks if an array is sorted in non-decreasing order.
+ * @param array The array to check.
+ * @param n The number of elements in the array.
+ * @return 1 if sorted, 0 otherwise.
+ */
+int isArraySorted(const unsigned long int *array, int n);
+/**
+ * @brief Checks if a name matches a query, ignoring case and treating '-' as a space in both.
+ * Only the start of the name needs to match (e.g. "merge" matches "Merge Sort").
+ * @param name The name to match against (e.g. "Merge Sort").
+ * @param query The query typed by the user (e.g. "merge-sort").
+ * @return 1 if it matches, 0 otherwise.
+ */
+int matchesName(const char *name, const char *query);
+/**
+ * @brief Creates a duplicate of an array of SortingAlgorithm structures.
+ * @param array The original array of SortingAlgorithm structures.
+ * @param n The number of elements in the array.
+ * @return A pointer to the newly allocated duplicate array.
+ */
+SortingAlgorithm *duplicateAlgorithmsArray(SortingAlgorithm *array, int n);
+unsigned long int getPositiveInteger(const char *prompt);
+/**
+ * @brief Prompts until a non-negative number is entered, which may have decimals.
+ * @param prompt The message displayed before each attempt.
+ * @return The entered number.
+ */
+double getPositiveDouble(const char *prompt);
+/**
+ * @brief The callback function used in qsort()
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ * @return A negative value if a < b, 0 if equal, a positive value if a > b.
+ */
+int compareByTime(const void *a, const void *b);
+/**
+ * @brief The callback function used in qsort() to sort an array of doubles
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ * @return A negative value if a < b, 0 if equal, a positive value if a > b.
+ */
+int compareDoubles(const void *a, const void *b);
+/**
+ * @brief The callback function used in qsort() to rank BenchmarkResults by median time
+ * @param a Pointer to the first element.
+ * @param b Pointer to the second element.
+ * @return A negative value if a < b, 0 if equal, a positive value if a > b.
+ */
+int compareResultsByMedian(const void *a, const void *b);
+/**
+ * @brief Clears the terminal screen.
+ */
+void clearScreen(void);
+/**
+ * @brief Displays the program header.
+ */
+void displayHeader(void);
+/**
+ * @brief Displays a confirmation message before exiting the program.
+ */
+void displayConfirmExit(void);
+/**
+ * @brief Pauses the program execution for a specified duration.
+ * @param milliseconds The duration to sleep in milliseconds.
+ */
+void sleepProgram(int milliseconds);
+
+/**
+ * Format of the files written by runBenchmark and the batch mode (OUTPUT_FORMAT_*).
+*/
+int outputFormat = OUTPUT_FORMAT_TEXT;
+
+/**
+ * The events counted around each sort and the perf_event_open file descriptor of each, -1 if it
+ * could not be opened. hardwareCountersAvailable is the number of open descriptors.
+*/
+const char *hardwareCounterNames[HARDWARE_COUNTERS_SIZE] = {"Cycles", "Instructions", "L1D Misses", "LLC Misses", "Branch Misses", "dTLB Misses"};
+int hardwareCounterFds[HARDWARE_COUNTERS_SIZE] = {-1, -1, -1, -1, -1, -1};
+int hardwareCountersAvailable = 0;
+
+/**
+ * How the timed runs prepare their data (--timing), by TIMING_* value.
+*/
+int timingMode = TIMING_WARM;
+const char *timingModeNames[] = {"warm", "cold", "huge"};
+/**
+ * The buffer read by the cold timing mode to evict the data from the caches, allocated on first use.
+*/
+unsigned char *cacheFlushBuffer = NULL;
+/**
+ * The pipe a benchmark child marks the start and end of every sort on, so that the time budget
+ * covers the sort alone. -1 outside of measureAlgorithmWithBudget().
+*/
+int sortBoundaryFd = -1;
+size_t cacheFlushSize = 0;
+volatile unsigned char cacheFlushSink;
+
+/**
+ * Initialize the algorithms array. This is made global as multiple functions access it.
+*/
+SortingAlgorithm algorithms[] = {
+    {"Selection Sort", "output/selection-sort.txt", 0.0, selectionSort, 0, COMPLEXITY_QUADRATIC, NULL, NULL},
+    {"Bubble Sort", "output/bubble-sort.txt", 0.0, bubbleSort, 0, COMPLEXITY_QUADRATIC, NULL, NULL},
+    {"Insertion Sort", "output/insertion-sort.txt", 0.0, insertionSort, 0, COMPLEXITY_QUADRATIC, NULL, NULL},
+    {"Merge Sort", "output/merge-sort.txt", 0.0, mergeSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Bottom-Up Merge Sort", "output/bottom-up-merge-sort.txt", 0.0, bottomUpMergeSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Parallel Merge Sort", "output/parallel-merge-sort.txt", 0.0, parallelMergeSort, 1, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Quick Sort", "output/quick-sort.txt", 0.0, quickSort, 0, COMPLEXITY_QUADRATIC, NULL, NULL},
+    {"Intro Sort", "output/intro-sort.txt", 0.0, introSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"SIMD Quick Sort", "output/simd-quick-sort.txt", 0.0, simdQuickSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Parallel Quick Sort", "output/parallel-quick-sort.txt", 0.0, parallelQuickSort, 1, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Heap Sort", "output/heap-sort.txt", 0.0, heapSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"LSD Radix Sort", "output/lsd-radix-sort.txt", 0.0, lsdRadixSort, 0, COMPLEXITY_LINEAR, NULL, NULL},
+    {"MSD Radix Sort", "output/msd-radix-sort.txt", 0.0, msdRadixSort, 0, COMPLEXITY_LINEAR, NULL, NULL},
+    {"Tim Sort", "output/tim-sort.txt", 0.0, timSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Parallel Sample Sort", "output/parallel-sample-sort.txt", 0.0, parallelSampleSort, 1, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Parallel Radix Sort", "output/parallel-radix-sort.txt", 0.0, parallelLsdRadixSort, 1, COMPLEXITY_LINEAR, NULL, NULL},
+    {"Auto Sort", "output/auto-sort.txt", 0.0, autoSort, 1, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"Bottom-Up Heap Sort", "output/bottom-up-heap-sort.txt", 0.0, bottomUpHeapSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"4-ary Heap Sort", "output/4-ary-heap-sort.txt", 0.0, quaternaryHeapSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+    {"8-ary Heap Sort", "output/8-ary-heap-sort.txt", 0.0, octonaryHeapSort, 0, COMPLEXITY_N_LOG_N, NULL, NULL},
+};
+int algorithmsSize = sizeof(algorithms)/sizeof(algorithms[0]);
+
+/**
+ * The element types of the typed sorting algorithms, and those algorithms per element type.
+ * The batch mode runs them instead of algorithms[] when --types is given.
+*/
+ElementType elementTypes[] = {
+    {"u32", "32-bit unsigned integers", sizeof(uint32_t), fillU32, isSortedU32, sortKeyU32},
+    {"u64", "64-bit unsigned integers", sizeof(uint64_t), fillU64, isSortedU64, sortKeyU64},
+    {"f32", "floats", sizeof(float), fillF32, isSortedF32, sortKeyF32},
+    {"f64", "doubles", sizeof(double), fillF64, isSortedF64, sortKeyF64},
+    {"kv", "16-byte key+value records", sizeof(KeyValueRecord), fillKeyValue, isSortedKeyValue, sortKeyKeyValue},
+    {"r32", "32-byte records", sizeof(Record32), fillRecord32, isSortedRecord32, sortKeyRecord32},
+    {"r64", "64-byte records", sizeof(Record64), fillRecord64, isSortedRecord64, sortKeyRecord64},
+    {"r128", "128-byte records", sizeof(Record128), fillRecord128, isSortedRecord128, sortKeyRecord128},
+    {"r256", "256-byte records", sizeof(Record256), fillRecord256, isSortedRecord256, sortKeyRecord256},
+};
+int elementTypesSize = sizeof(elementTypes)/sizeof(elementTypes[0]);
+#define TYPED_SORTING_ALGORITHMS(Suffix, typeIndex, typeName) \
+    {"Merge Sort (" typeName ")", NULL, 0.0, NULL, 0, COMPLEXITY_N_LOG_N, &elementTypes[typeIndex], mergeSort##Suffix}, \
+    {"Intro Sort (" typeName ")", NULL, 0.0, NULL, 0, COMPLEXITY_N_LOG_N, &elementTypes[typeIndex], introSort##Suffix}, \
+    {"Heap Sort (" typeName ")", NULL, 0.0, NULL, 0, COMPLEXITY_N_LOG_N, &elementTypes[typeIndex], heapSort##Suffix}, \
+    {"LSD Radix Sort (" typeName ")", NULL, 0.0, NULL, 0, COMPLEXITY_LINEAR, &elementTypes[typeIndex], lsdRadixSort##Suffix}
+SortingAlgorithm typedAlgorithms[] = {
+    TYPED_SORTING_ALGORITHMS(U32, 0, "u32"),
+    TYPED_SORTING_ALGORITHMS(U64, 1, "u64"),
+    TYPED_SORTING_ALGORITHMS(F32, 2, "f32"),
+    TYPED_SORTING_ALGORITHMS(F64, 3, "f64"),
+    TYPED_SORTING_ALGORITHMS(KeyValue, 4, "kv"),
+    TYPED_SORTING_ALGORITHMS(Record32, 5, "r32"),
+    TYPED_SORTING_ALGORITHMS(Record64, 6, "r64"),
+    TYPED_SORTING_ALGORITHMS(Record128, 7, "r128"),
+    TYPED_SORTING_ALGORITHMS(Record256, 8, "r256"),
+};
+int typedAlgorithmsSize = sizeof(typedAlgorithms)/sizeof(typedAlgorithms[0]);
+
+/**
+ * The hardware events, key operations and scratch memory of the last interactive run of each algorithm,
+ * in the order of algorithms[].
+*/
+HardwareCounters algorithmCounters[sizeof(algorithms)/sizeof(algorithms[0])];
+OperationCounts algorithmOperations[sizeof(algorithms)/sizeof(algorithms[0])];
+MemoryCounts algorithmMemory[sizeof(algorithms)/sizeof(algorithms[0])];
+
+/**
+ * The data generation methods, in the order they appear in the menu.
+*/
+const char *dataGenerationMethods[] = {
+    "Random integers",
+    "Increasing Sequence",
+    "From file",
+    "Reversed Sequence",
+    "Nearly Sorted",
+    "Few Unique",
+    "Organ Pipe",
+    "Sawtooth",
+    "Zipf",
+    "Uniform 64-bit"
+};
+int dataGenerationMethodsSize = sizeof(dataGenerationMethods)/sizeof(dataGenerationMethods[0]);
+
+int main(int argc, char *argv[]) { 
+    sortingThreads = getProcessorCount();
+    selectSimdKernels("auto");
+    openHardwareCounters();
+
+    // Any command-line argument switches to the non-interactive batch mode
+    if (argc > 1) {
+        BatchOptions options;
+        if (!parseBatchOptions(argc, argv, &options)) {
+            displayBatchUsage(argv[0]);
+            return 1;
+        }
+        int isSuccessful = 1;
+        if (options.compareBaseline != NULL) {
+            isSuccessful = compareResultFiles(&options);
+        } else if (options.externalInput != NULL) {
+            isSuccessful = runExternalSort(&options);
+        } else if (options.streamFormat != OUTPUT_FORMAT_NONE) {
+            isSuccessful = runStreamSort(&options);
+        } else if (options.selectedRecordTypes != NULL) {
+            runRecordBenchmark(&options);
+        } else if (options.selectRatios != NULL) {
+            runSelectionBenchmark(&options);
+        } else if (options.calibrationFile != NULL) {
+            isSuccessful = runCalibration(&options);
+        } else if (options.scalingMode != 0) {
+            runScalingBenchmark(&options);
+        } else {
+            runBatchBenchmark(&options);
+        }
+        free(options.sizes);
+        free(options.methods);
+        free(options.selectedAlgorithms);
+        free(options.threads);
+        free(options.selectedElementTypes);
+        free(options.selectedRecordTypes);
+        free(options.selectRatios);
+        closeHardwareCounters();
+        return isSuccessful ? 0 : 1;
+    }
+
+    int isExit = 0;
+    while(!isExit) {
+        clearScreen();
+        displayHeader();
+
+        // Prompt for N
+        printf("\n");
+        int numOfIntegers = (int)getPositiveInteger("Number of integers (N): ");
+
+        // Print data generation methods
+        printf("Data Generation Method:");
+        for(int i = 0; i < dataGenerationMethodsSize; i++) {
+            printf("\n\t%d) %s", i+1, dataGenerationMethods[i]);
+        }
 
         // Get data generation method
         int selectedGenerationMethod = 0;
@@ -171,48 +1371,96 @@ int main(void) {
         scanf("%d", &selectedGenerationMethod);
 
         unsigned long int *unsortedArr;
-        unsigned long int startingValue = 0;
         char *unsortedArrayOutputFile = "output/unsorted.txt";
-
-        // After every run, clear the unsorted output file
-        clearFile(unsortedArrayOutputFile);
-        appendStringToFile(unsortedArrayOutputFile, "\nUnsorted Array | Number of elements (N): %d\n", numOfIntegers);
+        char unsortedArrayTitle[256];
+        char inputFile[512] = "";
+        char methodName[640];
+        Dataset dataset;
+        // The seed is shown with the results so that the data can be generated again in batch mode
+        GenerationParameters generation = {(unsigned int)time(NULL), 0, 1.0, 16, 16, 1.0};
 
         switch (selectedGenerationMethod) {
-            case 1:
+            case METHOD_RANDOM:
+            case METHOD_INCREASING:
+            case METHOD_REVERSED:
+            case METHOD_NEARLY_SORTED:
+            case METHOD_FEW_UNIQUE:
+            case METHOD_ORGAN_PIPE:
+            case METHOD_SAWTOOTH:
+            case METHOD_ZIPF:
+            case METHOD_UNIFORM_64:
+                // Ask for the settings of the chosen method
+                if (selectedGenerationMethod == METHOD_INCREASING || selectedGenerationMethod == METHOD_REVERSED ||
+                    selectedGenerationMethod == METHOD_NEARLY_SORTED || selectedGenerationMethod == METHOD_ORGAN_PIPE ||
+                    selectedGenerationMethod == METHOD_SAWTOOTH) {
+                    generation.startingValue = getPositiveInteger("What is the starting value? (X): ");
+                }
+                if (selectedGenerationMethod == METHOD_NEARLY_SORTED) {
+                    generation.swapPercent = getPositiveDouble("Percentage of N to swap (k): ");
+                }
+                if (selectedGenerationMethod == METHOD_FEW_UNIQUE) {
+                    generation.uniqueKeys = (int)getPositiveInteger("Number of unique keys: ");
+                    if (generation.uniqueKeys < 1) generation.uniqueKeys = 1;
+                }
+                if (selectedGenerationMethod == METHOD_SAWTOOTH) {
+                    generation.sawtoothRuns = (int)getPositiveInteger("Number of increasing runs: ");
+                    if (generation.sawtoothRuns < 1) generation.sawtoothRuns = 1;
+                }
+                if (selectedGenerationMethod == METHOD_ZIPF) {
+                    generation.zipfExponent = getPositiveDouble("Zipf exponent (s), e.g. 1.0: ");
+                    if (generation.zipfExponent <= 0.0) generation.zipfExponent = 1.0;
+                }
+
                 // Clear the terminal as data about the current algorithm will be displayed
                 clearScreen();
                 displayHeader();
 
                 // Generate the data
                 printf("\nGenerating data...");
-                unsortedArr = generateRandomIntegers(numOfIntegers);
+                unsortedArr = generateData(selectedGenerationMethod, numOfIntegers, &generation);
+                if (unsortedArr == NULL) {
+                    printf("\nMemory allocation failed");
+                    sleepProgram(3500);
+                    break;
+                }
 
                 // Output the data to a file
-                appendArrayToFile(unsortedArrayOutputFile, unsortedArr, numOfIntegers);
+                snprintf(unsortedArrayTitle, sizeof(unsortedArrayTitle), "\nUnsorted Array | Number of elements (N): %d\n", numOfIntegers);
+                writeArrayOutput(unsortedArrayOutputFile, unsortedArrayTitle, unsortedArr, numOfIntegers);
 
                 // Run benchmarks on the data
-                runBenchmark(unsortedArr, numOfIntegers);
+                describeGenerationMethod(selectedGenerationMethod, &generation, methodName, sizeof(methodName));
+                runBenchmark(unsortedArr, numOfIntegers, methodName, generation.seed);
                 free(unsortedArr);
                 break;
-            case 2:
-                // Verify that the starting value (X) is a positive integer
-                startingValue = getPositiveInteger("What is the starting value? (X): ");
+            case METHOD_FILE:
+                printf("Path of the data file: ");
+                scanf("%511s", inputFile);
 
                 // Clear the terminal as data about the current algorithm will be displayed
                 clearScreen();
                 displayHeader();
 
-                // Generate the data
-                printf("\nGenerating data...");
-                unsortedArr = generateIncreasingSequence(numOfIntegers, startingValue);
+                // Load the data, before the unsorted output file is overwritten in case it is the input
+                printf("\nLoading data...");
+                if (!loadDataset(inputFile, &dataset)) {
+                    sleepProgram(3500);
+                    break;
+                }
+
+                // Use the first N keys, or all of them if N is 0 or larger than the file
+                if (numOfIntegers <= 0 || numOfIntegers > dataset.n) {
+                    numOfIntegers = dataset.n;
+                }
 
                 // Output the data to a file
-                appendArrayToFile(unsortedArrayOutputFile, unsortedArr, numOfIntegers);
+                snprintf(unsortedArrayTitle, sizeof(unsortedArrayTitle), "\nUnsorted Array | Number of elements (N): %d\n", numOfIntegers);
+                writeArrayOutput(unsortedArrayOutputFile, unsortedArrayTitle, dataset.keys, numOfIntegers);
 
                 // Run benchmarks on the data
-                runBenchmark(unsortedArr, numOfIntegers);
-                free(unsortedArr);
+                snprintf(methodName, sizeof(methodName), "%s (%s)", dataGenerationMethods[METHOD_FILE - 1], inputFile);
+                runBenchmark(dataset.keys, numOfIntegers, methodName, 0);
+                freeDataset(&dataset);
                 break;
             default:
                 break;
@@ -228,14 +1476,10 @@ int main(void) {
 
         // Data generation information
         printf("\nNumber of Elements (N): %d", numOfIntegers);
-        printf("\nGeneration Method: ");
-        if (selectedGenerationMethod == 1) {
-            printf("Random Integers");
-        } else if (selectedGenerationMethod == 2) {
-            printf("Increasing Sequence");
-        }
-        if (selectedGenerationMethod == 2) {
-            printf("\nStarting Value (X): %lu", startingValue);
+        if (selectedGenerationMethod >= 1 && selectedGenerationMethod <= dataGenerationMethodsSize) {
+            displayGenerationMethod(selectedGenerationMethod, &generation, inputFile);
+        } else {
+            printf("\nGeneration Method: ");
         }
         
         // Algorithm benchamrks
@@ -245,301 +1489,4252 @@ int main(void) {
         for(int i = 0; i < algorithmsSize; i++) {
             printf("\n|%5d | %20s | %14.9lf|", i+1, algorithmsCopy[i].name, algorithmsCopy[i].time);
         }
-        printf("\n-----------------------------------------------");
+        printf("\n-----------------------------------------------\n");
+
+        // Hardware events, key operations and scratch memory of each algorithm, in the order of the menu
+        BenchmarkResult counterResults[sizeof(algorithms)/sizeof(algorithms[0])];
+        for (int i = 0; i < algorithmsSize; i++) {
+            counterResults[i].algorithm = &algorithms[i];
+            counterResults[i].threads = algorithms[i].isParallel ? sortingThreads : 0;
+            counterResults[i].stats.samples = 1;
+            counterResults[i].status = RESULT_COMPLETED;
+            counterResults[i].counters = algorithmCounters[i];
+            counterResults[i].operations = algorithmOperations[i];
+            counterResults[i].memory = algorithmMemory[i];
+        }
+        displayHardwareCounters(counterResults, algorithmsSize);
+        displayOperationCounts(counterResults, algorithmsSize, numOfIntegers);
+        displayMemoryUsage(counterResults, algorithmsSize, numOfIntegers);
+
+        displayConfirmExit();
+        free(algorithmsCopy);
+    }
+    closeHardwareCounters();
+    return 0;
+}
+
+/*
+*
+* DATA GENERATION METHODS
+*
+*/
+unsigned long int *generateData(int method, int n, const GenerationParameters *parameters) {
+    unsigned long int *array = (unsigned long int *)malloc((n > 0 ? n : 1) * sizeof(unsigned long int));
+    if (array == NULL) {
+        return NULL;
+    }
+
+    // The distinct keys of the few unique data come from a stream of their own
+    unsigned long int *uniqueKeys = NULL;
+    if (method == METHOD_FEW_UNIQUE) {
+        uniqueKeys = (unsigned long int *)malloc(parameters->uniqueKeys * sizeof(unsigned long int));
+        if (uniqueKeys == NULL) {
+            free(array);
+            return NULL;
+        }
+        RandomGenerator generator;
+        seedRandomGenerator(&generator, parameters->seed, UINT64_MAX);
+        for (int i = 0; i < parameters->uniqueKeys; i++) {
+            uniqueKeys[i] = (unsigned long int)nextRandom(&generator);
+        }
+    }
+    ZipfSampler zipf;
+    if (method == METHOD_ZIPF) {
+        initializeZipfSampler(&zipf, n > 0 ? n : 1, parameters->zipfExponent);
+    }
+
+    int blocks = (int)(((long)n + GENERATION_BLOCK_SIZE - 1) / GENERATION_BLOCK_SIZE);
+    int threads = sortingThreads < blocks ? sortingThreads : blocks;
+    if (threads < 1) {
+        threads = 1;
+    }
+    pthread_t *workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    GenerationTask *tasks = (GenerationTask *)malloc(threads * sizeof(GenerationTask));
+    if (workers == NULL || tasks == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < threads; i++) {
+        GenerationTask task = {array, n, method, parameters, uniqueKeys, &zipf, threads, i};
+        tasks[i] = task;
+    }
+
+    // The calling thread works as thread 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, generationWorker, &tasks[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    generationWorker(&tasks[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    free(tasks);
+    free(uniqueKeys);
+
+    // Nearly sorted: swap random pairs of keys of the increasing sequence. The swaps depend
+    // on each other, so they are done by one thread from a stream of their own.
+    if (method == METHOD_NEARLY_SORTED && n > 1) {
+        RandomGenerator generator;
+        seedRandomGenerator(&generator, parameters->seed, UINT64_MAX - 1);
+        long long swaps = (long long)(parameters->swapPercent / 100.0 * n);
+        for (long long i = 0; i < swaps; i++) {
+            int a = (int)(nextRandom(&generator) % (uint64_t)n);
+            int b = (int)(nextRandom(&generator) % (uint64_t)n);
+            unsigned long int temp = array[a];
+            array[a] = array[b];
+            array[b] = temp;
+        }
+    }
+    return array;
+}
+void *generationWorker(void *argument) {
+    GenerationTask *task = (GenerationTask *)argument;
+    int blocks = (int)(((long)task->n + GENERATION_BLOCK_SIZE - 1) / GENERATION_BLOCK_SIZE);
+    for (int block = task->id; block < blocks; block += task->threads) {
+        generateBlock(task, block);
+    }
+    return NULL;
+}
+void generateBlock(const GenerationTask *task, int block) {
+    const GenerationParameters *parameters = task->parameters;
+    unsigned long int *array = task->array;
+    int n = task->n;
+    int start = block * GENERATION_BLOCK_SIZE;
+    int end = n - start > GENERATION_BLOCK_SIZE ? start + GENERATION_BLOCK_SIZE : n;
+    unsigned long int startingValue = parameters->startingValue;
+
+    RandomGenerator generator;
+    seedRandomGenerator(&generator, parameters->seed, (uint64_t)block);
+
+    switch (task->method) {
+        case METHOD_RANDOM:
+            // Keys of up to 32 bits, the same range as the original rand() based generator
+            for (int i = start; i < end; i++) {
+                array[i] = (unsigned long int)(nextRandom(&generator) >> 32);
+            }
+            break;
+        case METHOD_INCREASING:
+        case METHOD_NEARLY_SORTED:
+            for (int i = start; i < end; i++) {
+                array[i] = startingValue + (unsigned long int)i;
+            }
+            break;
+        case METHOD_REVERSED:
+            for (int i = start; i < end; i++) {
+                array[i] = startingValue + (unsigned long int)(n - 1 - i);
+            }
+            break;
+        case METHOD_FEW_UNIQUE:
+            for (int i = start; i < end; i++) {
+                array[i] = task->uniqueKeys[nextRandom(&generator) % (uint64_t)parameters->uniqueKeys];
+            }
+            break;
+        case METHOD_ORGAN_PIPE:
+            // Increasing up to the middle, then decreasing
+            for (int i = start; i < end; i++) {
+                array[i] = startingValue + (unsigned long int)(i < n - 1 - i ? i : n - 1 - i);
+            }
+            break;
+        case METHOD_SAWTOOTH: {
+            int runLength = (int)(((long)n + parameters->sawtoothRuns - 1) / parameters->sawtoothRuns);
+            for (int i = start; i < end; i++) {
+                array[i] = startingValue + (unsigned long int)(i % runLength);
+            }
+            break;
+        }
+        case METHOD_ZIPF:
+            // The ranks are scrambled so the frequent keys are spread over the whole key range
+            for (int i = start; i < end; i++) {
+                array[i] = (unsigned long int)scrambleKey((uint64_t)sampleZipf(task->zipf, &generator));
+            }
+            break;
+        case METHOD_UNIFORM_64:
+            // Every bit of the key is random (64 bits on Linux, 32 on Windows)
+            for (int i = start; i < end; i++) {
+                array[i] = (unsigned long int)nextRandom(&generator);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// log(1 + x) / x and (exp(x) - 1) / x, with their series near 0 where the division loses precision
+static inline double zipfHelper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+static inline double zipfHelper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+// The hat function h(x) = 1 / x^s, its integral H and the inverse of H
+static inline double zipfH(double x, double exponent) {
+    return exp(-exponent * log(x));
+}
+static inline double zipfHIntegral(double x, double exponent) {
+    double logX = log(x);
+    return zipfHelper2((1.0 - exponent) * logX) * logX;
+}
+static inline double zipfHIntegralInverse(double x, double exponent) {
+    double t = x * (1.0 - exponent);
+    if (t < -1.0) {
+        t = -1.0;
+    }
+    return exp(zipfHelper1(t) * x);
+}
+void initializeZipfSampler(ZipfSampler *sampler, int n, double exponent) {
+    sampler->n = n;
+    sampler->exponent = exponent;
+    sampler->hIntegralX1 = zipfHIntegral(1.5, exponent) - 1.0;
+    sampler->hIntegralN = zipfHIntegral(n + 0.5, exponent);
+    sampler->threshold = 2.0 - zipfHIntegralInverse(zipfHIntegral(2.5, exponent) - zipfH(2.0, exponent), exponent);
+}
+int sampleZipf(const ZipfSampler *sampler, RandomGenerator *generator) {
+    while (1) {
+        // Invert the integral of the hat function at a uniform point, then accept or retry
+        double u = sampler->hIntegralN + nextRandomDouble(generator) * (sampler->hIntegralX1 - sampler->hIntegralN);
+        double x = zipfHIntegralInverse(u, sampler->exponent);
+        int rank = (int)(x + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        } else if (rank > sampler->n) {
+            rank = sampler->n;
+        }
+        if (rank - x <= sampler->threshold || u >= zipfHIntegral(rank + 0.5, sampler->exponent) - zipfH(rank, sampler->exponent)) {
+            return rank;
+        }
+    }
+}
+void displayGenerationMethod(int method, const GenerationParameters *parameters, const char *inputFile) {
+    char methodName[128];
+    describeGenerationMethod(method, parameters, methodName, sizeof(methodName));
+    printf("\nGeneration Method: %s", methodName);
+
+    switch (method) {
+        case METHOD_RANDOM:
+        case METHOD_FEW_UNIQUE:
+        case METHOD_ZIPF:
+        case METHOD_UNIFORM_64:
+            printf("\nSeed: %u", parameters->seed);
+            break;
+        case METHOD_NEARLY_SORTED:
+            printf("\nSeed: %u", parameters->seed);
+            printf("\nStarting Value (X): %lu", parameters->startingValue);
+            break;
+        case METHOD_INCREASING:
+        case METHOD_REVERSED:
+        case METHOD_ORGAN_PIPE:
+        case METHOD_SAWTOOTH:
+            printf("\nStarting Value (X): %lu", parameters->startingValue);
+            break;
+        case METHOD_FILE:
+            printf("\nData File: %s", inputFile);
+            break;
+        default:
+            break;
+    }
+}
+void describeGenerationMethod(int method, const GenerationParameters *parameters, char *buffer, size_t size) {
+    const char *name = dataGenerationMethods[method - 1];
+    switch (method) {
+        case METHOD_NEARLY_SORTED:
+            snprintf(buffer, size, "%s (%g%% swaps)", name, parameters->swapPercent);
+            break;
+        case METHOD_FEW_UNIQUE:
+            snprintf(buffer, size, "%s (%d keys)", name, parameters->uniqueKeys);
+            break;
+        case METHOD_SAWTOOTH:
+            snprintf(buffer, size, "%s (%d runs)", name, parameters->sawtoothRuns);
+            break;
+        case METHOD_ZIPF:
+            snprintf(buffer, size, "%s (s = %g)", name, parameters->zipfExponent);
+            break;
+        default:
+            snprintf(buffer, size, "%s", name);
+            break;
+    }
+}
+int loadDataset(const char *filename, Dataset *dataset) {
+    dataset->keys = NULL;
+    dataset->n = 0;
+    dataset->ownsKeys = 0;
+    dataset->mapping = mapFile(filename, &dataset->mappingSize);
+    if (dataset->mapping == NULL) {
+        // mapFile() fails on empty files too, they are readable but have no keys
+        FILE *file = fopen(filename, "rb");
+        int isEmpty = file != NULL && fgetc(file) == EOF && !ferror(file);
+        if (file != NULL) fclose(file);
+        if (isEmpty) {
+            fprintf(stderr, "The file is empty, no keys to sort: %s\n", filename);
+        } else {
+            fprintf(stderr, "Error opening file: %s\n", filename);
+        }
+        return 0;
+    }
+
+    const char *extension = strrchr(filename, '.');
+    if (extension != NULL && strcmp(extension, ".bin") == 0) {
+        size_t count = dataset->mappingSize / 8;
+        if (count > INT_MAX || dataset->mappingSize % 8 != 0) {
+            fprintf(stderr, "Not a file of 64-bit keys, or too many keys: %s\n", filename);
+            freeDataset(dataset);
+            return 0;
+        }
+        dataset->n = (int)count;
+
+        // On little-endian 64-bit keys the file already has the array layout, no parse step needed
+        const uint16_t endianTest = 1;
+        if (sizeof(unsigned long int) == 8 && *(const unsigned char *)&endianTest == 1) {
+            dataset->keys = (unsigned long int *)dataset->mapping;
+            return 1;
+        }
+
+        // Otherwise convert the keys into an array of their own
+        dataset->keys = (unsigned long int *)malloc(count * sizeof(unsigned long int));
+        if (dataset->keys == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            freeDataset(dataset);
+            return 0;
+        }
+        dataset->ownsKeys = 1;
+        const unsigned char *bytes = (const unsigned char *)dataset->mapping;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t key = 0;
+            for (int byte = 7; byte >= 0; byte--) {
+                key = (key << 8) | bytes[i * 8 + byte];
+            }
+            dataset->keys[i] = (unsigned long int)key;
+        }
+    } else if (!parseTextDataset((const char *)dataset->mapping, dataset->mappingSize, filename, dataset)) {
+        freeDataset(dataset);
+        return 0;
+    }
+
+    // Parsed or converted keys don't need the file anymore
+    unmapFile(dataset->mapping, dataset->mappingSize);
+    dataset->mapping = NULL;
+    return 1;
+}
+int parseTextDataset(const char *text, size_t size, const char *filename, Dataset *dataset) {
+    const char *end = text + size;
+
+    // First pass: count the keys on the lines that start with a digit
+    size_t count = 0;
+    for (const char *line = text; line < end; ) {
+        const char *lineEnd = memchr(line, '\n', end - line);
+        if (lineEnd == NULL) lineEnd = end;
+        if (isdigit((unsigned char)*line)) {
+            int inKey = 0;
+            for (const char *c = line; c < lineEnd; c++) {
+                int isDigit = *c >= '0' && *c <= '9';
+                count += isDigit && !inKey;
+                inKey = isDigit;
+            }
+        }
+        line = lineEnd + 1;
+    }
+    if (count == 0 || count > INT_MAX) {
+        fprintf(stderr, "No keys found in: %s\n", filename);
+        return 0;
+    }
+
+    dataset->keys = (unsigned long int *)malloc(count * sizeof(unsigned long int));
+    if (dataset->keys == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 0;
+    }
+    dataset->ownsKeys = 1;
+
+    // Second pass: parse the keys straight into the array
+    int n = 0;
+    size_t lineNumber = 1;
+    for (const char *line = text; line < end; lineNumber++) {
+        const char *lineEnd = memchr(line, '\n', end - line);
+        if (lineEnd == NULL) lineEnd = end;
+        if (isdigit((unsigned char)*line)) {
+            const char *c = line;
+            while (c < lineEnd) {
+                if (*c < '0' || *c > '9') {
+                    c++;
+                    continue;
+                }
+                unsigned long int key = 0;
+                while (c < lineEnd && *c >= '0' && *c <= '9') {
+                    unsigned long int digit = (unsigned long int)(*c - '0');
+                    if (key > (ULONG_MAX - digit) / 10) {
+                        fprintf(stderr, "Key larger than %lu on line %zu of: %s\n", ULONG_MAX, lineNumber, filename);
+                        return 0;
+                    }
+                    key = key * 10 + digit;
+                    c++;
+                }
+                dataset->keys[n++] = key;
+            }
+        }
+        line = lineEnd + 1;
+    }
+    dataset->n = n;
+    return 1;
+}
+void freeDataset(Dataset *dataset) {
+    if (dataset->ownsKeys) {
+        free(dataset->keys);
+    }
+    if (dataset->mapping != NULL) {
+        unmapFile(dataset->mapping, dataset->mappingSize);
+    }
+    dataset->keys = NULL;
+    dataset->n = 0;
+    dataset->mapping = NULL;
+    dataset->ownsKeys = 0;
+}
+
+void runBenchmark(unsigned long int *array, int n, const char *methodName, unsigned int seed) {
+    // The benchmarks results are also recorded in results.jsonl
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+
+    printf("\nRunning benchmarks...");
+    for(int i = 0; i < algorithmsSize; i++) {
+        // Duplicate the data for each sorting algorithm
+        unsigned long int *arrayCopy = duplicateArray(array, n);
+
+        printf("\n[%s] Sorting in progress...", algorithms[i].name);
+
+        // Start the timer and the hardware counters
+        memset(&algorithmCounters[i], 0, sizeof(HardwareCounters));
+        resetOperationCounts();
+        resetScratchMemory();
+        startHardwareCounters();
+        double startTime = getTimeInSeconds();
+        // Run the sorting algorithm
+        algorithms[i].function(arrayCopy, n);
+        // End the timer
+        double endTime = getTimeInSeconds();
+        stopHardwareCounters(&algorithmCounters[i]);
+        algorithmOperations[i] = collectOperationCounts();
+        algorithmMemory[i] = collectMemoryCounts();
+
+        // Calculate the elapsed time
+        algorithms[i].time = endTime - startTime;
+
+        printf("\n[%s] Sorting finished!", algorithms[i].name);
+        printf("\n[%s] Time taken: %.9lfsecs", algorithms[i].name, algorithms[i].time);
+
+        // Clear and output the sorted data into a file per algorithm
+        char title[256];
+        snprintf(title, sizeof(title), "\n%s Sorted Array | Number of elements (N): %d | Time take: %.9lf\n\n", algorithms[i].name, n, algorithms[i].time);
+        writeArrayOutput(algorithms[i].outputFile, title, arrayCopy, n);
+
+        // Append the elapsed time to results.jsonl
+        BenchmarkResult result;
+        memset(&result, 0, sizeof(result));
+        result.algorithm = &algorithms[i];
+        result.threads = algorithms[i].isParallel ? sortingThreads : 0;
+        result.status = RESULT_COMPLETED;
+        result.counters = algorithmCounters[i];
+        result.operations = algorithmOperations[i];
+        result.memory = algorithmMemory[i];
+        double sample = algorithms[i].time;
+        result.stats = computeBenchmarkStats(&sample, 1);
+        appendResultRecord("results.jsonl", &environment, "interactive", n, methodName, seed, 0, &result, &algorithms[i].time, 1);
+
+        free(arrayCopy);
+    }
+
+    printf("\nBenchmarks complete!");
+    sleepProgram(3500);
+}
+double timeSortingAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, unsigned long int **sortedArray, BenchmarkResult *result) {
+    if (algorithm->elementType != NULL) {
+        return timeTypedSortingAlgorithm(algorithm, array, n, sortedArray, result);
+    }
+
+    // Sort a copy so that every run receives the same unsorted data
+    size_t arraySize = (n > 0 ? (size_t)n : 1) * sizeof(unsigned long int);
+    unsigned long int *arrayCopy = (unsigned long int *)allocateTimedArray(arraySize);
+    if (arrayCopy == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(arrayCopy, array, (size_t)n * sizeof(unsigned long int));
+
+    // The counters only run around the sort itself, not the copy or the check
+    resetOperationCounts();
+    resetScratchMemory();
+    prepareCaches();
+    if (result != NULL) {
+        startHardwareCounters();
+    }
+    reportSortBoundary();
+    double startTime = getTimeInSeconds();
+    algorithm->function(arrayCopy, n);
+    double endTime = getTimeInSeconds();
+    reportSortBoundary();
+    if (result != NULL) {
+        stopHardwareCounters(&result->counters);
+        OperationCounts operations = collectOperationCounts();
+        result->operations.comparisons += operations.comparisons;
+        result->operations.swaps += operations.swaps;
+        result->operations.moves += operations.moves;
+        MemoryCounts memory = collectMemoryCounts();
+        addMemoryCounts(&result->memory, &memory);
+    }
+
+    // A wrong result makes the timing meaningless, so stop the batch right away
+    if (!isArraySorted(arrayCopy, n)) {
+        fprintf(stderr, "\n[%s] Output is not sorted (N: %d)\n", algorithm->name, n);
+        exit(EXIT_FAILURE);
+    }
+
+    if (sortedArray != NULL) {
+        *sortedArray = arrayCopy;
+    } else {
+        freeTimedArray(arrayCopy, arraySize);
+    }
+    return endTime - startTime;
+}
+void reportSortBoundary(void) {
+    if (sortBoundaryFd != -1) {
+        writeChunk(sortBoundaryFd, "|", 1);
+    }
+}
+double timeTypedSortingAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, unsigned long int **sortedArray, BenchmarkResult *result) {
+    // Convert the keys into a fresh array of the element type, so that every run receives the same unsorted data
+    const ElementType *elementType = algorithm->elementType;
+    size_t elementsSize = (n > 0 ? (size_t)n : 1) * elementType->size;
+    void *elements = allocateTimedArray(elementsSize);
+    if (elements == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    elementType->fill(elements, array, n);
+
+    resetOperationCounts();
+    resetScratchMemory();
+    prepareCaches();
+    if (result != NULL) {
+        startHardwareCounters();
+    }
+    reportSortBoundary();
+    double startTime = getTimeInSeconds();
+    algorithm->typedFunction(elements, n);
+    double endTime = getTimeInSeconds();
+    reportSortBoundary();
+    if (result != NULL) {
+        stopHardwareCounters(&result->counters);
+        OperationCounts operations = collectOperationCounts();
+        result->operations.comparisons += operations.comparisons;
+        result->operations.swaps += operations.swaps;
+        result->operations.moves += operations.moves;
+        MemoryCounts memory = collectMemoryCounts();
+        addMemoryCounts(&result->memory, &memory);
+    }
+
+    if (!elementType->isSorted(elements, n)) {
+        fprintf(stderr, "\n[%s] Output is not sorted (N: %d)\n", algorithm->name, n);
+        exit(EXIT_FAILURE);
+    }
+
+    // The output files hold unsigned long int keys, there is no sorted copy to write
+    if (sortedArray != NULL) {
+        *sortedArray = NULL;
+    }
+    freeTimedArray(elements, elementsSize);
+    return endTime - startTime;
+}
+BenchmarkStats computeBenchmarkStats(double *samples, int count) {
+    BenchmarkStats stats = {0.0, 0.0, 0.0, 0.0, count};
+    if (count <= 0) {
+        return stats;
+    }
+
+    // Sorting the samples gives the min and median directly
+    qsort(samples, count, sizeof(double), compareDoubles);
+    stats.min = samples[0];
+    if (count % 2 == 1) {
+        stats.median = samples[count / 2];
+    } else {
+        stats.median = (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    stats.mean = sum / count;
+
+    // Sample standard deviation (n - 1), 0 when there is only one sample
+    if (count > 1) {
+        double squaredDifferences = 0.0;
+        for (int i = 0; i < count; i++) {
+            squaredDifferences += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+        }
+        stats.stddev = sqrt(squaredDifferences / (count - 1));
+    }
+    return stats;
+}
+
+/*
+*
+* BATCH MODE
+*
+*/
+int parseBatchOptions(int argc, char *argv[], BatchOptions *options) {
+    // Defaults: one random run of every algorithm at N = 1000
+    options->sizes = NULL;
+    options->sizesCount = 0;
+    options->methods = NULL;
+    options->methodsCount = 0;
+    options->selectedAlgorithms = malloc(algorithmsSize * sizeof(int));
+    options->threads = NULL;
+    options->threadsCount = 0;
+    options->generation.seed = (unsigned int)time(NULL);
+    options->generation.startingValue = 0;
+    options->generation.swapPercent = 1.0;
+    options->generation.uniqueKeys = 16;
+    options->generation.sawtoothRuns = 16;
+    options->generation.zipfExponent = 1.0;
+    options->repetitions = 5;
+    options->warmups = 1;
+    options->csvFile = NULL;
+    options->outputFormat = OUTPUT_FORMAT_NONE;
+    options->inputFile = NULL;
+    options->externalInput = NULL;
+    options->externalOutput = "output/external-sorted.bin";
+    options->temporaryDirectory = ".";
+    options->memoryBudget = 1ULL << 30;
+    options->timeBudget = 0.0;
+    options->selectedElementTypes = NULL;
+    options->selectedRecordTypes = NULL;
+    options->resultsFile = "results.jsonl";
+    options->compareBaseline = NULL;
+    options->compareCandidate = NULL;
+    options->regressionThreshold = 5.0;
+    options->significanceLevel = 0.05;
+    options->scalingMode = 0;
+    options->calibrationFile = NULL;
+    options->selectRatios = NULL;
+    options->selectRatiosCount = 0;
+    options->streamFormat = OUTPUT_FORMAT_NONE;
+    options->streamOutput = "output/stream-sorted.bin";
+    options->streamBatchSize = 8ULL << 20;
+    options->streamSnapshotSize = 0;
+    if (options->selectedAlgorithms == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 0;
+    }
+    for (int i = 0; i < algorithmsSize; i++) {
+        options->selectedAlgorithms[i] = 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        const char *option = argv[i];
+        if (strcmp(option, "--help") == 0 || strcmp(option, "-h") == 0) {
+            return 0;
+        }
+
+        // Every other option expects a value
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", option);
+            return 0;
+        }
+        const char *value = argv[++i];
+
+        if (strcmp(option, "--sizes") == 0 || strcmp(option, "-n") == 0) {
+            free(options->sizes);
+            options->sizes = parseSizesList(value, &options->sizesCount);
+            if (options->sizes == NULL) {
+                fprintf(stderr, "Invalid list of N: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--methods") == 0 || strcmp(option, "-m") == 0) {
+            free(options->methods);
+            options->methods = malloc(dataGenerationMethodsSize * sizeof(int));
+            options->methodsCount = 0;
+            if (options->methods == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return 0;
+            }
+
+            // Methods are given by number (as in the menu) or by name
+            char *list = malloc(strlen(value) + 1);
+            strcpy(list, value);
+            for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                // Only all-digit items are numbers, the others are names
+                unsigned long int number = 0;
+                int isNumber = strspn(item, "0123456789") == strlen(item);
+                int method = isNumber && parseWholeNumber(item, INT_MAX, &number) ? (int)number : 0;
+                for (int j = 0; !isNumber && method == 0 && j < dataGenerationMethodsSize; j++) {
+                    if (matchesName(dataGenerationMethods[j], item)) {
+                        method = j + 1;
+                    }
+                }
+                if (method < 1 || method > dataGenerationMethodsSize) {
+                    fprintf(stderr, "Unknown data generation method: %s\n", item);
+                    free(list);
+                    return 0;
+                }
+                if (options->methodsCount < dataGenerationMethodsSize) {
+                    options->methods[options->methodsCount++] = method;
+                }
+            }
+            free(list);
+        } else if (strcmp(option, "--algorithms") == 0 || strcmp(option, "-a") == 0) {
+            for (int j = 0; j < algorithmsSize; j++) {
+                options->selectedAlgorithms[j] = 0;
+            }
+
+            // Algorithms are given by number (as in algorithms[]) or by name
+            char *list = malloc(strlen(value) + 1);
+            strcpy(list, value);
+            for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                // Only all-digit items are numbers, names may contain digits too
+                unsigned long int number = 0;
+                int index = parseWholeNumber(item, INT_MAX, &number) ? (int)number : 0;
+                int found = 0;
+                if (index >= 1 && index <= algorithmsSize) {
+                    options->selectedAlgorithms[index - 1] = 1;
+                    found = 1;
+                }
+                for (int j = 0; index == 0 && j < algorithmsSize; j++) {
+                    if (matchesName(algorithms[j].name, item)) {
+                        options->selectedAlgorithms[j] = 1;
+                        found = 1;
+                    }
+                }
+                if (!found) {
+                    fprintf(stderr, "Unknown algorithm: %s\n", item);
+                    free(list);
+                    return 0;
+                }
+            }
+            free(list);
+        } else if (strcmp(option, "--threads") == 0 || strcmp(option, "-t") == 0) {
+            // Same syntax as the N values, e.g. 1:32 sweeps every thread count up to 32
+            free(options->threads);
+            options->threads = parseSizesList(value, &options->threadsCount);
+            if (options->threads == NULL) {
+                fprintf(stderr, "Invalid list of thread counts: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--simd") == 0) {
+            if (!selectSimdKernels(value)) {
+                fprintf(stderr, "SIMD level not supported: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--seed") == 0 || strcmp(option, "-s") == 0) {
+            unsigned long int seed;
+            if (!parseWholeNumber(value, UINT_MAX, &seed)) {
+                fprintf(stderr, "The seed is a number from 0 to %u: %s\n", UINT_MAX, value);
+                return 0;
+            }
+            options->generation.seed = (unsigned int)seed;
+        } else if (strcmp(option, "--start") == 0 || strcmp(option, "-x") == 0) {
+            if (!parseWholeNumber(value, ULONG_MAX, &options->generation.startingValue)) {
+                fprintf(stderr, "The starting value is a number from 0 to %lu: %s\n", ULONG_MAX, value);
+                return 0;
+            }
+        } else if (strcmp(option, "--swaps") == 0) {
+            // More than 100% swaps the keys more than once, up to INT_MAX times N keeps the count in a long long
+            if (!parseDecimalNumber(value, 0.0, 100.0 * INT_MAX, &options->generation.swapPercent)) {
+                fprintf(stderr, "The percentage of swaps is a number from 0 to %.0lf: %s\n", 100.0 * INT_MAX, value);
+                return 0;
+            }
+        } else if (strcmp(option, "--unique") == 0) {
+            unsigned long int uniqueKeys;
+            if (!parseWholeNumber(value, INT_MAX, &uniqueKeys) || uniqueKeys < 1) {
+                fprintf(stderr, "There must be a whole number from 1 to %d of unique keys: %s\n", INT_MAX, value);
+                return 0;
+            }
+            options->generation.uniqueKeys = (int)uniqueKeys;
+        } else if (strcmp(option, "--runs") == 0) {
+            unsigned long int sawtoothRuns;
+            if (!parseWholeNumber(value, INT_MAX, &sawtoothRuns) || sawtoothRuns < 1) {
+                fprintf(stderr, "There must be a whole number from 1 to %d of sawtooth runs: %s\n", INT_MAX, value);
+                return 0;
+            }
+            options->generation.sawtoothRuns = (int)sawtoothRuns;
+        } else if (strcmp(option, "--zipf") == 0) {
+            if (!parseDecimalNumber(value, 0.0, DBL_MAX, &options->generation.zipfExponent) || options->generation.zipfExponent == 0.0) {
+                fprintf(stderr, "The Zipf exponent must be a positive number: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--repetitions") == 0 || strcmp(option, "-r") == 0) {
+            unsigned long int repetitions;
+            if (!parseWholeNumber(value, INT_MAX, &repetitions) || repetitions < 1) {
+                fprintf(stderr, "Repetitions must be a whole number from 1 to %d: %s\n", INT_MAX, value);
+                return 0;
+            }
+            options->repetitions = (int)repetitions;
+        } else if (strcmp(option, "--warmup") == 0 || strcmp(option, "-w") == 0) {
+            unsigned long int warmups;
+            if (!parseWholeNumber(value, INT_MAX, &warmups)) {
+                fprintf(stderr, "Warm-up runs must be a whole number from 0 to %d: %s\n", INT_MAX, value);
+                return 0;
+            }
+            options->warmups = (int)warmups;
+        } else if (strcmp(option, "--csv") == 0) {
+            options->csvFile = value;
+        } else if (strcmp(option, "--types") == 0) {
+            free(options->selectedElementTypes);
+            options->selectedElementTypes = calloc(elementTypesSize, sizeof(int));
+            if (options->selectedElementTypes == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return 0;
+            }
+            char *list = malloc(strlen(value) + 1);
+            strcpy(list, value);
+            for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                int found = 0;
+                for (int j = 0; j < elementTypesSize; j++) {
+                    if (strcmp(elementTypes[j].name, item) == 0 || strcmp(item, "all") == 0) {
+                        options->selectedElementTypes[j] = 1;
+                        found = 1;
+                    }
+                }
+                if (!found) {
+                    fprintf(stderr, "Unknown element type: %s\n", item);
+                    free(list);
+                    return 0;
+                }
+            }
+            free(list);
+        } else if (strcmp(option, "--records") == 0) {
+            free(options->selectedRecordTypes);
+            options->selectedRecordTypes = calloc(elementTypesSize, sizeof(int));
+            if (options->selectedRecordTypes == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return 0;
+            }
+
+            // Record sizes in bytes, of the key+value record or the rN records
+            char *list = malloc(strlen(value) + 1);
+            strcpy(list, value);
+            for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                int found = 0;
+                unsigned long int size = 0;
+                for (int j = 0; parseWholeNumber(item, ULONG_MAX, &size) && j < elementTypesSize; j++) {
+                    int isRecord = strcmp(elementTypes[j].name, "kv") == 0 || elementTypes[j].name[0] == 'r';
+                    if (isRecord && elementTypes[j].size == size) {
+                        options->selectedRecordTypes[j] = 1;
+                        found = 1;
+                    }
+                }
+                if (!found) {
+                    fprintf(stderr, "Records can be 16, 32, 64, 128 or 256 bytes: %s\n", item);
+                    free(list);
+                    return 0;
+                }
+            }
+            free(list);
+        } else if (strcmp(option, "--scaling") == 0) {
+            if (strcmp(value, "strong") == 0) {
+                options->scalingMode = SCALING_STRONG;
+            } else if (strcmp(value, "weak") == 0) {
+                options->scalingMode = SCALING_WEAK;
+            } else if (strcmp(value, "both") == 0) {
+                options->scalingMode = SCALING_STRONG | SCALING_WEAK;
+            } else {
+                fprintf(stderr, "Unknown scaling table: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--select") == 0) {
+            // k / N ratios, e.g. 0.001,0.01,0.1
+            free(options->selectRatios);
+            options->selectRatiosCount = 0;
+            options->selectRatios = malloc((strlen(value) / 2 + 1) * sizeof(double));
+            if (options->selectRatios == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return 0;
+            }
+            char *list = malloc(strlen(value) + 1);
+            strcpy(list, value);
+            for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+                double ratio;
+                if (!parseDecimalNumber(item, 0.0, 1.0, &ratio) || ratio == 0.0) {
+                    fprintf(stderr, "k / N is a number in (0, 1]: %s\n", item);
+                    free(list);
+                    return 0;
+                }
+                options->selectRatios[options->selectRatiosCount++] = ratio;
+            }
+            free(list);
+            if (options->selectRatiosCount == 0) {
+                fprintf(stderr, "Missing k / N ratios for --select\n");
+                return 0;
+            }
+        } else if (strcmp(option, "--calibrate") == 0) {
+            options->calibrationFile = value;
+        } else if (strcmp(option, "--thresholds") == 0) {
+            if (!loadSortThresholds(value, &sortThresholds)) {
+                fprintf(stderr, "Could not read the thresholds of Auto Sort from %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--pin") == 0) {
+            if (strcmp(value, "on") == 0) {
+                pinThreads = 1;
+            } else if (strcmp(value, "off") == 0) {
+                pinThreads = 0;
+            } else {
+                fprintf(stderr, "--pin is on or off: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--timing") == 0) {
+            timingMode = -1;
+            for (int mode = TIMING_WARM; mode <= TIMING_HUGE_PAGES; mode++) {
+                if (strcmp(value, timingModeNames[mode]) == 0) {
+                    timingMode = mode;
+                }
+            }
+            if (timingMode < 0) {
+                fprintf(stderr, "--timing is warm, cold or huge: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--arena") == 0) {
+            if (strcmp(value, "on") == 0) {
+                useScratchArena = 1;
+            } else if (strcmp(value, "off") == 0) {
+                useScratchArena = 0;
+            } else {
+                fprintf(stderr, "--arena is on or off: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--results") == 0) {
+            options->resultsFile = strcmp(value, "none") == 0 ? NULL : value;
+        } else if (strcmp(option, "--compare") == 0) {
+            // BASELINE,CANDIDATE
+            const char *separator = strchr(value, ',');
+            if (separator == NULL || separator == value || separator[1] == '\0') {
+                fprintf(stderr, "Expected two results files separated by a comma: %s\n", value);
+                return 0;
+            }
+            options->compareBaseline = value;
+            options->compareCandidate = separator + 1;
+            argv[i][separator - value] = '\0';
+        } else if (strcmp(option, "--threshold") == 0) {
+            if (!parseDecimalNumber(value, 0.0, DBL_MAX, &options->regressionThreshold)) {
+                fprintf(stderr, "The regression threshold is a percentage of 0 or more: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--alpha") == 0) {
+            if (!parseDecimalNumber(value, 0.0, 1.0, &options->significanceLevel) ||
+                options->significanceLevel == 0.0 || options->significanceLevel == 1.0) {
+                fprintf(stderr, "The significance level must be between 0 and 1: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--input") == 0 || strcmp(option, "-i") == 0) {
+            options->inputFile = value;
+        } else if (strcmp(option, "--external") == 0) {
+            options->externalInput = value;
+        } else if (strcmp(option, "--external-output") == 0) {
+            options->externalOutput = value;
+        } else if (strcmp(option, "--temp-dir") == 0) {
+            options->temporaryDirectory = value;
+        } else if (strcmp(option, "--memory") == 0) {
+            options->memoryBudget = parseByteSize(value);
+            if (options->memoryBudget < 1024 * 1024) {
+                fprintf(stderr, "Memory budget must be at least 1M: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--stream") == 0) {
+            if (strcmp(value, "text") == 0) {
+                options->streamFormat = OUTPUT_FORMAT_TEXT;
+            } else if (strcmp(value, "binary") == 0) {
+                options->streamFormat = OUTPUT_FORMAT_BINARY;
+            } else {
+                fprintf(stderr, "Unknown stream format: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--stream-output") == 0) {
+            options->streamOutput = strcmp(value, "none") == 0 ? NULL : value;
+        } else if (strcmp(option, "--batch") == 0) {
+            options->streamBatchSize = parseByteSize(value);
+            if (options->streamBatchSize < 1024 || options->streamBatchSize / sizeof(unsigned long int) > INT_MAX) {
+                fprintf(stderr, "Batch size must be between 1K and %lluG: %s\n", ((unsigned long long)INT_MAX * sizeof(unsigned long int)) >> 30, value);
+                return 0;
+            }
+        } else if (strcmp(option, "--snapshot") == 0) {
+            options->streamSnapshotSize = parseByteSize(value);
+            if (options->streamSnapshotSize == 0) {
+                fprintf(stderr, "Invalid snapshot size: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--budget") == 0 || strcmp(option, "-b") == 0) {
+            if (!parseDecimalNumber(value, 0.0, DBL_MAX, &options->timeBudget) || options->timeBudget == 0.0) {
+                fprintf(stderr, "The time budget must be a positive number of seconds: %s\n", value);
+                return 0;
+            }
+        } else if (strcmp(option, "--output") == 0 || strcmp(option, "-o") == 0) {
+            if (strcmp(value, "none") == 0) {
+                options->outputFormat = OUTPUT_FORMAT_NONE;
+            } else if (strcmp(value, "text") == 0) {
+                options->outputFormat = OUTPUT_FORMAT_TEXT;
+            } else if (strcmp(value, "binary") == 0) {
+                options->outputFormat = OUTPUT_FORMAT_BINARY;
+            } else {
+                fprintf(stderr, "Unknown output format: %s\n", value);
+                return 0;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", option);
+            return 0;
+        }
+    }
+
+    // Fall back to the defaults for lists that were not given. With a data file,
+    // the file is benchmarked as a whole unless N values are given.
+    if (options->sizes == NULL && options->inputFile == NULL) {
+        options->sizes = parseSizesList("1000", &options->sizesCount);
+    }
+    if (options->methods == NULL) {
+        options->methods = malloc(sizeof(int));
+        options->methods[0] = options->inputFile != NULL ? METHOD_FILE : METHOD_RANDOM;
+        options->methodsCount = 1;
+    }
+    for (int m = 0; m < options->methodsCount; m++) {
+        if (options->methods[m] == METHOD_FILE && options->inputFile == NULL) {
+            fprintf(stderr, "The \"From file\" method needs --input FILE\n");
+            return 0;
+        }
+    }
+    if (options->threads == NULL) {
+        options->threads = malloc(sizeof(int));
+        options->threads[0] = sortingThreads;
+        options->threadsCount = 1;
+    }
+    return 1;
+}
+int *parseSizesList(const char *text, int *count) {
+    int capacity = 16;
+    int *sizes = malloc(capacity * sizeof(int));
+    *count = 0;
+    if (sizes == NULL) {
+        return NULL;
+    }
+
+    const char *item = text;
+    while (*item != '\0') {
+        char *end;
+        long start = strtol(item, &end, 10);
+        long last = start;
+        long step = 0;
+        int isMultiplicative = 0;
+
+        // A range has the form START:END[:STEP]
+        if (*end == ':') {
+            last = strtol(end + 1, &end, 10);
+            step = 1;
+            if (*end == ':') {
+                const char *stepText = end + 1;
+                if (*stepText == 'x' || *stepText == '*') {
+                    isMultiplicative = 1;
+                    stepText++;
+                }
+                step = strtol(stepText, &end, 10);
+            }
+        }
+        if (end == item || (*end != ',' && *end != '\0') || start < 1 || last < start || last > INT_MAX
+            || step < 0 || (isMultiplicative && step < 2) || (!isMultiplicative && step == 0 && last != start)) {
+            free(sizes);
+            return NULL;
+        }
+
+        for (long value = start; value <= last; value = isMultiplicative ? value * step : value + step) {
+            if (*count == capacity) {
+                capacity *= 2;
+                int *grown = realloc(sizes, capacity * sizeof(int));
+                if (grown == NULL) {
+                    free(sizes);
+                    return NULL;
+                }
+                sizes = grown;
+            }
+            sizes[(*count)++] = (int)value;
+            if (step == 0) break;
+        }
+
+        item = (*end == ',') ? end + 1 : end;
+    }
+
+    if (*count == 0) {
+        free(sizes);
+        return NULL;
+    }
+    return sizes;
+}
+void runBatchBenchmark(const BatchOptions *options) {
+    // The selected algorithms, or their typed versions for each selected element type
+    const SortingAlgorithm **runAlgorithms = malloc((algorithmsSize + typedAlgorithmsSize) * sizeof(SortingAlgorithm *));
+    int runAlgorithmsSize = 0;
+    if (runAlgorithms == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < algorithmsSize && options->selectedElementTypes == NULL; i++) {
+        if (options->selectedAlgorithms[i]) {
+            runAlgorithms[runAlgorithmsSize++] = &algorithms[i];
+        }
+    }
+    for (int i = 0; i < typedAlgorithmsSize && options->selectedElementTypes != NULL; i++) {
+        int type = (int)(typedAlgorithms[i].elementType - elementTypes);
+        if (!options->selectedElementTypes[type]) continue;
+        // "Intro Sort (u32)" is selected along with "Intro Sort"
+        for (int j = 0; j < algorithmsSize; j++) {
+            if (options->selectedAlgorithms[j] && isTypedVersionOf(&typedAlgorithms[i], &algorithms[j])) {
+                runAlgorithms[runAlgorithmsSize++] = &typedAlgorithms[i];
+                break;
+            }
+        }
+    }
+    if (runAlgorithmsSize == 0) {
+        fprintf(stderr, "None of the selected algorithms has typed versions (merge, intro, heap and LSD radix sorts)\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double *samples = malloc(options->repetitions * sizeof(double));
+    double *orderedSamples = malloc(options->repetitions * sizeof(double));
+    BenchmarkResult *results = malloc(runAlgorithmsSize * options->threadsCount * sizeof(BenchmarkResult));
+    if (samples == NULL || orderedSamples == NULL || results == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int defaultThreads = sortingThreads;
+    outputFormat = options->outputFormat;
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+
+    // The data file is loaded once and shared by every cell that uses it
+    Dataset dataset = {NULL, 0, NULL, 0, 0};
+    if (options->inputFile != NULL) {
+        double loadStartTime = getTimeInSeconds();
+        if (!loadDataset(options->inputFile, &dataset)) {
+            exit(EXIT_FAILURE);
+        }
+        fprintf(stderr, "Loaded %d keys from %s in %.3lfsecs\n", dataset.n, options->inputFile, getTimeInSeconds() - loadStartTime);
+    }
+    int fileSize = dataset.n;
+    const int *sizes = options->sizes != NULL ? options->sizes : &fileSize;
+    int sizesCount = options->sizes != NULL ? options->sizesCount : 1;
+
+    // The times of each (algorithm, thread count) at the N already run, to predict the next N
+    int historiesSize = runAlgorithmsSize * options->threadsCount;
+    TimingHistory *histories = malloc(historiesSize * sizeof(TimingHistory));
+    double *historyPoints = malloc(2 * (size_t)historiesSize * sizesCount * sizeof(double));
+    if (histories == NULL || historyPoints == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int h = 0; h < historiesSize; h++) {
+        histories[h].sizes = historyPoints + (size_t)h * 2 * sizesCount;
+        histories[h].times = histories[h].sizes + sizesCount;
+    }
+
+    displayHeader();
+    printf("\nSeed: %u | Repetitions: %d | Warm-up runs: %d | Kernels: %s | Timing: %s", options->generation.seed, options->repetitions, options->warmups, simdKernelLevel, timingModeNames[timingMode]);
+    if (options->timeBudget > 0.0) {
+        printf(" | Budget: %.1lfs per run", options->timeBudget);
+    }
+    #ifdef COUNT_OPERATIONS
+        // The counting slows the hot loops down, these times are not comparable with a normal build
+        printf(" | Counting operations");
+    #endif
+    printf("\n");
+
+    appendCsvHeader(options);
+
+    for (int m = 0; m < options->methodsCount; m++) {
+        int method = options->methods[m];
+        char methodName[640];
+        describeGenerationMethod(method, &options->generation, methodName, sizeof(methodName));
+        if (method == METHOD_FILE) {
+            snprintf(methodName, sizeof(methodName), "%s (%s)", dataGenerationMethods[METHOD_FILE - 1], options->inputFile);
+        }
+        // Times from another method don't predict this one (e.g. insertion sort on increasing data)
+        for (int h = 0; h < historiesSize; h++) {
+            histories[h].count = 0;
+            histories[h].timedOutSize = 0;
+        }
+        for (int s = 0; s < sizesCount; s++) {
+            int n = sizes[s];
+
+            // Every algorithm in the cell sorts the same generated data
+            unsigned long int *unsortedArr;
+            if (method != METHOD_FILE) {
+                unsortedArr = generateData(method, n, &options->generation);
+            } else {
+                // The first N keys of the file, used in place
+                if (n > dataset.n) {
+                    fprintf(stderr, "N: %d is larger than the %d keys in %s\n", n, dataset.n, options->inputFile);
+                    continue;
+                }
+                unsortedArr = dataset.keys;
+            }
+            if (unsortedArr == NULL) {
+                fprintf(stderr, "Memory allocation failed (N: %d)\n", n);
+                exit(EXIT_FAILURE);
+            }
+            // Data from a file is not written again, the output could be the input file itself
+            char title[256];
+            if (method != METHOD_FILE) {
+                snprintf(title, sizeof(title), "\nUnsorted Array | Number of elements (N): %d\n", n);
+                writeArrayOutput("output/unsorted.txt", title, unsortedArr, n);
+            }
+
+            int resultsSize = 0;
+            for (int i = 0; i < runAlgorithmsSize; i++) {
+                const SortingAlgorithm *algorithm = runAlgorithms[i];
+
+                // Parallel algorithms are run once per thread count of the sweep
+                int sweepSize = algorithm->isParallel ? options->threadsCount : 1;
+                double baselineMedian = 0.0;
+                for (int t = 0; t < sweepSize; t++) {
+                    int threads = algorithm->isParallel ? options->threads[t] : 0;
+                    sortingThreads = algorithm->isParallel ? threads : defaultThreads;
+                    TimingHistory *history = &histories[i * options->threadsCount + t];
+
+                    BenchmarkResult *result = &results[resultsSize++];
+                    memset(result, 0, sizeof(BenchmarkResult));
+                    result->algorithm = algorithm;
+                    result->threads = threads;
+                    result->status = RESULT_COMPLETED;
+
+                    fprintf(stderr, "[%s] N: %d | %s", algorithm->name, n, methodName);
+                    if (threads > 0) {
+                        fprintf(stderr, " | Threads: %d", threads);
+                    }
+
+                    // Skip the cells that would run out of time: past an N that already timed out,
+                    // or when the smaller N predict a run longer than the budget
+                    if (options->timeBudget > 0.0) {
+                        if (history->timedOutSize > 0 && n >= history->timedOutSize) {
+                            result->status = RESULT_SKIPPED;
+                            result->predictedTime = INFINITY;
+                        } else {
+                            result->predictedTime = predictSortingTime(history, algorithm->complexity, n);
+                            if (result->predictedTime > options->timeBudget) {
+                                result->status = RESULT_SKIPPED;
+                            }
+                        }
+                    }
+                    if (result->status == RESULT_SKIPPED) {
+                        if (isinf(result->predictedTime)) {
+                            fprintf(stderr, " | Skipped, timed out at N: %d\n", history->timedOutSize);
+                        } else {
+                            fprintf(stderr, " | Skipped, predicted %.1lfs per run\n", result->predictedTime);
+                        }
+                        appendResultToCsv(options, n, methodName, result);
+                        if (options->resultsFile != NULL) {
+                            appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, result, NULL, 0);
+                        }
+                        continue;
+                    }
+                    fprintf(stderr, "\n");
+
+                    if (options->timeBudget > 0.0) {
+                        result->status = measureAlgorithmWithBudget(algorithm, unsortedArr, n, options, samples, result);
+                    } else {
+                        measureAlgorithm(algorithm, unsortedArr, n, options, samples, result, -1);
+                    }
+                    if (result->status == RESULT_TIMED_OUT) {
+                        fprintf(stderr, "[%s] N: %d | Timed out, a run took longer than %.1lfs\n", algorithm->name, n, options->timeBudget);
+                        if (history->timedOutSize == 0 || n < history->timedOutSize) {
+                            history->timedOutSize = n;
+                        }
+                        appendResultToCsv(options, n, methodName, result);
+                        if (options->resultsFile != NULL) {
+                            appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, result, NULL, 0);
+                        }
+                        continue;
+                    }
+                    // The statistics sort the samples, the record keeps them in the order they were run
+                    memcpy(orderedSamples, samples, options->repetitions * sizeof(double));
+                    result->stats = computeBenchmarkStats(samples, options->repetitions);
+                    history->sizes[history->count] = n;
+                    history->times[history->count] = result->stats.median;
+                    history->count++;
+
+                    // Speedup is relative to the first thread count of the sweep
+                    if (t == 0) {
+                        baselineMedian = result->stats.median;
+                    }
+                    result->speedup = (threads > 0 && baselineMedian > 0.0 && result->stats.median > 0.0) ? baselineMedian / result->stats.median : 0.0;
+
+                    appendResultToCsv(options, n, methodName, result);
+                    if (options->resultsFile != NULL) {
+                        appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, result, orderedSamples, options->repetitions);
+                    }
+                }
+            }
+            sortingThreads = defaultThreads;
+            if (unsortedArr != dataset.keys) {
+                free(unsortedArr);
+            }
+
+            // Rank by median time as it is the least sensitive to outliers
+            qsort(results, resultsSize, sizeof(BenchmarkResult), compareResultsByMedian);
+
+            printf("\nNumber of Elements (N): %d", n);
+            displayGenerationMethod(method, &options->generation, options->inputFile);
+            printf("\n---------------------------------------------------------------------------------------------------------------");
+            printf("\n| Rank |        Algorithm       | Threads |      Min      |     Median    |      Mean     |     Stddev    | Speedup |");
+            printf("\n---------------------------------------------------------------------------------------------------------------");
+            for (int i = 0; i < resultsSize; i++) {
+                BenchmarkResult *result = &results[i];
+                if (result->status == RESULT_COMPLETED) {
+                    printf("\n|%5d | %22s |", i+1, result->algorithm->name);
+                } else {
+                    printf("\n|    - | %22s |", result->algorithm->name);
+                }
+                if (result->threads > 0) {
+                    printf(" %7d |", result->threads);
+                } else {
+                    printf("       - |");
+                }
+
+                // Cells without statistics say why instead
+                char reason[128];
+                if (result->status == RESULT_TIMED_OUT) {
+                    snprintf(reason, sizeof(reason), "Timed out, a run took longer than %.1lfs", options->timeBudget);
+                } else if (result->status == RESULT_SKIPPED && isinf(result->predictedTime)) {
+                    snprintf(reason, sizeof(reason), "Skipped, timed out at a smaller N");
+                } else if (result->status == RESULT_SKIPPED) {
+                    snprintf(reason, sizeof(reason), "Skipped, predicted %.1lfs per run", result->predictedTime);
+                }
+                if (result->status != RESULT_COMPLETED) {
+                    printf(" %-71s |", reason);
+                    continue;
+                }
+                printf(" %14.9lf| %14.9lf| %14.9lf| %14.9lf|", result->stats.min, result->stats.median, result->stats.mean, result->stats.stddev);
+                if (result->threads > 0) {
+                    printf(" %6.2lfx |", result->speedup);
+                } else {
+                    printf("       - |");
+                }
+            }
+            printf("\n---------------------------------------------------------------------------------------------------------------\n");
+            displayHardwareCounters(results, resultsSize);
+            displayOperationCounts(results, resultsSize, n);
+            displayMemoryUsage(results, resultsSize, n);
+            fflush(stdout);
+        }
+    }
+
+    freeDataset(&dataset);
+    free(runAlgorithms);
+    free(samples);
+    free(orderedSamples);
+    free(results);
+    free(histories);
+    free(historyPoints);
+}
+void runRecordBenchmark(const BatchOptions *options) {
+    double *samples = malloc(options->repetitions * sizeof(double));
+    double *orderedSamples = malloc(options->repetitions * sizeof(double));
+    if (samples == NULL || orderedSamples == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+    const char *modeNames[] = {"direct", "gather", "cycles"};
+
+    Dataset dataset = {NULL, 0, NULL, 0, 0};
+    if (options->inputFile != NULL && !loadDataset(options->inputFile, &dataset)) {
+        exit(EXIT_FAILURE);
+    }
+    int fileSize = dataset.n;
+    const int *sizes = options->sizes != NULL ? options->sizes : &fileSize;
+    int sizesCount = options->sizes != NULL ? options->sizesCount : 1;
+
+    displayHeader();
+    printf("\nSeed: %u | Repetitions: %d | Warm-up runs: %d | Kernels: %s | Timing: %s", options->generation.seed, options->repetitions, options->warmups, simdKernelLevel, timingModeNames[timingMode]);
+    printf("\nDirect moves whole records, gather and cycles sort (key, index) pairs with the algorithm then move");
+    printf("\nevery record once, into a new array or in place along the cycles of the permutation\n");
+    appendCsvHeader(options);
+
+    for (int m = 0; m < options->methodsCount; m++) {
+        int method = options->methods[m];
+        char methodName[640];
+        describeGenerationMethod(method, &options->generation, methodName, sizeof(methodName));
+        if (method == METHOD_FILE) {
+            snprintf(methodName, sizeof(methodName), "%s (%s)", dataGenerationMethods[METHOD_FILE - 1], options->inputFile);
+        }
+        for (int s = 0; s < sizesCount; s++) {
+            int n = sizes[s];
+            unsigned long int *keys;
+            if (method != METHOD_FILE) {
+                keys = generateData(method, n, &options->generation);
+            } else if (n <= dataset.n) {
+                keys = dataset.keys;
+            } else {
+                fprintf(stderr, "N: %d is larger than the %d keys in %s\n", n, dataset.n, options->inputFile);
+                continue;
+            }
+            if (keys == NULL) {
+                fprintf(stderr, "Memory allocation failed (N: %d)\n", n);
+                exit(EXIT_FAILURE);
+            }
+
+            printf("\nNumber of Elements (N): %d", n);
+            displayGenerationMethod(method, &options->generation, options->inputFile);
+            printf("\n----------------------------------------------------------------------------------------------");
+            printf("\n| Record |        Algorithm       |     Direct    | Indirect gather | Indirect cycles |  Best  |");
+            printf("\n----------------------------------------------------------------------------------------------");
+            fflush(stdout);
+
+            for (int type = 0; type < elementTypesSize; type++) {
+                if (!options->selectedRecordTypes[type]) continue;
+                const ElementType *recordType = &elementTypes[type];
+
+                for (int i = 0; i < algorithmsSize; i++) {
+                    if (!options->selectedAlgorithms[i]) continue;
+
+                    // Direct sorting needs the version of the algorithm generated for this record type
+                    const SortingAlgorithm *directAlgorithm = NULL;
+                    for (int j = 0; j < typedAlgorithmsSize; j++) {
+                        if (typedAlgorithms[j].elementType == recordType && isTypedVersionOf(&typedAlgorithms[j], &algorithms[i])) {
+                            directAlgorithm = &typedAlgorithms[j];
+                        }
+                    }
+
+                    double medians[3] = {-1.0, -1.0, -1.0};
+                    for (int mode = RECORD_SORT_DIRECT; mode <= RECORD_SORT_CYCLES; mode++) {
+                        if (mode == RECORD_SORT_DIRECT && directAlgorithm == NULL) continue;
+
+                        // The cell is recorded as e.g. "Intro Sort (r64)" or "Intro Sort (r64 gather)"
+                        char name[128];
+                        if (mode == RECORD_SORT_DIRECT) {
+                            snprintf(name, sizeof(name), "%s", directAlgorithm->name);
+                        } else {
+                            snprintf(name, sizeof(name), "%s (%s %s)", algorithms[i].name, recordType->name, modeNames[mode]);
+                        }
+                        SortingAlgorithm cell = algorithms[i];
+                        cell.name = name;
+                        const SortingAlgorithm *algorithm = mode == RECORD_SORT_DIRECT ? directAlgorithm : &algorithms[i];
+                        fprintf(stderr, "[%s] N: %d | %s\n", name, n, methodName);
+
+                        BenchmarkResult result;
+                        memset(&result, 0, sizeof(result));
+                        result.algorithm = &cell;
+                        result.threads = algorithms[i].isParallel ? sortingThreads : 0;
+                        result.status = RESULT_COMPLETED;
+                        for (int r = 0; r < options->warmups; r++) {
+                            timeRecordSort(algorithm, mode, recordType, keys, n, NULL);
+                        }
+                        for (int r = 0; r < options->repetitions; r++) {
+                            samples[r] = timeRecordSort(algorithm, mode, recordType, keys, n, &result);
+                        }
+                        memcpy(orderedSamples, samples, options->repetitions * sizeof(double));
+                        result.stats = computeBenchmarkStats(samples, options->repetitions);
+                        medians[mode] = result.stats.median;
+
+                        appendResultToCsv(options, n, methodName, &result);
+                        if (options->resultsFile != NULL) {
+                            appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, &result, orderedSamples, options->repetitions);
+                        }
+                    }
+
+                    int best = RECORD_SORT_GATHER;
+                    for (int mode = RECORD_SORT_DIRECT; mode <= RECORD_SORT_CYCLES; mode++) {
+                        if (medians[mode] >= 0.0 && medians[mode] < medians[best]) best = mode;
+                    }
+                    printf("\n| %4dB  | %22s |", (int)recordType->size, algorithms[i].name);
+                    if (medians[RECORD_SORT_DIRECT] >= 0.0) {
+                        printf(" %14.9lf|", medians[RECORD_SORT_DIRECT]);
+                    } else {
+                        printf("             - |");
+                    }
+                    printf("  %14.9lf|  %14.9lf| %6s |", medians[RECORD_SORT_GATHER], medians[RECORD_SORT_CYCLES], modeNames[best]);
+                    fflush(stdout);
+                }
+            }
+            printf("\n----------------------------------------------------------------------------------------------\n");
+
+            if (method != METHOD_FILE) {
+                free(keys);
+            }
+        }
+    }
+
+    freeDataset(&dataset);
+    free(samples);
+    free(orderedSamples);
+}
+void runSelectionBenchmark(const BatchOptions *options) {
+    const char *operationNames[] = {"Intro Select", "Top-k Heap", "Partial Sort"};
+    double *samples = malloc(options->repetitions * sizeof(double));
+    double *orderedSamples = malloc(options->repetitions * sizeof(double));
+    if (samples == NULL || orderedSamples == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+
+    // The first selected algorithm sorts every key, Intro Sort by default as introSelect partitions like it
+    const SortingAlgorithm *fullSort = NULL;
+    int allSelected = 1;
+    for (int i = 0; i < algorithmsSize; i++) {
+        allSelected = allSelected && options->selectedAlgorithms[i];
+    }
+    for (int i = 0; i < algorithmsSize && fullSort == NULL; i++) {
+        if (allSelected ? strcmp(algorithms[i].name, "Intro Sort") == 0 : options->selectedAlgorithms[i]) {
+            fullSort = &algorithms[i];
+        }
+    }
+
+    Dataset dataset = {NULL, 0, NULL, 0, 0};
+    if (options->inputFile != NULL && !loadDataset(options->inputFile, &dataset)) {
+        exit(EXIT_FAILURE);
+    }
+    int fileSize = dataset.n;
+    const int *sizes = options->sizes != NULL ? options->sizes : &fileSize;
+    int sizesCount = options->sizes != NULL ? options->sizesCount : 1;
+
+    displayHeader();
+    printf("\nSeed: %u | Repetitions: %d | Warm-up runs: %d | Kernels: %s | Timing: %s", options->generation.seed, options->repetitions, options->warmups, simdKernelLevel, timingModeNames[timingMode]);
+    printf("\nMedian times of selecting the k smallest keys, and how many times faster the fastest selection");
+    printf("\nis than sorting every key with %s\n", fullSort->name);
+    appendCsvHeader(options);
+
+    for (int m = 0; m < options->methodsCount; m++) {
+        int method = options->methods[m];
+        char methodName[640];
+        describeGenerationMethod(method, &options->generation, methodName, sizeof(methodName));
+        if (method == METHOD_FILE) {
+            snprintf(methodName, sizeof(methodName), "%s (%s)", dataGenerationMethods[METHOD_FILE - 1], options->inputFile);
+        }
+        for (int s = 0; s < sizesCount; s++) {
+            int n = sizes[s];
+            unsigned long int *keys;
+            if (method != METHOD_FILE) {
+                keys = generateData(method, n, &options->generation);
+            } else if (n <= dataset.n) {
+                keys = dataset.keys;
+            } else {
+                fprintf(stderr, "N: %d is larger than the %d keys in %s\n", n, dataset.n, options->inputFile);
+                continue;
+            }
+            if (keys == NULL) {
+                fprintf(stderr, "Memory allocation failed (N: %d)\n", n);
+                exit(EXIT_FAILURE);
+            }
+
+            // The full sort is timed once per N, its output checks every selection
+            fprintf(stderr, "[%s] N: %d | %s\n", fullSort->name, n, methodName);
+            if (fullSort->isParallel) {
+                sortingThreads = options->threads[0];
+            }
+            BenchmarkResult fullResult;
+            memset(&fullResult, 0, sizeof(fullResult));
+            fullResult.algorithm = fullSort;
+            fullResult.threads = fullSort->isParallel ? sortingThreads : 0;
+            fullResult.status = RESULT_COMPLETED;
+            measureAlgorithm(fullSort, keys, n, options, samples, &fullResult, -1);
+            memcpy(orderedSamples, samples, options->repetitions * sizeof(double));
+            fullResult.stats = computeBenchmarkStats(samples, options->repetitions);
+            appendResultToCsv(options, n, methodName, &fullResult);
+            if (options->resultsFile != NULL) {
+                appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, &fullResult, orderedSamples, options->repetitions);
+            }
+            unsigned long int *sortedKeys = duplicateArray(keys, n);
+            if (sortedKeys == NULL) {
+                exit(EXIT_FAILURE);
+            }
+            introSort(sortedKeys, n);
+
+            printf("\nNumber of Elements (N): %d", n);
+            displayGenerationMethod(method, &options->generation, options->inputFile);
+            printf("\nFull sort (%s): %.9lfs", fullSort->name, fullResult.stats.median);
+            printf("\n--------------------------------------------------------------------------------------------");
+            printf("\n|   k / N   |      k     |  Intro Select |   Top-k Heap  |  Partial Sort |  Fastest vs sort |");
+            printf("\n--------------------------------------------------------------------------------------------");
+            fflush(stdout);
+
+            for (int r = 0; r < options->selectRatiosCount; r++) {
+                int k = (int)(options->selectRatios[r] * n + 0.5);
+                if (k < 1) k = 1;
+                if (k > n) k = n;
+                if (n == 0) continue;
+
+                double medians[3];
+                for (int operation = SELECTION_NTH_ELEMENT; operation <= SELECTION_PARTIAL_SORT; operation++) {
+                    // The cell is recorded as e.g. "Top-k Heap (k=1000)"
+                    char name[128];
+                    snprintf(name, sizeof(name), "%s (k=%d)", operationNames[operation], k);
+                    SortingAlgorithm cell = {name, NULL, 0.0, NULL, 0, COMPLEXITY_N_LOG_N, NULL, NULL};
+                    fprintf(stderr, "[%s] N: %d | %s\n", name, n, methodName);
+
+                    BenchmarkResult result;
+                    memset(&result, 0, sizeof(result));
+                    result.algorithm = &cell;
+                    result.status = RESULT_COMPLETED;
+                    for (int w = 0; w < options->warmups; w++) {
+                        timeSelection(operation, keys, n, k, sortedKeys, NULL);
+                    }
+                    for (int i = 0; i < options->repetitions; i++) {
+                        samples[i] = timeSelection(operation, keys, n, k, sortedKeys, &result);
+                    }
+                    memcpy(orderedSamples, samples, options->repetitions * sizeof(double));
+                    result.stats = computeBenchmarkStats(samples, options->repetitions);
+                    medians[operation] = result.stats.median;
+
+                    appendResultToCsv(options, n, methodName, &result);
+                    if (options->resultsFile != NULL) {
+                        appendResultRecord(options->resultsFile, &environment, "batch", n, methodName, options->generation.seed, options->warmups, &result, orderedSamples, options->repetitions);
+                    }
+                }
+
+                double fastest = medians[SELECTION_NTH_ELEMENT];
+                for (int operation = SELECTION_TOP_K; operation <= SELECTION_PARTIAL_SORT; operation++) {
+                    if (medians[operation] < fastest) fastest = medians[operation];
+                }
+                printf("\n| %9.6lf | %10d | %14.9lf| %14.9lf| %14.9lf| %15.1lfx |", options->selectRatios[r], k,
+                    medians[SELECTION_NTH_ELEMENT], medians[SELECTION_TOP_K], medians[SELECTION_PARTIAL_SORT],
+                    fastest > 0.0 ? fullResult.stats.median / fastest : 0.0);
+                fflush(stdout);
+            }
+            printf("\n--------------------------------------------------------------------------------------------\n");
+
+            free(sortedKeys);
+            if (keys != dataset.keys) {
+                free(keys);
+            }
+        }
+    }
+
+    freeDataset(&dataset);
+    free(samples);
+    free(orderedSamples);
+}
+void runScalingBenchmark(const BatchOptions *options) {
+    const SortingAlgorithm **parallelAlgorithms = malloc(algorithmsSize * sizeof(SortingAlgorithm *));
+    int parallelAlgorithmsSize = 0;
+    double *samples = malloc(options->repetitions * sizeof(double));
+    double *orderedSamples = malloc(options->repetitions * sizeof(double));
+    double *baselineMedians = malloc(algorithmsSize * sizeof(double));
+    if (parallelAlgorithms == NULL || samples == NULL || orderedSamples == NULL || baselineMedians == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < algorithmsSize; i++) {
+        if (options->selectedAlgorithms[i] && algorithms[i].isParallel) {
+            parallelAlgorithms[parallelAlgorithmsSize++] = &algorithms[i];
+        }
+    }
+    if (parallelAlgorithmsSize == 0) {
+        fprintf(stderr, "None of the selected algorithms is parallel\n");
+        exit(EXIT_FAILURE);
+    }
+    if (options->sizes == NULL) {
+        fprintf(stderr, "The scaling benchmark generates its data and needs --sizes\n");
+        exit(EXIT_FAILURE);
+    }
+    int defaultThreads = sortingThreads;
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+
+    displayHeader();
+    printf("\nSeed: %u | Repetitions: %d | Warm-up runs: %d | Kernels: %s | Timing: %s | Pinned threads: %s\n",
+        options->generation.seed, options->repetitions, options->warmups, simdKernelLevel, timingModeNames[timingMode], pinThreads ? "yes" : "no");
+    printf("Speedup and efficiency are relative to the first thread count. Weak scaling efficiency is\n");
+    printf("the time with the first thread count over the time with more threads sorting more keys.\n");
+    appendCsvHeader(options);
+
+    for (int m = 0; m < options->methodsCount; m++) {
+        int method = options->methods[m];
+        if (method == METHOD_FILE) {
+            fprintf(stderr, "The scaling benchmark generates its data, skipping the \"From file\" method\n");
+            continue;
+        }
+        char methodName[640];
+        describeGenerationMethod(method, &options->generation, methodName, sizeof(methodName));
+
+        for (int s = 0; s < options->sizesCount; s++) {
+            int n = options->sizes[s];
+
+            if (options->scalingMode & SCALING_STRONG) {
+                unsigned long int *unsortedArr = generateData(method, n, &options->generation);
+                if (unsortedArr == NULL) {
+                    fprintf(stderr, "Memory allocation failed (N: %d)\n", n);
+                    exit(EXIT_FAILURE);
+                }
+
+                printf("\nStrong scaling | Number of Elements (N): %d", n);
+                displayGenerationMethod(method, &options->generation, NULL);
+                printf("\n------------------------------------------------------------------------");
+                printf("\n|        Algorithm       | Threads |     Median    | Speedup | Efficiency |");
+                printf("\n------------------------------------------------------------------------");
+                for (int i = 0; i < parallelAlgorithmsSize; i++) {
+                    double baselineMedian = 0.0;
+                    for (int t = 0; t < options->threadsCount; t++) {
+                        int threads = options->threads[t];
+                        BenchmarkResult result;
+                        int status = measureScalingCell(parallelAlgorithms[i], threads, unsortedArr, n, methodName, options, &environment, samples, orderedSamples, &result);
+                        printf("\n| %22s | %7d |", parallelAlgorithms[i]->name, threads);
+                        if (status != RESULT_COMPLETED) {
+                            printf(" %-37s |", "Timed out");
+                            fflush(stdout);
+                            break;
+                        }
+                        if (t == 0) {
+                            baselineMedian = result.stats.median;
+                        }
+                        double speedup = result.stats.median > 0.0 ? baselineMedian / result.stats.median : 0.0;
+                        printf(" %14.9lf| %6.2lfx | %9.1lf%% |", result.stats.median, speedup, 100.0 * speedup * options->threads[0] / threads);
+                        fflush(stdout);
+                    }
+                }
+                printf("\n------------------------------------------------------------------------\n");
+                free(unsortedArr);
+            }
+
+            if (options->scalingMode & SCALING_WEAK) {
+                printf("\nWeak scaling | N per thread: %d", n);
+                displayGenerationMethod(method, &options->generation, NULL);
+                printf("\n---------------------------------------------------------------------------");
+                printf("\n|        Algorithm       | Threads |      N      |     Median    | Efficiency |");
+                printf("\n---------------------------------------------------------------------------");
+                for (int i = 0; i < parallelAlgorithmsSize; i++) {
+                    baselineMedians[i] = -1.0;
+                }
+
+                // One array per thread count, shared by every algorithm
+                for (int t = 0; t < options->threadsCount; t++) {
+                    int threads = options->threads[t];
+                    long totalSize = (long)n * threads;
+                    if (totalSize > INT_MAX) {
+                        fprintf(stderr, "N per thread: %d on %d threads is more than %d keys\n", n, threads, INT_MAX);
+                        break;
+                    }
+                    unsigned long int *unsortedArr = generateData(method, (int)totalSize, &options->generation);
+                    if (unsortedArr == NULL) {
+                        fprintf(stderr, "Memory allocation failed (N: %ld)\n", totalSize);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    for (int i = 0; i < parallelAlgorithmsSize; i++) {
+                        // Past a timed out thread count the larger N would time out as well
+                        if (t > 0 && baselineMedians[i] < 0.0) continue;
+                        BenchmarkResult result;
+                        int status = measureScalingCell(parallelAlgorithms[i], threads, unsortedArr, (int)totalSize, methodName, options, &environment, samples, orderedSamples, &result);
+                        printf("\n| %22s | %7d | %11ld |", parallelAlgorithms[i]->name, threads, totalSize);
+                        if (status != RESULT_COMPLETED) {
+                            printf(" %-27s |", "Timed out");
+                            baselineMedians[i] = -1.0;
+                            fflush(stdout);
+                            continue;
+                        }
+                        if (t == 0) {
+                            baselineMedians[i] = result.stats.median;
+                        }
+                        double efficiency = result.stats.median > 0.0 ? baselineMedians[i] / result.stats.median : 0.0;
+                        printf(" %14.9lf| %9.1lf%% |", result.stats.median, 100.0 * efficiency);
+                        fflush(stdout);
+                    }
+                    free(unsortedArr);
+                }
+                printf("\n---------------------------------------------------------------------------\n");
+            }
+        }
+    }
+
+    sortingThreads = defaultThreads;
+    free(parallelAlgorithms);
+    free(samples);
+    free(orderedSamples);
+    free(baselineMedians);
+}
+int measureScalingCell(const SortingAlgorithm *algorithm, int threads, const unsigned long int *array, int n, const char *methodName, const BatchOptions *options, const RunEnvironment *environment, double *samples, double *orderedSamples, BenchmarkResult *result) {
+    fprintf(stderr, "[%s] N: %d | %s | Threads: %d\n", algorithm->name, n, methodName, threads);
+    memset(result, 0, sizeof(BenchmarkResult));
+    result->algorithm = algorithm;
+    result->threads = threads;
+    result->status = RESULT_COMPLETED;
+    sortingThreads = threads;
+
+    if (options->timeBudget > 0.0) {
+        result->status = measureAlgorithmWithBudget(algorithm, array, n, options, samples, result);
+    } else {
+        measureAlgorithm(algorithm, array, n, options, samples, result, -1);
+    }
+    if (result->status == RESULT_COMPLETED) {
+        // The statistics sort the samples, the record keeps them in the order they were run
+        memcpy(orderedSamples, samples, options->repetitions * sizeof(double));
+        result->stats = computeBenchmarkStats(samples, options->repetitions);
+    }
+
+    appendResultToCsv(options, n, methodName, result);
+    if (options->resultsFile != NULL) {
+        appendResultRecord(options->resultsFile, environment, "batch", n, methodName, options->generation.seed, options->warmups,
+            result, result->status == RESULT_COMPLETED ? orderedSamples : NULL, result->status == RESULT_COMPLETED ? options->repetitions : 0);
+    }
+    return result->status;
+}
+int runCalibration(const BatchOptions *options) {
+    int threads = options->threads[options->threadsCount - 1];
+    int defaultThreads = sortingThreads;
+    unsigned long int *keys = generateData(METHOD_UNIFORM_64, CALIBRATION_MAX_SIZE, &options->generation);
+    unsigned long int *work = (unsigned long int *)malloc(CALIBRATION_MAX_SIZE * sizeof(unsigned long int));
+    int sizes[64];
+    double times[128];
+    if (keys == NULL || work == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    RunEnvironment environment;
+    collectRunEnvironment(&environment);
+    SortThresholds thresholds = sortThresholds;
+
+    displayHeader();
+    printf("\nCalibrating Auto Sort | Seed: %u | Kernels: %s | Threads: %d\n", options->generation.seed, simdKernelLevel, threads);
+    printf("\n---------------------------------------------------------------------------");
+    printf("\n|    Crossover    |      N      |     First     |     Second    | Faster |");
+    printf("\n---------------------------------------------------------------------------");
+
+    // Insertion sort only wins on the smallest arrays, so its cutoff is the last N it still wins at
+    int sizesCount = 0;
+    for (int n = 4; n <= 64; n += 4) {
+        sizes[sizesCount] = n;
+        times[2 * sizesCount] = timeCalibrationSort(insertionSort, keys, work, n);
+        times[2 * sizesCount + 1] = timeCalibrationSort(simdQuickSort, keys, work, n);
+        printf("\n| %15s | %11d | %14.9lf| %14.9lf| %6s |", "Insertion/Quick", n, times[2 * sizesCount], times[2 * sizesCount + 1],
+            times[2 * sizesCount] <= times[2 * sizesCount + 1] ? "first" : "second");
+        fflush(stdout);
+        sizesCount++;
+    }
+    thresholds.insertionCutoff = 1;
+    for (int i = 0; i < sizesCount && times[2 * i] <= times[2 * i + 1]; i++) {
+        thresholds.insertionCutoff = sizes[i];
+    }
+
+    sizesCount = 0;
+    for (int n = 256; n <= CALIBRATION_MAX_SIZE; n *= 2) {
+        sizes[sizesCount] = n;
+        times[2 * sizesCount] = timeCalibrationSort(simdQuickSort, keys, work, n);
+        times[2 * sizesCount + 1] = timeCalibrationSort(lsdRadixSort, keys, work, n);
+        printf("\n| %15s | %11d | %14.9lf| %14.9lf| %6s |", "Quick/Radix", n, times[2 * sizesCount], times[2 * sizesCount + 1],
+            times[2 * sizesCount] <= times[2 * sizesCount + 1] ? "first" : "second");
+        fflush(stdout);
+        sizesCount++;
+    }
+    // Past some N the scatter of the radix sort misses the caches and the TLB on every key
+    findFasterRange(sizes, times, sizesCount, &thresholds.radixCutoff, &thresholds.radixLimit);
+
+    // The parallel versions of the serial algorithm chosen at each N
+    thresholds.parallelCutoff = INT_MAX;
+    if (threads > 1) {
+        sizesCount = 0;
+        for (int n = 16384; n <= CALIBRATION_MAX_SIZE; n *= 2) {
+            int isRadix = n >= thresholds.radixCutoff && n <= thresholds.radixLimit;
+            sizes[sizesCount] = n;
+            sortingThreads = 1;
+            times[2 * sizesCount] = timeCalibrationSort(isRadix ? lsdRadixSort : simdQuickSort, keys, work, n);
+            sortingThreads = threads;
+            times[2 * sizesCount + 1] = timeCalibrationSort(isRadix ? parallelLsdRadixSort : parallelSampleSort, keys, work, n);
+            printf("\n| %15s | %11d | %14.9lf| %14.9lf| %6s |", "Serial/Parallel", n, times[2 * sizesCount], times[2 * sizesCount + 1],
+                times[2 * sizesCount] <= times[2 * sizesCount + 1] ? "first" : "second");
+            fflush(stdout);
+            sizesCount++;
+        }
+        // Threads that stop paying off at the largest N are not used at all
+        int last;
+        findFasterRange(sizes, times, sizesCount, &thresholds.parallelCutoff, &last);
+        if (last != INT_MAX) {
+            thresholds.parallelCutoff = INT_MAX;
+        }
+        sortingThreads = defaultThreads;
+    }
+    printf("\n---------------------------------------------------------------------------\n");
+
+    printf("\nInsertion cutoff: %d | Radix sort: ", thresholds.insertionCutoff);
+    if (thresholds.radixCutoff == INT_MAX) {
+        printf("never");
+    } else if (thresholds.radixLimit == INT_MAX) {
+        printf("N >= %d", thresholds.radixCutoff);
+    } else {
+        printf("%d <= N <= %d", thresholds.radixCutoff, thresholds.radixLimit);
+    }
+    printf(" | Parallel cutoff: ");
+    if (thresholds.parallelCutoff == INT_MAX) {
+        printf("never\n");
+    } else {
+        printf("%d\n", thresholds.parallelCutoff);
+    }
+
+    char description[512];
+    snprintf(description, sizeof(description), "Thresholds of sort_u64 measured on %s with %d threads and %s kernels (commit %s)",
+        environment.cpu, threads, simdKernelLevel, environment.commit);
+    int isSaved = saveSortThresholds(options->calibrationFile, &thresholds, description);
+    if (isSaved) {
+        printf("Saved to %s, load them with --thresholds %s or loadSortThresholds()\n", options->calibrationFile, options->calibrationFile);
+    } else {
+        fprintf(stderr, "Could not write %s: %s\n", options->calibrationFile, strerror(errno));
+    }
+    free(keys);
+    free(work);
+    return isSaved;
+}
+double timeCalibrationSort(void (*function)(unsigned long int *, int), const unsigned long int *keys, unsigned long int *work, int n) {
+    int slices = n < CALIBRATION_KEYS ? CALIBRATION_KEYS / n : 1;
+    double bestTime = INFINITY;
+    for (int r = 0; r < 3; r++) {
+        memcpy(work, keys, (size_t)slices * n * sizeof(unsigned long int));
+        resetScratchMemory();
+        double startTime = getTimeInSeconds();
+        for (int slice = 0; slice < slices; slice++) {
+            function(work + (size_t)slice * n, n);
+        }
+        double time = (getTimeInSeconds() - startTime) / slices;
+        if (time < bestTime) {
+            bestTime = time;
+        }
+    }
+    return bestTime;
+}
+void findFasterRange(const int *sizes, const double *times, int sizesCount, int *first, int *last) {
+    *first = INT_MAX;
+    *last = INT_MAX;
+    int bestLength = 0;
+    for (int i = 0; i < sizesCount; i++) {
+        int length = 0;
+        while (i + length < sizesCount && times[2 * (i + length) + 1] < times[2 * (i + length)]) length++;
+        if (length > bestLength) {
+            bestLength = length;
+            *first = sizes[i];
+            *last = i + length == sizesCount ? INT_MAX : sizes[i + length - 1];
+        }
+        i += length;
+    }
+}
+double timeRecordSort(const SortingAlgorithm *algorithm, int mode, const ElementType *recordType, const unsigned long int *keys, int n, BenchmarkResult *result) {
+    size_t recordsSize = (n > 0 ? (size_t)n : 1) * recordType->size;
+    void *records = allocateTimedArray(recordsSize);
+    if (records == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    recordType->fill(records, keys, n);
+
+    resetOperationCounts();
+    resetScratchMemory();
+    prepareCaches();
+    if (result != NULL) {
+        startHardwareCounters();
+    }
+    double startTime = getTimeInSeconds();
+    if (mode == RECORD_SORT_DIRECT) {
+        algorithm->typedFunction(records, n);
+    } else {
+        indirectSort(records, n, recordType, algorithm, mode);
+    }
+    double endTime = getTimeInSeconds();
+    if (result != NULL) {
+        stopHardwareCounters(&result->counters);
+        OperationCounts operations = collectOperationCounts();
+        result->operations.comparisons += operations.comparisons;
+        result->operations.swaps += operations.swaps;
+        result->operations.moves += operations.moves;
+        MemoryCounts memory = collectMemoryCounts();
+        addMemoryCounts(&result->memory, &memory);
+    }
+
+    // The records must be sorted and still be the same records
+    if (!recordType->isSorted(records, n) || !isRecordPermutation(records, n, recordType->size, keys)) {
+        fprintf(stderr, "\n[%s] Records are not sorted (N: %d, %s, mode %d)\n", algorithm->name, n, recordType->name, mode);
+        exit(EXIT_FAILURE);
+    }
+    freeTimedArray(records, recordsSize);
+    return endTime - startTime;
+}
+double timeSelection(int operation, const unsigned long int *keys, int n, int k, const unsigned long int *sortedKeys, BenchmarkResult *result) {
+    size_t arraySize = (n > 0 ? (size_t)n : 1) * sizeof(unsigned long int);
+    unsigned long int *array = (unsigned long int *)allocateTimedArray(arraySize);
+    unsigned long int *smallest = (unsigned long int *)malloc((k > 0 ? (size_t)k : 1) * sizeof(unsigned long int));
+    if (array == NULL || smallest == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(array, keys, (size_t)n * sizeof(unsigned long int));
+
+    resetOperationCounts();
+    resetScratchMemory();
+    prepareCaches();
+    if (result != NULL) {
+        startHardwareCounters();
+    }
+    double startTime = getTimeInSeconds();
+    if (operation == SELECTION_NTH_ELEMENT) {
+        introSelect(array, n, k - 1);
+    } else if (operation == SELECTION_TOP_K) {
+        topK(array, n, k, smallest);
+    } else {
+        partialSort(array, n, k);
+    }
+    double endTime = getTimeInSeconds();
+    if (result != NULL) {
+        stopHardwareCounters(&result->counters);
+        OperationCounts operations = collectOperationCounts();
+        result->operations.comparisons += operations.comparisons;
+        result->operations.swaps += operations.swaps;
+        result->operations.moves += operations.moves;
+        MemoryCounts memory = collectMemoryCounts();
+        addMemoryCounts(&result->memory, &memory);
+    }
+
+    // The k-th key must be in place with nothing larger before it, the k smallest must be the first k sorted keys
+    int isCorrect = 1;
+    if (operation == SELECTION_NTH_ELEMENT) {
+        isCorrect = array[k - 1] == sortedKeys[k - 1];
+        for (int i = 0; i < n && isCorrect; i++) {
+            isCorrect = i < k - 1 ? array[i] <= array[k - 1] : array[i] >= array[k - 1];
+        }
+    } else if (operation == SELECTION_TOP_K) {
+        introSort(smallest, k);
+        isCorrect = memcmp(smallest, sortedKeys, (size_t)k * sizeof(unsigned long int)) == 0;
+    } else {
+        isCorrect = memcmp(array, sortedKeys, (size_t)k * sizeof(unsigned long int)) == 0;
+    }
+    if (!isCorrect) {
+        fprintf(stderr, "\n[%s] Wrong selection (N: %d, k: %d)\n", result != NULL ? result->algorithm->name : "Selection", n, k);
+        exit(EXIT_FAILURE);
+    }
+
+    free(smallest);
+    freeTimedArray(array, arraySize);
+    return endTime - startTime;
+}
+int isTypedVersionOf(const SortingAlgorithm *typedAlgorithm, const SortingAlgorithm *algorithm) {
+    size_t nameLength = strlen(algorithm->name);
+    return strncmp(typedAlgorithm->name, algorithm->name, nameLength) == 0 && strncmp(typedAlgorithm->name + nameLength, " (", 2) == 0;
+}
+void appendCsvHeader(const BatchOptions *options) {
+    if (options->csvFile == NULL) {
+        return;
+    }
+    appendStringToFile(options->csvFile, "N,Method,Seed,Algorithm,Threads,Repetitions,Timing,Status,Min,Median,Mean,Stddev,"
+        "Cycles,Instructions,L1D Misses,LLC Misses,Branch Misses,dTLB Misses,"
+        "Peak Scratch Bytes,Allocations,Malloc Allocations,Allocator Time");
+    #ifdef COUNT_OPERATIONS
+        appendStringToFile(options->csvFile, ",Comparisons,Swaps,Moves,Kernels");
+    #endif
+    appendStringToFile(options->csvFile, "\n");
+}
+void measureAlgorithm(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, const BatchOptions *options, double *samples, BenchmarkResult *result, int reportFd) {
+    sortBoundaryFd = reportFd;
+    for (int r = 0; r < options->warmups; r++) {
+        double time = timeSortingAlgorithm(algorithm, array, n, NULL, NULL);
+        if (reportFd != -1) {
+            writeChunk(reportFd, (const char *)&time, sizeof(time));
+        }
+    }
+    // The last run keeps its sorted copy for the output file
+    unsigned long int *sortedArr = NULL;
+    for (int r = 0; r < options->repetitions; r++) {
+        int isLast = r == options->repetitions - 1;
+        samples[r] = timeSortingAlgorithm(algorithm, array, n, isLast ? &sortedArr : NULL, result);
+        if (reportFd != -1) {
+            writeChunk(reportFd, (const char *)&samples[r], sizeof(samples[r]));
+        }
+    }
+    sortBoundaryFd = -1;
+    // Sent before the output file is written, so that the parent doesn't wait for it
+    if (reportFd != -1) {
+        writeChunk(reportFd, (const char *)&result->counters, sizeof(result->counters));
+        writeChunk(reportFd, (const char *)&result->operations, sizeof(result->operations));
+        writeChunk(reportFd, (const char *)&result->memory, sizeof(result->memory));
+    }
+    if (sortedArr != NULL) {
+        char title[256];
+        snprintf(title, sizeof(title), "\n%s Sorted Array | Number of elements (N): %d | Time take: %.9lf\n\n",
+            algorithm->name, n, samples[options->repetitions - 1]);
+        writeArrayOutput(algorithm->outputFile, title, sortedArr, n);
+        freeTimedArray(sortedArr, (n > 0 ? (size_t)n : 1) * sizeof(unsigned long int));
+    }
+}
+int measureAlgorithmWithBudget(const SortingAlgorithm *algorithm, const unsigned long int *array, int n, const BatchOptions *options, double *samples, BenchmarkResult *result) {
+#ifdef _WIN32
+    // No fork() on Windows: the cells predicted to run out of time are still skipped
+    measureAlgorithm(algorithm, array, n, options, samples, result, -1);
+    return RESULT_COMPLETED;
+#else
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        perror("Pipe creation failed");
+        exit(EXIT_FAILURE);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("Fork failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (child == 0) {
+        // The child reports every run as it ends, then the counters and memory of its timed runs.
+        // The counters of the parent count the parent, the child opens its own.
+        close(pipeFds[0]);
+        if (hardwareCountersAvailable > 0) {
+            closeHardwareCounters();
+            openHardwareCounters();
+        }
+        measureAlgorithm(algorithm, array, n, options, samples, result, pipeFds[1]);
+        _exit(EXIT_SUCCESS);
+    }
+
+    // Every sort must end within the budget of its start marker. The copy of the input, the
+    // cache flush and the sortedness check around it are not part of the budget.
+    close(pipeFds[1]);
+    int status = RESULT_COMPLETED;
+    int isReceived = 1;
+    for (int r = 0; r < options->warmups + options->repetitions && isReceived == 1; r++) {
+        char marker;
+        double time;
+        isReceived = readWithDeadline(pipeFds[0], &marker, sizeof(marker), INFINITY);
+        if (isReceived == 1) {
+            isReceived = readWithDeadline(pipeFds[0], &marker, sizeof(marker), getTimeInSeconds() + options->timeBudget);
+        }
+        if (isReceived == 1) {
+            isReceived = readWithDeadline(pipeFds[0], &time, sizeof(time), INFINITY);
+        }
+        if (isReceived == 1 && r >= options->warmups) {
+            samples[r - options->warmups] = time;
+        }
+    }
+    if (isReceived == 1) {
+        isReceived = readWithDeadline(pipeFds[0], &result->counters, sizeof(result->counters), INFINITY);
+    }
+    if (isReceived == 1) {
+        isReceived = readWithDeadline(pipeFds[0], &result->operations, sizeof(result->operations), INFINITY);
+    }
+    if (isReceived == 1) {
+        isReceived = readWithDeadline(pipeFds[0], &result->memory, sizeof(result->memory), INFINITY);
+    }
+    if (isReceived == -1) {
+        kill(child, SIGKILL);
+        status = RESULT_TIMED_OUT;
+    }
+    close(pipeFds[0]);
+
+    // Past the deadline, the child may still be writing the output file
+    int childStatus;
+    waitpid(child, &childStatus, 0);
+    if (status == RESULT_COMPLETED && (isReceived != 1 || !WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != EXIT_SUCCESS)) {
+        // The child already reported what went wrong (e.g. an unsorted output), stop like an in-process run would
+        fprintf(stderr, "[%s] The benchmark process failed (N: %d)\n", algorithm->name, n);
+        exit(EXIT_FAILURE);
+    }
+    return status;
+#endif
+}
+int readWithDeadline(int fileDescriptor, void *buffer, size_t size, double deadline) {
+#ifdef _WIN32
+    (void)deadline;
+    return read(fileDescriptor, buffer, (unsigned int)size) == (int)size ? 1 : 0;
+#else
+    char *bytes = (char *)buffer;
+    size_t received = 0;
+    while (received < size) {
+        double remaining = deadline - getTimeInSeconds();
+        if (remaining <= 0.0) {
+            return -1;
+        }
+        struct pollfd request = {fileDescriptor, POLLIN, 0};
+        int ready = poll(&request, 1, isinf(deadline) ? -1 : (int)(remaining * 1000.0) + 1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            return 0;
+        }
+        if (ready == 0) {
+            continue;
+        }
+        ssize_t count = read(fileDescriptor, bytes + received, size - received);
+        if (count <= 0) {
+            return 0;
+        }
+        received += (size_t)count;
+    }
+    return 1;
+#endif
+}
+double complexityGrowth(int complexity, double n) {
+    if (n < 2.0) {
+        n = 2.0;
+    }
+    switch (complexity) {
+        case COMPLEXITY_LINEAR:
+            return n;
+        case COMPLEXITY_N_LOG_N:
+            return n * log2(n);
+        default:
+            return n * n;
+    }
+}
+double predictSortingTime(const TimingHistory *history, int complexity, int n) {
+    // Fit on the three largest N, the smallest ones are dominated by fixed costs
+    int chosen[3];
+    int chosenCount = 0;
+    for (int i = 0; i < history->count; i++) {
+        if (history->times[i] <= 0.0) continue;
+        int position = chosenCount < 3 ? chosenCount++ : 3;
+        while (position > 0 && history->sizes[chosen[position - 1]] < history->sizes[i]) {
+            if (position < 3) {
+                chosen[position] = chosen[position - 1];
+            }
+            position--;
+        }
+        if (position < 3) {
+            chosen[position] = i;
+        }
+    }
+    if (chosenCount == 0) {
+        return 0.0;
+    }
+
+    // Least squares fit of time = c * growth(N) on relative errors, for each class up to the
+    // algorithm's worst case. A lower class only wins when it fits clearly better, which needs
+    // two points or more (e.g. insertion sort on increasing data grows linearly).
+    double prediction = 0.0;
+    double bestResidual = INFINITY;
+    for (int class = complexity; class >= COMPLEXITY_LINEAR; class--) {
+        double numerator = 0.0, denominator = 0.0;
+        for (int j = 0; j < chosenCount; j++) {
+            double ratio = complexityGrowth(class, history->sizes[chosen[j]]) / history->times[chosen[j]];
+            numerator += ratio;
+            denominator += ratio * ratio;
+        }
+        double coefficient = numerator / denominator;
+        double residual = 0.0;
+        for (int j = 0; j < chosenCount; j++) {
+            double error = coefficient * complexityGrowth(class, history->sizes[chosen[j]]) / history->times[chosen[j]] - 1.0;
+            residual += error * error;
+        }
+        if (residual < bestResidual - 1e-9) {
+            bestResidual = residual;
+            prediction = coefficient * complexityGrowth(class, n);
+        }
+    }
+    return prediction;
+}
+void appendResultToCsv(const BatchOptions *options, int n, const char *methodName, const BenchmarkResult *result) {
+    if (options->csvFile == NULL) {
+        return;
+    }
+
+    const char *statuses[] = {"completed", "timed out", "skipped"};
+    appendStringToFile(options->csvFile, "%d,%s,%u,%s,%d,%d,%s,%s", n, methodName, options->generation.seed,
+        result->algorithm->name, result->threads, options->repetitions, timingModeNames[timingMode], statuses[result->status]);
+    if (result->status != RESULT_COMPLETED) {
+        // No statistics, counters or operations, the kernels keep the columns of the header
+        appendStringToFile(options->csvFile, ",,,,");
+        for (int c = 0; c < HARDWARE_COUNTERS_SIZE; c++) {
+            appendStringToFile(options->csvFile, ",");
+        }
+        appendStringToFile(options->csvFile, ",,,,");
+        #ifdef COUNT_OPERATIONS
+            appendStringToFile(options->csvFile, ",,,,%s", simdKernelLevel);
+        #endif
+        appendStringToFile(options->csvFile, "\n");
+        return;
+    }
+
+    appendStringToFile(options->csvFile, ",%.9lf,%.9lf,%.9lf,%.9lf",
+        result->stats.min, result->stats.median, result->stats.mean, result->stats.stddev);
+    // Events per run, left empty when they could not be counted
+    for (int c = 0; c < HARDWARE_COUNTERS_SIZE; c++) {
+        if (hardwareCounterFds[c] >= 0 && result->counters.runs > 0) {
+            appendStringToFile(options->csvFile, ",%.0lf", result->counters.values[c] / result->counters.runs);
+        } else {
+            appendStringToFile(options->csvFile, ",");
+        }
+    }
+    // Scratch memory per run, the peak of the largest run
+    appendStringToFile(options->csvFile, ",%llu,%.0lf,%.0lf,%.9lf", result->memory.peakBytes,
+        (double)result->memory.allocations / options->repetitions,
+        (double)result->memory.systemAllocations / options->repetitions,
+        result->memory.allocatorTime / options->repetitions);
+    #ifdef COUNT_OPERATIONS
+        appendStringToFile(options->csvFile, ",%.0lf,%.0lf,%.0lf,%s",
+            (double)result->operations.comparisons / options->repetitions,
+            (double)result->operations.swaps / options->repetitions,
+            (double)result->operations.moves / options->repetitions, simdKernelLevel);
+    #endif
+    appendStringToFile(options->csvFile, "\n");
+}
+unsigned long long parseByteSize(const char *text) {
+    // strtoull() skips spaces and takes "-1" as ULLONG_MAX, only digits may come first
+    if (!isdigit((unsigned char)text[0])) {
+        return 0;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long size = strtoull(text, &end, 10);
+    int shift = 0;
+    switch (toupper((unsigned char)*end)) {
+        case 'G':
+            shift = 30;
+            end++;
+            break;
+        case 'M':
+            shift = 20;
+            end++;
+            break;
+        case 'K':
+            shift = 10;
+            end++;
+            break;
+        default:
+            break;
+    }
+    if (errno == ERANGE || size > (ULLONG_MAX >> shift) || (*end != '\0' && (toupper((unsigned char)*end) != 'B' || end[1] != '\0'))) {
+        return 0;
+    }
+    return size << shift;
+}
+int parseWholeNumber(const char *text, unsigned long int maximum, unsigned long int *number) {
+    // strtoul() alone takes "12abc" as 12 and "-1" as ULONG_MAX
+    if (text[0] == '\0' || strspn(text, "0123456789") != strlen(text)) {
+        return 0;
+    }
+    errno = 0;
+    unsigned long int value = strtoul(text, NULL, 10);
+    if (errno == ERANGE || value > maximum) {
+        return 0;
+    }
+    *number = value;
+    return 1;
+}
+int parseDecimalNumber(const char *text, double minimum, double maximum, double *number) {
+    // atof() takes "12abc" as 12 and "" as 0, strtod() alone also skips spaces and reads "nan"
+    if (!isdigit((unsigned char)text[0]) && text[0] != '.') {
+        return 0;
+    }
+    char *end;
+    double value = strtod(text, &end);
+    if (*end != '\0' || !isfinite(value) || value < minimum || value > maximum) {
+        return 0;
+    }
+    *number = value;
+    return 1;
+}
+
+/*
+*
+* EXTERNAL SORT
+*
+*/
+int runExternalSort(const BatchOptions *options) {
+    // Run files hold the keys as they are in memory, which must match the input layout
+    const uint16_t endianTest = 1;
+    if (sizeof(unsigned long int) != 8 || *(const unsigned char *)&endianTest != 1) {
+        fprintf(stderr, "The external sort needs 64-bit little-endian unsigned long int\n");
+        return 0;
+    }
+
+    // The first selected algorithm sorts the chunks, SIMD Quick Sort by default as it is in place
+    const SortingAlgorithm *algorithm = NULL;
+    int allSelected = 1;
+    for (int i = 0; i < algorithmsSize; i++) {
+        allSelected = allSelected && options->selectedAlgorithms[i];
+    }
+    for (int i = 0; i < algorithmsSize && algorithm == NULL; i++) {
+        if (allSelected ? strcmp(algorithms[i].name, "SIMD Quick Sort") == 0 : options->selectedAlgorithms[i]) {
+            algorithm = &algorithms[i];
+        }
+    }
+    if (algorithm->isParallel) {
+        sortingThreads = options->threads[0];
+    }
+
+    FILE *input = fopen(options->externalInput, "rb");
+    if (input == NULL) {
+        fprintf(stderr, "Error opening file: %s\n", options->externalInput);
+        return 0;
+    }
+
+    // Chunks leave room in the budget for the scratch memory of the algorithm, e.g. half for merge sort
+    double scratchPerKey = measureScratchPerKey(algorithm);
+    displayHeader();
+    printf("\nExternal sort: %s -> %s", options->externalInput, options->externalOutput);
+    printf("\nMemory budget: %lluMB | Algorithm: %s (%.1lf scratch bytes/key)\n", options->memoryBudget >> 20, algorithm->name, scratchPerKey);
+
+    // Phase 1: sort chunks that fill the memory budget and write them as runs
+    size_t chunkKeys = (size_t)(options->memoryBudget / (sizeof(unsigned long int) + scratchPerKey));
+    if (chunkKeys > INT_MAX) {
+        chunkKeys = INT_MAX;
+    }
+    int runsCount = 0;
+    int runsCapacity = 16;
+    unsigned long int *chunk = (unsigned long int *)malloc(chunkKeys * sizeof(unsigned long int));
+    char (*runNames)[512] = malloc(runsCapacity * sizeof(*runNames));
+    if (chunk == NULL || runNames == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        fclose(input);
+        free(chunk);
+        free(runNames);
+        return 0;
+    }
+
+    // Every error from here on goes through the cleanup at the end, which removes the runs
+    int isSuccessful = 1;
+    double startTime = getTimeInSeconds();
+    unsigned long long totalKeys = 0;
+    while (1) {
+        // A short read is the end of the file unless ferror says otherwise
+        size_t bytes = fread(chunk, 1, chunkKeys * sizeof(unsigned long int), input);
+        if (ferror(input)) {
+            fprintf(stderr, "Error reading file: %s\n", options->externalInput);
+            isSuccessful = 0;
+            break;
+        }
+        if (bytes % sizeof(unsigned long int) != 0) {
+            fprintf(stderr, "Not a file of 64-bit keys, it ends with a partial key: %s\n", options->externalInput);
+            isSuccessful = 0;
+            break;
+        }
+        size_t count = bytes / sizeof(unsigned long int);
+        if (count == 0) break;
+        totalKeys += count;
+
+        fprintf(stderr, "[Run %d] Sorting %zu keys...\n", runsCount + 1, count);
+        algorithm->function(chunk, (int)count);
+
+        if (runsCount == runsCapacity) {
+            char (*grownNames)[512] = realloc(runNames, 2 * runsCapacity * sizeof(*runNames));
+            if (grownNames == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                isSuccessful = 0;
+                break;
+            }
+            runNames = grownNames;
+            runsCapacity *= 2;
+        }
+        snprintf(runNames[runsCount], sizeof(runNames[runsCount]), "%s/sort-run-%ld-%d.tmp",
+            options->temporaryDirectory, (long)getpid(), runsCount);
+        FILE *runFile = fopen(runNames[runsCount], "wb");
+        if (runFile == NULL) {
+            fprintf(stderr, "Error opening file: %s\n", runNames[runsCount]);
+            isSuccessful = 0;
+            break;
+        }
+        // The run exists from here on, even half written it has to be removed
+        runsCount++;
+        int isWritten = fwrite(chunk, sizeof(unsigned long int), count, runFile) == count;
+        if (fclose(runFile) != 0 || !isWritten) {
+            fprintf(stderr, "Error writing file: %s\n", runNames[runsCount - 1]);
+            isSuccessful = 0;
+            break;
+        }
+        if (count < chunkKeys) break;
+    }
+    fclose(input);
+    free(chunk);
+    double runsTime = getTimeInSeconds() - startTime;
+    int chunkRuns = runsCount;
+
+    // Phase 2: merge the runs. Each run gets two read buffers and the output one more, all of
+    // the same size. Past the runs that fit buffers of EXTERNAL_MIN_BUFFER_KEYS in the budget,
+    // groups of runs are merged into longer runs first, the first ones merged first.
+    double mergeStartTime = getTimeInSeconds();
+    size_t budgetKeys = (size_t)(options->memoryBudget / sizeof(unsigned long int));
+    int fanIn = (int)((budgetKeys / EXTERNAL_MIN_BUFFER_KEYS - 1) / 2);
+    if (fanIn < 2) {
+        fanIn = 2;
+    }
+    int firstRun = 0;
+    int mergePasses = 0;
+    while (isSuccessful && runsCount - firstRun > fanIn) {
+        if (runsCount == runsCapacity) {
+            char (*grownNames)[512] = realloc(runNames, 2 * runsCapacity * sizeof(*runNames));
+            if (grownNames == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                isSuccessful = 0;
+                break;
+            }
+            runNames = grownNames;
+            runsCapacity *= 2;
+        }
+        snprintf(runNames[runsCount], sizeof(runNames[runsCount]), "%s/sort-run-%ld-%d.tmp",
+            options->temporaryDirectory, (long)getpid(), runsCount);
+        FILE *runFile = fopen(runNames[runsCount], "wb");
+        if (runFile == NULL) {
+            fprintf(stderr, "Error opening file: %s\n", runNames[runsCount]);
+            isSuccessful = 0;
+            break;
+        }
+        runsCount++;
+        fprintf(stderr, "[Merge] Runs %d to %d into run %d...\n", firstRun + 1, firstRun + fanIn, runsCount);
+        isSuccessful = mergeRunFiles(runNames + firstRun, fanIn, budgetKeys / (2 * fanIn + 1), runFile,
+            runNames[runsCount - 1], options->temporaryDirectory);
+        if (fclose(runFile) != 0 && isSuccessful) {
+            fprintf(stderr, "Error writing file: %s\n", runNames[runsCount - 1]);
+            isSuccessful = 0;
+        }
+        // The merged runs are removed right away, the disk holds the keys about once
+        for (int r = firstRun; r < firstRun + fanIn; r++) {
+            remove(runNames[r]);
+        }
+        firstRun += fanIn;
+        mergePasses++;
+    }
+
+    FILE *output = NULL;
+    if (isSuccessful) {
+        output = fopen(options->externalOutput, "wb");
+        if (output == NULL) {
+            fprintf(stderr, "Error opening file: %s\n", options->externalOutput);
+            isSuccessful = 0;
+        }
+    }
+    if (output != NULL && runsCount > firstRun) {
+        int k = runsCount - firstRun;
+        isSuccessful = mergeRunFiles(runNames + firstRun, k, budgetKeys / (2 * k + 1), output,
+            options->externalOutput, options->temporaryDirectory);
+    }
+    if (output != NULL && fclose(output) != 0) {
+        fprintf(stderr, "Error writing file: %s\n", options->externalOutput);
+        isSuccessful = 0;
+    }
+    // A partial output must not pass for a sorted file
+    if (output != NULL && !isSuccessful) {
+        remove(options->externalOutput);
+    }
+
+    for (int r = firstRun; r < runsCount; r++) {
+        remove(runNames[r]);
+    }
+    free(runNames);
+    if (!isSuccessful) {
+        return 0;
+    }
+    double mergeTime = getTimeInSeconds() - mergeStartTime;
+    double totalTime = runsTime + mergeTime;
+
+    double megabytes = (double)totalKeys * sizeof(unsigned long int) / (1024.0 * 1024.0);
+    printf("\nKeys: %llu (%.1lfMB) | Runs: %d | Intermediate merges: %d", totalKeys, megabytes, chunkRuns, mergePasses);
+    printf("\nRun generation: %.3lfsecs | Merge: %.3lfsecs | Total: %.3lfsecs (%.1lfMB/s)\n",
+        runsTime, mergeTime, totalTime, totalTime > 0.0 ? megabytes / totalTime : 0.0);
+    return isSuccessful;
+}
+int mergeRunFiles(char (*runNames)[512], int k, size_t bufferKeys, FILE *output, const char *outputName, const char *temporaryDirectory) {
+    int isSuccessful = 1;
+    PrefetchQueue queue;
+    queue.runs = (ExternalRun *)calloc(k, sizeof(ExternalRun));
+    queue.runsCount = k;
+    queue.bufferKeys = bufferKeys;
+    queue.requests = (int *)malloc((2 * k + 1) * sizeof(int));
+    queue.requestsHead = 0;
+    queue.requestsTail = 0;
+    queue.stop = 0;
+    queue.isReadFailed = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.requested, NULL);
+    pthread_cond_init(&queue.filled, NULL);
+    unsigned long int *outputBuffer = (unsigned long int *)malloc(bufferKeys * sizeof(unsigned long int));
+    int *tree = (int *)malloc(k * sizeof(int));
+    int isReady = queue.runs != NULL && queue.requests != NULL && outputBuffer != NULL && tree != NULL;
+    if (!isReady) {
+        fprintf(stderr, "Memory allocation failed\n");
+    }
+
+    for (int r = 0; r < k && isReady; r++) {
+        ExternalRun *run = &queue.runs[r];
+        run->file = fopen(runNames[r], "rb");
+        run->buffers[0] = (unsigned long int *)malloc(bufferKeys * sizeof(unsigned long int));
+        run->buffers[1] = (unsigned long int *)malloc(bufferKeys * sizeof(unsigned long int));
+        if (run->file == NULL || run->buffers[0] == NULL || run->buffers[1] == NULL) {
+            fprintf(stderr, "Error reading run: %s\n", runNames[r]);
+            isReady = 0;
+        }
+    }
+
+    if (isReady) {
+        // Both buffers of every run are filled in file order by the background thread
+        pthread_t prefetchThread;
+        pthread_create(&prefetchThread, NULL, prefetchWorker, &queue);
+        for (int r = 0; r < k; r++) {
+            requestRunBuffer(&queue, r, 0);
+            requestRunBuffer(&queue, r, 1);
+        }
+        pthread_mutex_lock(&queue.lock);
+        for (int r = 0; r < k; r++) {
+            while (!queue.runs[r].ready[0]) {
+                pthread_cond_wait(&queue.filled, &queue.lock);
+            }
+            queue.runs[r].finished = queue.runs[r].counts[0] == 0;
+        }
+        int isReadFailed = queue.isReadFailed;
+        pthread_mutex_unlock(&queue.lock);
+
+        // k-way merge: output the winner of the loser tree, advance its run and replay its path
+        initializeLoserTree(tree, queue.runs, k);
+        size_t outputUsed = 0;
+        while (!isReadFailed && !queue.runs[tree[0]].finished) {
+            int winner = tree[0];
+            ExternalRun *run = &queue.runs[winner];
+            outputBuffer[outputUsed++] = run->buffers[run->current][run->position];
+            if (outputUsed == bufferKeys) {
+                if (fwrite(outputBuffer, sizeof(unsigned long int), outputUsed, output) != outputUsed) {
+                    isSuccessful = 0;
+                    break;
+                }
+                outputUsed = 0;
+            }
+            isReadFailed = !advanceRun(&queue, winner);
+            replayLoserTree(tree, queue.runs, k, winner);
+        }
+        if (fwrite(outputBuffer, sizeof(unsigned long int), outputUsed, output) != outputUsed) {
+            isSuccessful = 0;
+        }
+        if (!isSuccessful) {
+            fprintf(stderr, "Error writing file: %s\n", outputName);
+        }
+        if (isReadFailed) {
+            fprintf(stderr, "Error reading the runs in: %s\n", temporaryDirectory);
+            isSuccessful = 0;
+        }
+
+        pthread_mutex_lock(&queue.lock);
+        queue.stop = 1;
+        pthread_cond_signal(&queue.requested);
+        pthread_mutex_unlock(&queue.lock);
+        pthread_join(prefetchThread, NULL);
+    } else {
+        isSuccessful = 0;
+    }
+
+    for (int r = 0; queue.runs != NULL && r < k; r++) {
+        if (queue.runs[r].file != NULL) fclose(queue.runs[r].file);
+        free(queue.runs[r].buffers[0]);
+        free(queue.runs[r].buffers[1]);
+    }
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.requested);
+    pthread_cond_destroy(&queue.filled);
+    free(queue.runs);
+    free(queue.requests);
+    free(outputBuffer);
+    free(tree);
+    return isSuccessful;
+}
+double measureScratchPerKey(const SortingAlgorithm *algorithm) {
+    unsigned long int *keys = (unsigned long int *)malloc(EXTERNAL_SCRATCH_PROBE_KEYS * sizeof(unsigned long int));
+    if (keys == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < EXTERNAL_SCRATCH_PROBE_KEYS; i++) {
+        keys[i] = (unsigned long int)scrambleKey((uint64_t)i);
+    }
+    resetScratchMemory();
+    algorithm->function(keys, EXTERNAL_SCRATCH_PROBE_KEYS);
+    MemoryCounts memory = collectMemoryCounts();
+    free(keys);
+    return (double)memory.peakBytes / EXTERNAL_SCRATCH_PROBE_KEYS;
+}
+int loserTreeLess(const ExternalRun *runs, int a, int b) {
+    // Finished runs lose every match so they sink to the bottom
+    if (runs[a].finished) return 0;
+    if (runs[b].finished) return 1;
+    unsigned long int keyA = runs[a].buffers[runs[a].current][runs[a].position];
+    unsigned long int keyB = runs[b].buffers[runs[b].current][runs[b].position];
+    return keyA < keyB || (keyA == keyB && a < b);
+}
+int playLoserTree(int *tree, const ExternalRun *runs, int k, int node) {
+    if (node >= k) {
+        return node - k;
+    }
+    int left = playLoserTree(tree, runs, k, 2 * node);
+    int right = playLoserTree(tree, runs, k, 2 * node + 1);
+    if (loserTreeLess(runs, left, right)) {
+        tree[node] = right;
+        return left;
+    }
+    tree[node] = left;
+    return right;
+}
+void initializeLoserTree(int *tree, const ExternalRun *runs, int k) {
+    tree[0] = k == 1 ? 0 : playLoserTree(tree, runs, k, 1);
+}
+void replayLoserTree(int *tree, const ExternalRun *runs, int k, int run) {
+    int winner = run;
+    for (int node = (run + k) / 2; node >= 1; node /= 2) {
+        if (loserTreeLess(runs, tree[node], winner)) {
+            int temp = tree[node];
+            tree[node] = winner;
+            winner = temp;
+        }
+    }
+    tree[0] = winner;
+}
+void requestRunBuffer(PrefetchQueue *queue, int run, int buffer) {
+    pthread_mutex_lock(&queue->lock);
+    queue->runs[run].ready[buffer] = 0;
+    queue->requests[queue->requestsTail] = run * 2 + buffer;
+    queue->requestsTail = (queue->requestsTail + 1) % (2 * queue->runsCount + 1);
+    pthread_cond_signal(&queue->requested);
+    pthread_mutex_unlock(&queue->lock);
+}
+void *prefetchWorker(void *argument) {
+    PrefetchQueue *queue = (PrefetchQueue *)argument;
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->requestsHead == queue->requestsTail && !queue->stop) {
+            pthread_cond_wait(&queue->requested, &queue->lock);
+        }
+        if (queue->stop) {
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+        int request = queue->requests[queue->requestsHead];
+        queue->requestsHead = (queue->requestsHead + 1) % (2 * queue->runsCount + 1);
+        pthread_mutex_unlock(&queue->lock);
+
+        // Read without holding the lock so the merge keeps going meanwhile
+        ExternalRun *run = &queue->runs[request / 2];
+        int buffer = request % 2;
+        size_t count = fread(run->buffers[buffer], sizeof(unsigned long int), queue->bufferKeys, run->file);
+        int isReadFailed = count < queue->bufferKeys && ferror(run->file);
+
+        pthread_mutex_lock(&queue->lock);
+        queue->isReadFailed = queue->isReadFailed || isReadFailed;
+        run->counts[buffer] = count;
+        run->ready[buffer] = 1;
+        pthread_cond_broadcast(&queue->filled);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return NULL;
+}
+int advanceRun(PrefetchQueue *queue, int run) {
+    ExternalRun *current = &queue->runs[run];
+    current->position++;
+    if (current->position < current->counts[current->current]) {
+        return 1;
+    }
+
+    // The current buffer is used up: refill it in the background and switch to the other one
+    int usedBuffer = current->current;
+    current->current = 1 - usedBuffer;
+    current->position = 0;
+    if (current->counts[usedBuffer] == queue->bufferKeys) {
+        requestRunBuffer(queue, run, usedBuffer);
+    } else {
+        // A short buffer was the end of the file, there is nothing left to read
+        current->counts[usedBuffer] = 0;
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    while (!current->ready[current->current]) {
+        pthread_cond_wait(&queue->filled, &queue->lock);
+    }
+    current->finished = current->counts[current->current] == 0;
+    int isReadFailed = queue->isReadFailed;
+    pthread_mutex_unlock(&queue->lock);
+    return !isReadFailed;
+}
+void displayBatchUsage(const char *programName) {
+    printf("Usage: %s [options]\n", programName);
+    printf("Runs the benchmarks without prompts. Without options, the interactive menu is shown.\n\n");
+    printf("  -n, --sizes LIST        N values, e.g. 1000,5000 or 1000:1000000:x10 or 1000:5000:1000 (default: 1000)\n");
+    printf("  -m, --methods LIST      Data generation methods by number or name (default: 1)\n");
+    for (int i = 0; i < dataGenerationMethodsSize; i++) {
+        printf("                            %d) %s\n", i+1, dataGenerationMethods[i]);
+    }
+    printf("  -a, --algorithms LIST   Algorithms by number or name, e.g. merge-sort,quick (default: all)\n");
+    for (int i = 0; i < algorithmsSize; i++) {
+        printf("                            %d) %s\n", i+1, algorithms[i].name);
+    }
+    printf("      --types LIST        Run the typed merge, intro, heap and LSD radix sorts on these element types\n");
+    printf("                          instead, e.g. u32,f64 or all (the same keys converted to each type):\n");
+    for (int i = 0; i < elementTypesSize; i++) {
+        printf("                            %s) %s\n", elementTypes[i].name, elementTypes[i].description);
+    }
+    printf("      --records LIST      Compare sorting records of these sizes in bytes directly with sorting\n");
+    printf("                          (key, index) pairs and then moving the records, e.g. 16,64,256\n");
+    printf("  -t, --threads LIST      Thread counts of the parallel algorithms, same syntax as N, e.g. 1:%d (default: %d)\n", sortingThreads, sortingThreads);
+    printf("      --scaling TABLES    Run only the parallel algorithms and print strong scaling (same N on every\n");
+    printf("                          thread count), weak scaling (N is per thread) or both tables\n");
+    printf("      --select RATIOS     Time selecting the k smallest keys (introselect, bounded heap top-k and partial\n");
+    printf("                          sort) against sorting every key with the first algorithm of --algorithms\n");
+    printf("                          (default: Intro Sort), at these k / N, e.g. 0.0001,0.01,0.5\n");
+    printf("      --calibrate FILE    Time the crossovers of Auto Sort (sort_u64) on this machine and save them to FILE\n");
+    printf("      --thresholds FILE   Thresholds of Auto Sort saved by --calibrate (default: built-in)\n");
+    printf("      --pin on|off        Pin the threads of the parallel sample and radix sorts to one processor each\n");
+    printf("                          (default: off)\n");
+    printf("      --timing MODE       State of the data when the timer starts: warm (just written, in the caches as far\n");
+    printf("                          as it fits), cold (evicted by reading twice the last level cache) or huge (warm,\n");
+    printf("                          in huge pages along with the scratch space of the sorts) (default: warm)\n");
+    printf("      --arena on|off      Take the scratch space of the sorts from an arena kept between runs instead of\n");
+    printf("                          malloc (default: on)\n");
+    printf("      --simd LEVEL        Kernels of the hot loops: auto, avx512, avx2 or scalar (default: auto)\n");
+    printf("  -s, --seed S            Seed of the random integers (default: current time)\n");
+    printf("  -x, --start X           Smallest key of the increasing, reversed, nearly sorted, organ pipe\n");
+    printf("                          and sawtooth data (default: 0)\n");
+    printf("      --swaps K           Percentage of N randomly swapped in the nearly sorted data (default: 1)\n");
+    printf("      --unique K          Number of distinct keys of the few unique data (default: 16)\n");
+    printf("      --runs R            Number of increasing runs of the sawtooth data (default: 16)\n");
+    printf("      --zipf S            Exponent of the Zipf data, higher repeats the frequent keys more (default: 1)\n");
+    printf("  -r, --repetitions R     Timed runs per algorithm (default: 5)\n");
+    printf("  -w, --warmup W          Untimed runs per algorithm before timing (default: 1)\n");
+    printf("  -b, --budget SECONDS    Longest a single run may take. Each algorithm runs in a child process that is\n");
+    printf("                          killed past the budget, and larger N predicted to exceed it are skipped\n");
+    printf("                          (default: no limit)\n");
+    printf("  -i, --input FILE        Data file for the \"From file\" method: raw 64-bit keys if it ends in .bin,\n");
+    printf("                          text as written by --output text otherwise (default N: every key in the file)\n");
+    printf("      --csv FILE          Append a row of statistics per (N, method, algorithm) to FILE\n");
+    printf("      --results FILE      Append a JSON record per (N, method, algorithm) with every timed run and the\n");
+    printf("                          commit, compiler and CPU to FILE, or none (default: results.jsonl)\n");
+    printf("      --compare OLD,NEW   Compare two results files instead of running the benchmarks. Exits with 1 when\n");
+    printf("                          a cell of NEW is significantly slower than in OLD\n");
+    printf("      --threshold PERCENT Smallest slowdown of the median that --compare reports (default: 5)\n");
+    printf("      --alpha P           Significance level of --compare (default: 0.05)\n");
+    printf("      --external FILE     Sort a file of raw 64-bit keys out of core instead of running the benchmarks,\n");
+    printf("                          with the first algorithm of --algorithms (default: SIMD Quick Sort)\n");
+    printf("      --external-output FILE  Sorted keys of --external (default: output/external-sorted.bin)\n");
+    printf("      --memory SIZE       Memory budget of --external, e.g. 512M or 16G (default: 1G)\n");
+    printf("      --temp-dir DIR      Directory of the sorted runs of --external (default: .)\n");
+    printf("      --stream FORMAT     Sort keys arriving on stdin as text or binary (raw 64-bit keys) instead of running\n");
+    printf("                          the benchmarks. Batches are sorted in the background by the first algorithm\n");
+    printf("                          of --algorithms (default: SIMD Quick Sort) while the input is read\n");
+    printf("      --stream-output FILE  Sorted keys of --stream as raw 64-bit keys, or none to only merge them\n");
+    printf("                          (default: output/stream-sorted.bin)\n");
+    printf("      --batch SIZE        Keys per sorted batch of --stream, in bytes, e.g. 64M (default: 8M)\n");
+    printf("      --snapshot SIZE     Also write the sorted keys of --stream every SIZE of keys read (rounded up to\n");
+    printf("                          whole batches), e.g. 1G (default: only at the end of the input)\n");
+    printf("  -o, --output FORMAT     Unsorted and sorted output files: none, text or binary (default: none)\n");
+    printf("  -h, --help              Show this message\n");
+}
+
+/*
+*
+* STREAMING SORT
+*
+*/
+int runStreamSort(const BatchOptions *options) {
+    // Binary input and the output have the memory layout of the keys, like the external sort
+    const uint16_t endianTest = 1;
+    if (sizeof(unsigned long int) != 8 || *(const unsigned char *)&endianTest != 1) {
+        fprintf(stderr, "The streaming sort needs 64-bit little-endian unsigned long int\n");
+        return 0;
+    }
+
+    // The first selected algorithm sorts the batches, SIMD Quick Sort by default as it is in place
+    StreamSorter sorter;
+    sorter.algorithm = NULL;
+    int allSelected = 1;
+    for (int i = 0; i < algorithmsSize; i++) {
+        allSelected = allSelected && options->selectedAlgorithms[i];
+    }
+    for (int i = 0; i < algorithmsSize && sorter.algorithm == NULL; i++) {
+        if (allSelected ? strcmp(algorithms[i].name, "SIMD Quick Sort") == 0 : options->selectedAlgorithms[i]) {
+            sorter.algorithm = &algorithms[i];
+        }
+    }
+    if (sorter.algorithm->isParallel) {
+        sortingThreads = options->threads[0];
+    }
+
+    StreamReader reader;
+    reader.fileDescriptor = 0;
+    reader.format = options->streamFormat;
+    reader.buffer = NULL;
+    reader.size = 0;
+    reader.position = 0;
+    reader.key = 0;
+    reader.isInKey = 0;
+    reader.isAtLineStart = 1;
+    reader.isLineSkipped = 0;
+    reader.carry = NULL;
+    reader.carryCount = 0;
+    reader.carryCapacity = 0;
+    reader.rejectedLines = 0;
+    reader.bytesRead = 0;
+    reader.isEnd = 0;
+    if (reader.format == OUTPUT_FORMAT_TEXT) {
+        reader.buffer = (char *)malloc(STREAM_READ_SIZE);
+        if (reader.buffer == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return 0;
+        }
+    }
+    #ifdef _WIN32
+        _setmode(reader.fileDescriptor, _O_BINARY);
+    #endif
+
+    size_t batchKeys = (size_t)(options->streamBatchSize / sizeof(unsigned long int));
+    size_t snapshotKeys = (size_t)(options->streamSnapshotSize / sizeof(unsigned long int));
+    displayHeader();
+    printf("\nStreaming sort: stdin (%s) -> %s", reader.format == OUTPUT_FORMAT_TEXT ? "text" : "binary",
+        options->streamOutput != NULL ? options->streamOutput : "none");
+    printf("\nBatch: %zu keys | Tier fan-out: %d | Algorithm: %s\n", batchKeys, STREAM_TIER_FANOUT, sorter.algorithm->name);
+    fflush(stdout);
+
+    sorter.pending = NULL;
+    sorter.pendingCount = 0;
+    sorter.isBusy = 0;
+    sorter.isEnd = 0;
+    memset(sorter.tierCounts, 0, sizeof(sorter.tierCounts));
+    sorter.sortTime = 0.0;
+    sorter.mergeTime = 0.0;
+    sorter.mergedKeys = 0;
+    pthread_mutex_init(&sorter.lock, NULL);
+    pthread_cond_init(&sorter.batchReady, NULL);
+    pthread_cond_init(&sorter.batchTaken, NULL);
+    pthread_t sortThread;
+    pthread_create(&sortThread, NULL, streamSortWorker, &sorter);
+
+    // Read a batch while the background thread sorts the one before it. Each batch becomes a
+    // run of the sorter, so a new one is allocated every time.
+    int isSuccessful = 1;
+    double startTime = getTimeInSeconds();
+    double stallTime = 0.0;
+    double snapshotTime = 0.0;
+    double longestSnapshot = 0.0;
+    int snapshotsCount = 0;
+    int batchesCount = 0;
+    unsigned long long totalKeys = 0;
+    unsigned long long nextSnapshot = snapshotKeys;
+    while (!reader.isEnd) {
+        unsigned long int *batch = (unsigned long int *)malloc(batchKeys * sizeof(unsigned long int));
+        if (batch == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        size_t count = readStreamKeys(&reader, batch, batchKeys);
+        if (count == 0) {
+            free(batch);
+            break;
+        }
+        totalKeys += count;
+        batchesCount++;
+
+        double handOffTime = getTimeInSeconds();
+        handOffStreamBatch(&sorter, batch, count);
+        stallTime += getTimeInSeconds() - handOffTime;
+
+        // Intermediate outputs stop the reading, they are timed apart from the end of the input
+        if (snapshotKeys > 0 && totalKeys >= nextSnapshot && !reader.isEnd) {
+            double snapshotStartTime = getTimeInSeconds();
+            waitForStreamSorter(&sorter);
+            isSuccessful = writeStreamSnapshot(&sorter, options->streamOutput) && isSuccessful;
+            double elapsed = getTimeInSeconds() - snapshotStartTime;
+            snapshotTime += elapsed;
+            longestSnapshot = elapsed > longestSnapshot ? elapsed : longestSnapshot;
+            snapshotsCount++;
+            while (nextSnapshot <= totalKeys) {
+                nextSnapshot += snapshotKeys;
+            }
+        }
+    }
+
+    // End-of-stream latency: from the end of the input to the sorted output on disk
+    double endTime = getTimeInSeconds();
+    waitForStreamSorter(&sorter);
+    double drainedTime = getTimeInSeconds();
+    isSuccessful = writeStreamSnapshot(&sorter, options->streamOutput) && isSuccessful;
+    double finishTime = getTimeInSeconds();
+
+    pthread_mutex_lock(&sorter.lock);
+    sorter.isEnd = 1;
+    pthread_cond_signal(&sorter.batchReady);
+    pthread_mutex_unlock(&sorter.lock);
+    pthread_join(sortThread, NULL);
+
+    int runsCount = 0;
+    int tiersCount = 0;
+    for (int t = 0; t < STREAM_MAX_TIERS; t++) {
+        for (int r = 0; r < sorter.tierCounts[t]; r++) {
+            free(sorter.tiers[t][r].buffers[0]);
+        }
+        runsCount += sorter.tierCounts[t];
+        tiersCount = sorter.tierCounts[t] > 0 ? t + 1 : tiersCount;
+    }
+    pthread_mutex_destroy(&sorter.lock);
+    pthread_cond_destroy(&sorter.batchReady);
+    pthread_cond_destroy(&sorter.batchTaken);
+    free(reader.buffer);
+    free(reader.carry);
+
+    double ingestTime = endTime - startTime;
+    double totalTime = finishTime - startTime;
+    double megabytes = (double)reader.bytesRead / (1024.0 * 1024.0);
+    printf("\nKeys: %llu (%.1lfMB read) | Batches: %d | Runs at the end: %d in %d tiers", totalKeys, megabytes, batchesCount, runsCount, tiersCount);
+    printf("\nIngest: %.3lfsecs (%.0lf keys/s, %.1lfMB/s) | Reader waiting for the sorter: %.3lfsecs",
+        ingestTime, ingestTime > 0.0 ? totalKeys / ingestTime : 0.0, ingestTime > 0.0 ? megabytes / ingestTime : 0.0, stallTime);
+    printf("\nBackground: sorting %.3lfsecs | tier merges %.3lfsecs (%.2lf merges per key)",
+        sorter.sortTime, sorter.mergeTime, totalKeys > 0 ? (double)sorter.mergedKeys / totalKeys : 0.0);
+    if (snapshotsCount > 0) {
+        printf("\nSnapshots: %d (mean %.3lfsecs, longest %.3lfsecs, included in the ingest time)",
+            snapshotsCount, snapshotTime / snapshotsCount, longestSnapshot);
+    }
+    printf("\nEnd-of-stream latency: %.3lfsecs (last batches %.3lfsecs, final merge of %d runs %.3lfsecs)",
+        finishTime - endTime, drainedTime - endTime, runsCount, finishTime - drainedTime);
+    printf("\nTotal: %.3lfsecs (%.0lf keys/s)\n", totalTime, totalTime > 0.0 ? totalKeys / totalTime : 0.0);
+    if (reader.rejectedLines > 0) {
+        fprintf(stderr, "Rejected %llu lines with a key larger than %lu\n", reader.rejectedLines, ULONG_MAX);
+    }
+    return isSuccessful;
+}
+size_t readStreamKeys(StreamReader *reader, unsigned long int *keys, size_t capacity) {
+    if (reader->format == OUTPUT_FORMAT_BINARY) {
+        // Read straight into the keys, a pipe may return any number of bytes at a time
+        char *bytes = (char *)keys;
+        size_t size = capacity * sizeof(unsigned long int);
+        size_t used = 0;
+        while (used < size) {
+            #ifdef _WIN32
+                int count = _read(reader->fileDescriptor, bytes + used, (unsigned int)(size - used));
+            #else
+                ssize_t count = read(reader->fileDescriptor, bytes + used, size - used);
+            #endif
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) {
+                if (count < 0) perror("Error reading stdin");
+                reader->isEnd = 1;
+                break;
+            }
+            used += (size_t)count;
+        }
+        reader->bytesRead += used;
+        if (reader->isEnd && used % sizeof(unsigned long int) != 0) {
+            fprintf(stderr, "Ignoring the last %zu bytes of the input, not a whole key\n", used % sizeof(unsigned long int));
+        }
+        return used / sizeof(unsigned long int);
+    }
+
+    // The keys of the line the last batch stopped in come first, the line is rejected whole
+    size_t n = reader->carryCount;
+    if (n > 0) {
+        memcpy(keys, reader->carry, n * sizeof(unsigned long int));
+        reader->carryCount = 0;
+    }
+    size_t lineStart = 0;
+    while (n < capacity) {
+        if (reader->position == reader->size) {
+            #ifdef _WIN32
+                int count = _read(reader->fileDescriptor, reader->buffer, STREAM_READ_SIZE);
+            #else
+                ssize_t count = read(reader->fileDescriptor, reader->buffer, STREAM_READ_SIZE);
+            #endif
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) {
+                if (count < 0) perror("Error reading stdin");
+                // The last key may not be followed by anything
+                if (reader->isInKey) {
+                    keys[n++] = reader->key;
+                    reader->isInKey = 0;
+                }
+                reader->isEnd = 1;
+                break;
+            }
+            reader->size = (size_t)count;
+            reader->position = 0;
+            reader->bytesRead += (size_t)count;
+        }
+
+        char c = reader->buffer[reader->position++];
+        if (reader->isAtLineStart) {
+            reader->isLineSkipped = !isdigit((unsigned char)c);
+            reader->isAtLineStart = 0;
+        }
+        if (c >= '0' && c <= '9') {
+            if (!reader->isLineSkipped) {
+                unsigned long int digit = (unsigned long int)(c - '0');
+                if (reader->isInKey && reader->key > (ULONG_MAX - digit) / 10) {
+                    // The key doesn't fit, drop the keys of the line read so far and skip the rest
+                    n = lineStart;
+                    reader->isInKey = 0;
+                    reader->isLineSkipped = 1;
+                    reader->rejectedLines++;
+                    continue;
+                }
+                reader->key = reader->isInKey ? reader->key * 10 + digit : digit;
+                reader->isInKey = 1;
+            }
+            continue;
+        }
+        if (reader->isInKey) {
+            keys[n++] = reader->key;
+            reader->isInKey = 0;
+        }
+        reader->isAtLineStart = c == '\n';
+        if (reader->isAtLineStart) {
+            lineStart = n;
+        }
+    }
+
+    // A line longer than a whole batch can't be held back, its keys go with the batch
+    if (!reader->isEnd && lineStart > 0 && lineStart < n) {
+        size_t count = n - lineStart;
+        if (count > reader->carryCapacity) {
+            unsigned long int *carry = (unsigned long int *)realloc(reader->carry, count * sizeof(unsigned long int));
+            if (carry == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            reader->carry = carry;
+            reader->carryCapacity = count;
+        }
+        memcpy(reader->carry, keys + lineStart, count * sizeof(unsigned long int));
+        reader->carryCount = count;
+        n = lineStart;
+    }
+    return n;
+}
+void handOffStreamBatch(StreamSorter *sorter, unsigned long int *batch, size_t n) {
+    pthread_mutex_lock(&sorter->lock);
+    while (sorter->pending != NULL) {
+        pthread_cond_wait(&sorter->batchTaken, &sorter->lock);
+    }
+    sorter->pending = batch;
+    sorter->pendingCount = n;
+    pthread_cond_signal(&sorter->batchReady);
+    pthread_mutex_unlock(&sorter->lock);
+}
+void waitForStreamSorter(StreamSorter *sorter) {
+    pthread_mutex_lock(&sorter->lock);
+    while (sorter->pending != NULL || sorter->isBusy) {
+        pthread_cond_wait(&sorter->batchTaken, &sorter->lock);
+    }
+    pthread_mutex_unlock(&sorter->lock);
+}
+void *streamSortWorker(void *argument) {
+    StreamSorter *sorter = (StreamSorter *)argument;
+    while (1) {
+        pthread_mutex_lock(&sorter->lock);
+        while (sorter->pending == NULL && !sorter->isEnd) {
+            pthread_cond_wait(&sorter->batchReady, &sorter->lock);
+        }
+        if (sorter->pending == NULL) {
+            pthread_mutex_unlock(&sorter->lock);
+            break;
+        }
+        unsigned long int *batch = sorter->pending;
+        size_t n = sorter->pendingCount;
+        sorter->pending = NULL;
+        sorter->isBusy = 1;
+        pthread_cond_broadcast(&sorter->batchTaken);
+        pthread_mutex_unlock(&sorter->lock);
+
+        // The tiers are only touched here while busy, and by the reader once this thread is idle
+        double startTime = getTimeInSeconds();
+        sorter->algorithm->function(batch, (int)n);
+        sorter->sortTime += getTimeInSeconds() - startTime;
+        addStreamRun(sorter, batch, n);
+
+        pthread_mutex_lock(&sorter->lock);
+        sorter->isBusy = 0;
+        pthread_cond_broadcast(&sorter->batchTaken);
+        pthread_mutex_unlock(&sorter->lock);
+    }
+    return NULL;
+}
+void addStreamRun(StreamSorter *sorter, unsigned long int *keys, size_t n) {
+    int tier = 0;
+    while (1) {
+        ExternalRun *run = &sorter->tiers[tier][sorter->tierCounts[tier]++];
+        run->file = NULL;
+        run->buffers[0] = keys;
+        run->buffers[1] = NULL;
+        run->counts[0] = n;
+        run->counts[1] = 0;
+        run->current = 0;
+        if (sorter->tierCounts[tier] < STREAM_TIER_FANOUT) {
+            return;
+        }
+
+        // The tier is full: merge its runs into one run of the next tier, which may fill it in turn
+        double startTime = getTimeInSeconds();
+        ExternalRun *runs = sorter->tiers[tier];
+        n = 0;
+        for (int r = 0; r < STREAM_TIER_FANOUT; r++) {
+            runs[r].position = 0;
+            runs[r].finished = runs[r].counts[0] == 0;
+            n += runs[r].counts[0];
+        }
+        keys = (unsigned long int *)malloc((n > 0 ? n : 1) * sizeof(unsigned long int));
+        if (keys == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        int tree[STREAM_TIER_FANOUT];
+        initializeLoserTree(tree, runs, STREAM_TIER_FANOUT);
+        mergeMemoryRuns(tree, runs, STREAM_TIER_FANOUT, keys, n);
+        for (int r = 0; r < STREAM_TIER_FANOUT; r++) {
+            free(runs[r].buffers[0]);
+        }
+        sorter->tierCounts[tier] = 0;
+        sorter->mergedKeys += n;
+        sorter->mergeTime += getTimeInSeconds() - startTime;
+        if (tier + 1 < STREAM_MAX_TIERS) {
+            tier++;
+        }
+    }
+}
+size_t mergeMemoryRuns(int *tree, ExternalRun *runs, int k, unsigned long int *output, size_t capacity) {
+    size_t written = 0;
+    while (written < capacity && !runs[tree[0]].finished) {
+        int winner = tree[0];
+        ExternalRun *run = &runs[winner];
+        output[written++] = run->buffers[0][run->position++];
+        run->finished = run->position == run->counts[0];
+        replayLoserTree(tree, runs, k, winner);
+    }
+    return written;
+}
+int writeStreamSnapshot(StreamSorter *sorter, const char *filename) {
+    // Copies of the runs keep their own positions, the tiers stay as they are for the next batches
+    ExternalRun runs[STREAM_MAX_TIERS * STREAM_TIER_FANOUT];
+    int k = 0;
+    for (int t = 0; t < STREAM_MAX_TIERS; t++) {
+        for (int r = 0; r < sorter->tierCounts[t]; r++) {
+            runs[k] = sorter->tiers[t][r];
+            runs[k].position = 0;
+            runs[k].finished = runs[k].counts[0] == 0;
+            k++;
+        }
+    }
+
+    FILE *output = NULL;
+    if (filename != NULL) {
+        output = fopen(filename, "wb");
+        if (output == NULL) {
+            fprintf(stderr, "Error opening file: %s\n", filename);
+            return 0;
+        }
+    }
+    int isSuccessful = 1;
+    if (k > 0) {
+        size_t outputKeys = OUTPUT_BUFFER_SIZE / sizeof(unsigned long int);
+        unsigned long int *outputBuffer = (unsigned long int *)malloc(outputKeys * sizeof(unsigned long int));
+        int tree[STREAM_MAX_TIERS * STREAM_TIER_FANOUT];
+        if (outputBuffer == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        initializeLoserTree(tree, runs, k);
+        size_t count;
+        while ((count = mergeMemoryRuns(tree, runs, k, outputBuffer, outputKeys)) > 0) {
+            if (output != NULL && fwrite(outputBuffer, sizeof(unsigned long int), count, output) != count) {
+                isSuccessful = 0;
+                break;
+            }
+        }
+        free(outputBuffer);
+    }
+    if (output != NULL && fclose(output) != 0) {
+        isSuccessful = 0;
+    }
+    if (!isSuccessful) {
+        fprintf(stderr, "Error writing file: %s\n", filename);
+    }
+    return isSuccessful;
+}
+
+/*
+*
+* RESULTS STORE
+*
+*/
+void collectRunEnvironment(RunEnvironment *environment) {
+    environment->commit = BUILD_COMMIT;
+    environment->compiler = COMPILER_VERSION;
+    #ifdef COUNT_OPERATIONS
+        environment->build = "counting";
+    #else
+        environment->build = "timing";
+    #endif
+    environment->processors = getProcessorCount();
+
+    time_t now = time(NULL);
+    struct tm *utc = gmtime(&now);
+    if (utc == NULL || strftime(environment->timestamp, sizeof(environment->timestamp), "%Y-%m-%dT%H:%M:%SZ", utc) == 0) {
+        snprintf(environment->timestamp, sizeof(environment->timestamp), "unknown");
+    }
+
+    snprintf(environment->cpu, sizeof(environment->cpu), "unknown");
+    #ifdef _WIN32
+        const char *identifier = getenv("PROCESSOR_IDENTIFIER");
+        if (identifier != NULL) {
+            snprintf(environment->cpu, sizeof(environment->cpu), "%s", identifier);
+        }
+    #else
+        FILE *cpuInfo = fopen("/proc/cpuinfo", "r");
+        if (cpuInfo == NULL) {
+            return;
+        }
+        char line[256];
+        while (fgets(line, sizeof(line), cpuInfo) != NULL) {
+            const char *name = strchr(line, ':');
+            if (strncmp(line, "model name", 10) == 0 && name != NULL) {
+                name++;
+                while (*name == ' ' || *name == '\t') name++;
+                snprintf(environment->cpu, sizeof(environment->cpu), "%s", name);
+                environment->cpu[strcspn(environment->cpu, "\r\n")] = '\0';
+                break;
+            }
+        }
+        fclose(cpuInfo);
+    #endif
+}
+void appendResultRecord(const char *filename, const RunEnvironment *environment, const char *mode, int n, const char *methodName, unsigned int seed, int warmups, const BenchmarkResult *result, const double *samples, int samplesCount) {
+    const char *statuses[] = {"completed", "timed out", "skipped"};
+    size_t length = 0;
+    size_t capacity = 1024 + (size_t)samplesCount * 24;
+    char *record = malloc(capacity);
+    if (record == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    record[0] = '\0';
+
+    // Where and how it was measured
+    appendToBuffer(&record, &length, &capacity, "{\"timestamp\":");
+    appendJsonString(&record, &length, &capacity, environment->timestamp);
+    appendToBuffer(&record, &length, &capacity, ",\"commit\":");
+    appendJsonString(&record, &length, &capacity, environment->commit);
+    appendToBuffer(&record, &length, &capacity, ",\"compiler\":");
+    appendJsonString(&record, &length, &capacity, environment->compiler);
+    appendToBuffer(&record, &length, &capacity, ",\"build\":");
+    appendJsonString(&record, &length, &capacity, environment->build);
+    appendToBuffer(&record, &length, &capacity, ",\"cpu\":");
+    appendJsonString(&record, &length, &capacity, environment->cpu);
+    appendToBuffer(&record, &length, &capacity, ",\"processors\":%d,\"kernels\":", environment->processors);
+    appendJsonString(&record, &length, &capacity, simdKernelLevel);
+    appendToBuffer(&record, &length, &capacity, ",\"mode\":");
+    appendJsonString(&record, &length, &capacity, mode);
+
+    // The cell
+    appendToBuffer(&record, &length, &capacity, ",\"n\":%d,\"method\":", n);
+    appendJsonString(&record, &length, &capacity, methodName);
+    appendToBuffer(&record, &length, &capacity, ",\"seed\":%u,\"algorithm\":", seed);
+    appendJsonString(&record, &length, &capacity, result->algorithm->name);
+    appendToBuffer(&record, &length, &capacity, ",\"threads\":%d,\"warmups\":%d,\"timing\":\"%s\",\"status\":\"%s\"",
+        result->threads, warmups, timingModeNames[timingMode], statuses[result->status]);
+    if (result->status == RESULT_SKIPPED && !isinf(result->predictedTime)) {
+        appendToBuffer(&record, &length, &capacity, ",\"predicted\":%.9lf", result->predictedTime);
+    }
+
+    // Every timed run, then the statistics and counts of the completed ones
+    appendToBuffer(&record, &length, &capacity, ",\"samples\":[");
+    for (int i = 0; i < samplesCount; i++) {
+        appendToBuffer(&record, &length, &capacity, i > 0 ? ",%.9lf" : "%.9lf", samples[i]);
+    }
+    appendToBuffer(&record, &length, &capacity, "]");
+    if (result->status == RESULT_COMPLETED) {
+        appendToBuffer(&record, &length, &capacity, ",\"min\":%.9lf,\"median\":%.9lf,\"mean\":%.9lf,\"stddev\":%.9lf",
+            result->stats.min, result->stats.median, result->stats.mean, result->stats.stddev);
+        if (hardwareCountersAvailable > 0 && result->counters.runs > 0) {
+            appendToBuffer(&record, &length, &capacity, ",\"counters\":{");
+            int isFirst = 1;
+            for (int c = 0; c < HARDWARE_COUNTERS_SIZE; c++) {
+                if (hardwareCounterFds[c] < 0) continue;
+                appendToBuffer(&record, &length, &capacity, isFirst ? "\"%s\":%.0lf" : ",\"%s\":%.0lf",
+                    hardwareCounterNames[c], result->counters.values[c] / result->counters.runs);
+                isFirst = 0;
+            }
+            appendToBuffer(&record, &length, &capacity, "}");
+        }
+        int memoryRuns = samplesCount > 0 ? samplesCount : 1;
+        appendToBuffer(&record, &length, &capacity, ",\"memory\":{\"peak_bytes\":%llu,\"allocations\":%.0lf,\"malloc_allocations\":%.0lf,\"allocator_seconds\":%.9lf}",
+            result->memory.peakBytes, (double)result->memory.allocations / memoryRuns,
+            (double)result->memory.systemAllocations / memoryRuns, result->memory.allocatorTime / memoryRuns);
+        #ifdef COUNT_OPERATIONS
+            int runs = samplesCount > 0 ? samplesCount : 1;
+            appendToBuffer(&record, &length, &capacity, ",\"operations\":{\"comparisons\":%.0lf,\"swaps\":%.0lf,\"moves\":%.0lf}",
+                (double)result->operations.comparisons / runs, (double)result->operations.swaps / runs,
+                (double)result->operations.moves / runs);
+        #endif
+    }
+    appendToBuffer(&record, &length, &capacity, "}\n");
+
+    appendStringToFile(filename, "%s", record);
+    free(record);
+}
+void appendToBuffer(char **buffer, size_t *length, size_t *capacity, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+    int written = vsnprintf(*buffer + *length, *capacity - *length, format, args);
+    va_end(args);
+
+    if (written >= 0 && (size_t)written >= *capacity - *length) {
+        size_t newCapacity = (*capacity + (size_t)written + 1) * 2;
+        char *grown = realloc(*buffer, newCapacity);
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(EXIT_FAILURE);
+        }
+        *buffer = grown;
+        *capacity = newCapacity;
+        written = vsnprintf(*buffer + *length, *capacity - *length, format, retry);
+    }
+    va_end(retry);
+    if (written > 0) {
+        *length += (size_t)written;
+    }
+}
+void appendJsonString(char **buffer, size_t *length, size_t *capacity, const char *text) {
+    appendToBuffer(buffer, length, capacity, "\"");
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            appendToBuffer(buffer, length, capacity, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            appendToBuffer(buffer, length, capacity, "\\u%04x", (unsigned int)(unsigned char)*c);
+        } else {
+            appendToBuffer(buffer, length, capacity, "%c", *c);
+        }
+    }
+    appendToBuffer(buffer, length, capacity, "\"");
+}
+int loadResultRecords(const char *filename, StoredResult **records) {
+    *records = NULL;
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    // Read the whole file, results files are small
+    size_t size = 0;
+    size_t capacity = 1 << 16;
+    char *text = malloc(capacity);
+    while (text != NULL) {
+        size += fread(text + size, 1, capacity - size - 1, file);
+        if (size < capacity - 1) break;
+        capacity *= 2;
+        char *grown = realloc(text, capacity);
+        if (grown == NULL) {
+            free(text);
+            text = NULL;
+        } else {
+            text = grown;
+        }
+    }
+    fclose(file);
+    if (text == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+    text[size] = '\0';
+
+    int count = 0;
+    int recordsCapacity = 0;
+    char *object = strchr(text, '{');
+    while (object != NULL) {
+        // Find the brace closing the object, the braces inside strings don't count
+        int depth = 0;
+        char *objectEnd = object;
+        for (; *objectEnd != '\0'; objectEnd++) {
+            if (*objectEnd == '"') {
+                const char *stringEnd = skipJsonString(objectEnd);
+                if (stringEnd == NULL) break;
+                objectEnd = (char *)stringEnd - 1;
+            } else if (*objectEnd == '{') {
+                depth++;
+            } else if (*objectEnd == '}' && --depth == 0) {
+                break;
+            }
+        }
+        // A record cut short by an aborted write ends the file
+        if (*objectEnd != '}') break;
+        char *nextObject = strchr(objectEnd + 1, '{');
+        objectEnd[1] = '\0';
+
+        StoredResult record;
+        memset(&record, 0, sizeof(record));
+        const char *algorithm = findJsonField(object, "algorithm");
+        const char *method = findJsonField(object, "method");
+        const char *status = findJsonField(object, "status");
+        const char *n = findJsonField(object, "n");
+        const char *threads = findJsonField(object, "threads");
+        const char *samples = findJsonField(object, "samples");
+        // Another kind of object is not a record
+        int isRecord = algorithm != NULL && method != NULL && status != NULL && n != NULL &&
+            threads != NULL && samples != NULL && *samples == '[' && strchr(samples, ']') != NULL &&
+            readJsonString(algorithm, record.algorithm, sizeof(record.algorithm)) &&
+            readJsonString(method, record.method, sizeof(record.method));
+        if (isRecord) {
+            // Results from before the timing modes were timed warm
+            const char *timing = findJsonField(object, "timing");
+            if (timing == NULL || !readJsonString(timing, record.timing, sizeof(record.timing))) {
+                strcpy(record.timing, timingModeNames[TIMING_WARM]);
+            }
+            const char *mode = findJsonField(object, "mode");
+            if (mode == NULL || !readJsonString(mode, record.mode, sizeof(record.mode))) {
+                strcpy(record.mode, "batch");
+            }
+            record.n = atoi(n);
+            record.threads = atoi(threads);
+            record.isCompleted = strncmp(status, "\"completed\"", 11) == 0;
+
+            // Count the runs, then read them
+            const char *samplesEnd = strchr(samples, ']');
+            int commas = 0;
+            int hasRuns = 0;
+            for (const char *c = samples + 1; c < samplesEnd; c++) {
+                if (*c == ',') {
+                    commas++;
+                } else if (!isspace((unsigned char)*c)) {
+                    hasRuns = 1;
+                }
+            }
+            record.samplesCount = hasRuns ? commas + 1 : 0;
+            record.samples = malloc((record.samplesCount > 0 ? record.samplesCount : 1) * sizeof(double));
+            if (record.samples == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+            }
+            const char *c = samples + 1;
+            for (int i = 0; i < record.samplesCount; i++) {
+                char *end;
+                record.samples[i] = strtod(c, &end);
+                // Past the comma and the spaces around it
+                c = end;
+                while (isspace((unsigned char)*c) || *c == ',') c++;
+            }
+
+            if (count == recordsCapacity) {
+                recordsCapacity = recordsCapacity > 0 ? recordsCapacity * 2 : 64;
+                StoredResult *grown = realloc(*records, recordsCapacity * sizeof(StoredResult));
+                if (grown == NULL) {
+                    fprintf(stderr, "Memory allocation failed\n");
+                    exit(EXIT_FAILURE);
+                }
+                *records = grown;
+            }
+            (*records)[count++] = record;
+        }
 
-        displayConfirmExit();
-        free(algorithmsCopy);
+        object = nextObject;
     }
-    return 0;
+    free(text);
+    return count;
 }
-
-/*
-*
-* DATA GENERATION METHODS
-*
-*/
-unsigned long int *generateRandomIntegers(int n) {
-    unsigned long int *array = (unsigned long int *)malloc(n * sizeof(unsigned long int));
-    
-    srand(time(NULL));
-    for(int i = 0; i < n; i++) {
-        // Generate two 32-bit random numbers
-        unsigned long int high = (unsigned long int)rand();
-        unsigned long int low = (unsigned long int)rand();
-        // Use bitwise shifting and mask to form a larger number
-        unsigned long int randomNumber = (((high & 0xFFFF) << 16) | (low & 0xFFFF)) % (MAX_RANGE - 1);
-        array[i] = randomNumber;
+void freeResultRecords(StoredResult *records, int count) {
+    for (int i = 0; i < count; i++) {
+        free(records[i].samples);
     }
-    return array;
+    free(records);
 }
-unsigned long int *generateIncreasingSequence(int n, unsigned long int startingValue) {
-    unsigned long int *array = (unsigned long int *)malloc(n * sizeof(unsigned long int));
-    // Starting from the starting value, increment until the whole array is filled
-    for(int i = 0; i < n; i++) {
-        array[i] = startingValue++;
+const char *findJsonField(const char *object, const char *name) {
+    size_t nameLength = strlen(name);
+    int depth = 0;
+    for (const char *c = object; *c != '\0'; c++) {
+        if (*c == '{' || *c == '[') {
+            depth++;
+        } else if (*c == '}' || *c == ']') {
+            depth--;
+        } else if (*c == '"') {
+            // A string is a key when a colon follows it, values never match
+            const char *stringEnd = skipJsonString(c);
+            if (stringEnd == NULL) {
+                return NULL;
+            }
+            const char *value = stringEnd;
+            while (isspace((unsigned char)*value)) value++;
+            if (depth == 1 && *value == ':' && (size_t)(stringEnd - c - 2) == nameLength && strncmp(c + 1, name, nameLength) == 0) {
+                value++;
+                while (isspace((unsigned char)*value)) value++;
+                return value;
+            }
+            c = stringEnd - 1;
+        }
     }
-    return array;
+    return NULL;
 }
+const char *skipJsonString(const char *value) {
+    for (const char *c = value + 1; *c != '\0'; c++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c++;
+        } else if (*c == '"') {
+            return c + 1;
+        }
+    }
+    return NULL;
+}
+int readJsonString(const char *value, char *destination, size_t size) {
+    if (*value != '"') {
+        return 0;
+    }
+    size_t length = 0;
+    for (const char *c = value + 1; *c != '"'; c++) {
+        if (*c == '\0') {
+            return 0;
+        }
+        char character = *c;
+        if (*c == '\\' && c[1] == 'u' && isxdigit((unsigned char)c[2]) && isxdigit((unsigned char)c[3]) &&
+            isxdigit((unsigned char)c[4]) && isxdigit((unsigned char)c[5])) {
+            char digits[5] = {c[2], c[3], c[4], c[5], '\0'};
+            character = (char)strtol(digits, NULL, 16);
+            c += 5;
+        } else if (*c == '\\' && c[1] != '\0') {
+            character = *++c;
+        }
+        if (length + 1 < size) {
+            destination[length++] = character;
+        }
+    }
+    destination[length] = '\0';
+    return 1;
+}
+int findResultRecord(const StoredResult *records, int count, const StoredResult *cell) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (records[i].n == cell->n && records[i].threads == cell->threads &&
+            strcmp(records[i].algorithm, cell->algorithm) == 0 && strcmp(records[i].method, cell->method) == 0 &&
+            strcmp(records[i].timing, cell->timing) == 0 && strcmp(records[i].mode, cell->mode) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+double mannWhitneyPValue(const double *baseline, int baselineCount, const double *candidate, int candidateCount) {
+    if (baselineCount < 2 || candidateCount < 2) {
+        return 1.0;
+    }
 
-void runBenchmark(unsigned long int *array, int n) {
-    // The benchmarks result will also be outputted in a csv
-    appendStringToFile("results.csv", "\n");
+    // U counts the (baseline, candidate) pairs where the candidate run is slower, ties count half
+    double u = 0.0;
+    for (int i = 0; i < baselineCount; i++) {
+        for (int j = 0; j < candidateCount; j++) {
+            if (candidate[j] > baseline[i]) u += 1.0;
+            else if (candidate[j] == baseline[i]) u += 0.5;
+        }
+    }
 
-    printf("\nRunning benchmarks...");
-    for(int i = 0; i < algorithmsSize; i++) {
-        // Duplicate the data for each sorting algorithm
-        unsigned long int *arrayCopy = duplicateArray(array, n);
+    // Tied times shrink the variance of U
+    int total = baselineCount + candidateCount;
+    double *pooled = malloc(total * sizeof(double));
+    if (pooled == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(pooled, baseline, baselineCount * sizeof(double));
+    memcpy(pooled + baselineCount, candidate, candidateCount * sizeof(double));
+    qsort(pooled, total, sizeof(double), compareDoubles);
+    double ties = 0.0;
+    for (int i = 0; i < total; ) {
+        int j = i;
+        while (j < total && pooled[j] == pooled[i]) j++;
+        double tied = j - i;
+        ties += tied * tied * tied - tied;
+        i = j;
+    }
+    free(pooled);
 
-        printf("\n[%s] Sorting in progress...", algorithms[i].name);
+    double pairs = (double)baselineCount * candidateCount;
+    double variance = pairs / 12.0 * ((total + 1) - ties / ((double)total * (total - 1)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    double z = (u - pairs / 2.0 - 0.5) / sqrt(variance);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+int compareResultFiles(const BatchOptions *options) {
+    StoredResult *baseline;
+    StoredResult *candidate;
+    int baselineCount = loadResultRecords(options->compareBaseline, &baseline);
+    if (baselineCount < 0) {
+        fprintf(stderr, "Error opening file: %s\n", options->compareBaseline);
+        return 0;
+    }
+    int candidateCount = loadResultRecords(options->compareCandidate, &candidate);
+    if (candidateCount < 0) {
+        fprintf(stderr, "Error opening file: %s\n", options->compareCandidate);
+        freeResultRecords(baseline, baselineCount);
+        return 0;
+    }
 
-        // Start the timer
-        double startTime = getTimeInSeconds();
-        // Run the sorting algorithm
-        algorithms[i].function(arrayCopy, n);
-        // End the timer
-        double endTime = getTimeInSeconds();
+    // A file without records would compare no cells and pass as free of regressions
+    if (baselineCount == 0 || candidateCount == 0) {
+        fprintf(stderr, "No result records in: %s\n", baselineCount == 0 ? options->compareBaseline : options->compareCandidate);
+        freeResultRecords(baseline, baselineCount);
+        freeResultRecords(candidate, candidateCount);
+        return 0;
+    }
 
-        // Calculate the elapsed time
-        algorithms[i].time = endTime - startTime;
+    printf("\nBaseline: %s (%d records) | Candidate: %s (%d records)", options->compareBaseline, baselineCount,
+        options->compareCandidate, candidateCount);
+    printf("\nA cell regressed when its median is more than %g%% slower with p < %g (one-sided Mann-Whitney U)",
+        options->regressionThreshold, options->significanceLevel);
+    printf("\n---------------------------------------------------------------------------------------------------------------------------------------------");
+    printf("\n|        Algorithm       | Threads |     N     |            Method            |   Baseline    |   Candidate   |  Change  | p-value |  Verdict   |");
+    printf("\n---------------------------------------------------------------------------------------------------------------------------------------------");
 
-        printf("\n[%s] Sorting finished!", algorithms[i].name);
-        printf("\n[%s] Time taken: %.9lfsecs", algorithms[i].name, algorithms[i].time);
+    int compared = 0, regressions = 0, improvements = 0, unmatched = 0;
+    for (int i = 0; i < candidateCount; i++) {
+        // Only the latest record of each cell counts
+        StoredResult *current = &candidate[i];
+        if (findResultRecord(candidate, candidateCount, current) != i || !current->isCompleted || current->samplesCount == 0) {
+            continue;
+        }
+        int j = findResultRecord(baseline, baselineCount, current);
+        if (j < 0 || !baseline[j].isCompleted || baseline[j].samplesCount == 0) {
+            unmatched++;
+            continue;
+        }
+        StoredResult *previous = &baseline[j];
 
-        // Clear and output the sorted data into a file per algorithm
-        clearFile(algorithms[i].outputFile);
-        appendStringToFile(algorithms[i].outputFile, "\n%s Sorted Array | Number of elements (N): %d | Time take: %.9lf\n\n",algorithms[i].name, n, algorithms[i].time);
-        appendArrayToFile(algorithms[i].outputFile, arrayCopy, n);
+        double pSlower = mannWhitneyPValue(previous->samples, previous->samplesCount, current->samples, current->samplesCount);
+        double pFaster = mannWhitneyPValue(current->samples, current->samplesCount, previous->samples, previous->samplesCount);
+        double baselineMedian = computeBenchmarkStats(previous->samples, previous->samplesCount).median;
+        double candidateMedian = computeBenchmarkStats(current->samples, current->samplesCount).median;
+        double change = baselineMedian > 0.0 ? (candidateMedian / baselineMedian - 1.0) * 100.0 : 0.0;
 
-        // Append the elapsed time to results.csv
-        appendStringToFile("results.csv", "%.9lf,", algorithms[i].time);
+        const char *verdict = "same";
+        double p = pSlower;
+        if (pSlower < options->significanceLevel && change > options->regressionThreshold) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (pFaster < options->significanceLevel && change < -options->regressionThreshold) {
+            verdict = "faster";
+            p = pFaster;
+            improvements++;
+        }
+        compared++;
 
-        free(arrayCopy);
+        printf("\n| %22s |", current->algorithm);
+        if (current->threads > 0) {
+            printf(" %7d |", current->threads);
+        } else {
+            printf("       - |");
+        }
+        // Cells timed cold or on huge pages are told apart from the warm ones by their method
+        char method[sizeof(current->method) + sizeof(current->timing) + 3];
+        if (strcmp(current->timing, timingModeNames[TIMING_WARM]) == 0) {
+            snprintf(method, sizeof(method), "%s", current->method);
+        } else {
+            snprintf(method, sizeof(method), "%s (%s)", current->method, current->timing);
+        }
+        printf(" %9d | %-28.28s | %14.9lf| %14.9lf| %+7.1lf%% | %7.4lf | %-10s |", current->n, method,
+            baselineMedian, candidateMedian, change, p, verdict);
+    }
+    printf("\n---------------------------------------------------------------------------------------------------------------------------------------------");
+    printf("\n%d cells compared: %d regressed, %d faster", compared, regressions, improvements);
+    if (unmatched > 0) {
+        printf(", %d not in the baseline", unmatched);
+    }
+    printf("\n");
+    if (compared == 0) {
+        fprintf(stderr, "No completed cell of %s is in %s, nothing was compared\n", options->compareCandidate, options->compareBaseline);
     }
 
-    printf("\nBenchmarks complete!");
-    sleepProgram(3500);
+    freeResultRecords(baseline, baselineCount);
+    freeResultRecords(candidate, candidateCount);
+    return compared > 0 && regressions == 0;
 }
 
 /*
 *
-* SORTING ALGORITHMS
+* INDIRECT SORT
 *
 */
-void selectionSort(unsigned long int *array, int n) {
-    for (int i = 0; i < n - 1; i++) {
-        int minIndex = i;
-        for (int j = i + 1; j < n; j++) {
-            if (array[j] < array[minIndex]) {
-                minIndex = j;
-            }
+void indirectSort(void *records, int n, const ElementType *recordType, const SortingAlgorithm *keyAlgorithm, int mode) {
+    if (n < 2) return;
+
+    int *order = (int *)allocateScratch((size_t)n * sizeof(int));
+    if (order == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Bits of the index, and whether the largest key fits above them
+    int indexBits = 0;
+    while (indexBits < 31 && (1L << indexBits) < n) indexBits++;
+    uint64_t largestKey = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t key = recordType->sortKey(records, i);
+        if (key > largestKey) largestKey = key;
+    }
+
+    if ((largestKey >> (KEY_BITS - indexBits)) == 0) {
+        unsigned long int *pairs = (unsigned long int *)allocateScratch((size_t)n * sizeof(unsigned long int));
+        if (pairs == NULL) {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < n; i++) {
+            pairs[i] = ((unsigned long int)recordType->sortKey(records, i) << indexBits) | (unsigned long int)i;
+        }
+        // Equal keys are ordered by index, so every algorithm gives a stable result
+        keyAlgorithm->function(pairs, n);
+        const unsigned long int indexMask = (1UL << indexBits) - 1;
+        for (int j = 0; j < n; j++) {
+            order[j] = (int)(pairs[j] & indexMask);
         }
-        // Swap
-        unsigned long int temp = array[i];
-        array[i] = array[minIndex];
-        array[minIndex] = temp;
+        freeScratch(pairs);
+    } else {
+        KeyValueRecord *pairs = (KeyValueRecord *)allocateScratch((size_t)n * sizeof(KeyValueRecord));
+        if (pairs == NULL) {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < n; i++) {
+            pairs[i].key = recordType->sortKey(records, i);
+            pairs[i].value = (uint64_t)i;
+        }
+        mergeSortKeyValue(pairs, n);
+        for (int j = 0; j < n; j++) {
+            order[j] = (int)pairs[j].value;
+        }
+        freeScratch(pairs);
+    }
+
+    if (mode == RECORD_SORT_CYCLES) {
+        permuteRecordsInPlace(records, n, recordType->size, order);
+    } else {
+        gatherRecords(records, n, recordType->size, order);
     }
+    freeScratch(order);
 }
-void bubbleSort(unsigned long int *array, int n) {
-    for (int i = 0; i < n - 1; i++) {
-        int swapped = 0;
-        for (int j = 0; j < n - i - 1; j++) {
-            if (array[j] > array[j + 1]) {
-                // Swap
-                unsigned long int temp = array[j];
-                array[j] = array[j + 1];
-                array[j + 1] = temp;
-                swapped = 1;
+void gatherRecords(void *records, int n, size_t size, const int *order) {
+    unsigned char *source = (unsigned char *)records;
+    unsigned char *destination = (unsigned char *)allocateScratch((size_t)n * size);
+    if (destination == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Writes are sequential, the random reads are fetched ahead, every cache line of the record
+    for (int j = 0; j < n; j++) {
+        if (j + GATHER_PREFETCH_DISTANCE < n) {
+            const unsigned char *ahead = source + (size_t)order[j + GATHER_PREFETCH_DISTANCE] * size;
+            for (size_t offset = 0; offset < size; offset += 64) {
+                PREFETCH(ahead + offset);
             }
         }
-        // Stop if already sorted
-        if (!swapped) break;
+        memcpy(destination + (size_t)j * size, source + (size_t)order[j] * size, size);
     }
+    COUNT_MOVES(n);
+
+    memcpy(records, destination, (size_t)n * size);
+    COUNT_MOVES(n);
+    freeScratch(destination);
 }
-void insertionSort(unsigned long int *array, int n) {
-    for (int i = 1; i < n; i++) {
-        // Store the current element
-        unsigned long int key = array[i];
-        int j = i - 1;
+void permuteRecordsInPlace(void *records, int n, size_t size, int *order) {
+    unsigned char *array = (unsigned char *)records;
+    unsigned char *held = (unsigned char *)allocateScratch(size);
+    if (held == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
 
-        // Shift elements greater than key to the right
-        while (j >= 0 && array[j] > key) {
-            array[j + 1] = array[j];
-            j--;
-        }
+    for (int start = 0; start < n; start++) {
+        if (order[start] == start) continue;
 
-        // Insert key at the correct position
-        array[j + 1] = key;
+        // Hold the first record of the cycle, pull each record into the slot before it,
+        // and put the held record into the last slot
+        memcpy(held, array + (size_t)start * size, size);
+        int j = start;
+        while (order[j] != start) {
+            int next = order[j];
+            memcpy(array + (size_t)j * size, array + (size_t)next * size, size);
+            order[j] = j;
+            j = next;
+        }
+        memcpy(array + (size_t)j * size, held, size);
+        order[j] = j;
     }
+    COUNT_MOVES(n);
+    freeScratch(held);
 }
-void merge(unsigned long int *array, int left, int mid, int right) {
-    int leftSize = mid - left + 1;
-    int rightSize = right - mid;
-
-    // Allocate memory dynamically
-    unsigned long int *leftArray = (unsigned long int *)malloc(leftSize * sizeof(unsigned long int));
-    unsigned long int *rightArray = (unsigned long int *)malloc(rightSize * sizeof(unsigned long int));
-
-    // Check for memory allocation failure
-    if (leftArray == NULL || rightArray == NULL) {
+int isRecordPermutation(const void *records, int n, size_t size, const unsigned long int *keys) {
+    unsigned char *seen = (unsigned char *)calloc(n > 0 ? (size_t)n : 1, 1);
+    if (seen == NULL) {
         perror("Memory allocation failed");
         exit(EXIT_FAILURE);
     }
 
-    // Copy data to temporary arrays
-    for (int i = 0; i < leftSize; i++) {
-        leftArray[i] = array[left + i];
-    }
-    for (int j = 0; j < rightSize; j++) {
-        rightArray[j] = array[mid + 1 + j];
+    // Every record type starts with its key and its index
+    int isPermutation = 1;
+    for (int i = 0; i < n && isPermutation; i++) {
+        uint64_t key, index;
+        memcpy(&key, (const unsigned char *)records + (size_t)i * size, sizeof(key));
+        memcpy(&index, (const unsigned char *)records + (size_t)i * size + sizeof(key), sizeof(index));
+        isPermutation = index < (uint64_t)n && !seen[index] && key == (uint64_t)keys[index];
+        if (isPermutation) seen[index] = 1;
     }
+    free(seen);
+    return isPermutation;
+}
+
+/*
+*
+* HARDWARE COUNTERS
+*
+*/
+#ifdef HARDWARE_COUNTERS_SUPPORTED
+int openHardwareCounters(void) {
+    // The type and config of each event of hardwareCounterNames
+    const unsigned int types[HARDWARE_COUNTERS_SIZE] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE
+    };
+    const unsigned long long configs[HARDWARE_COUNTERS_SIZE] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    };
+
+    int lastError = 0;
+    hardwareCountersAvailable = 0;
+    for (int i = 0; i < HARDWARE_COUNTERS_SIZE; i++) {
+        struct perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = types[i];
+        attributes.config = configs[i];
+        attributes.disabled = 1;
+        // User space only, which is allowed up to perf_event_paranoid 2
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        // Count the worker threads of the parallel algorithms as well
+        attributes.inherit = 1;
+        // The enabled and running times tell how much of the run was counted when events are multiplexed
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
 
-    int i = 0, j = 0, k = left;
-    // Merge the temporary arrays back into the main array
-    while (i < leftSize && j < rightSize) {
-        if (leftArray[i] <= rightArray[j]) {
-            array[k++] = leftArray[i++];
+        hardwareCounterFds[i] = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        if (hardwareCounterFds[i] < 0) {
+            lastError = errno;
+            hardwareCounterFds[i] = -1;
         } else {
-            array[k++] = rightArray[j++];
+            hardwareCountersAvailable++;
         }
     }
 
-    // Copy remaining elements of leftArray
-    while (i < leftSize) {
-        array[k++] = leftArray[i++];
+    if (hardwareCountersAvailable == 0) {
+        fprintf(stderr, "Hardware counters unavailable (perf_event_open: %s), only times are reported\n", strerror(lastError));
     }
-    // Copy remaining elements of rightArray
-    while (j < rightSize) {
-        array[k++] = rightArray[j++];
-    }
-
-    // Free dynamically allocated memory
-    free(leftArray);
-    free(rightArray);
+    return hardwareCountersAvailable;
 }
-void mergeSortHelper(unsigned long int *array, int left, int right) {
-    if (left < right) {
-        // Find the middle index
-        int mid = left + (right - left) / 2;
-
-        // Recursively sort first and second halves
-        mergeSortHelper(array, left, mid);
-        mergeSortHelper(array, mid + 1, right);
-
-        // Merge the sorted halves
-        merge(array, left, mid, right);
+void startHardwareCounters(void) {
+    for (int i = 0; i < HARDWARE_COUNTERS_SIZE; i++) {
+        if (hardwareCounterFds[i] >= 0) {
+            ioctl(hardwareCounterFds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(hardwareCounterFds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
     }
 }
-void mergeSort(unsigned long int *array, int n) {
-    mergeSortHelper(array, 0, n - 1);
-}
-int medianOfThree(unsigned long int *array, int low, int high) {
-    int mid = low + (high - low) / 2;
-    
-    // Arrange low, mid, high in sorted order
-    if (array[low] > array[mid]) {
-        unsigned long int temp = array[low];
-        array[low] = array[mid];
-        array[mid] = temp;
-    }
-    if (array[low] > array[high]) {
-        unsigned long int temp = array[low];
-        array[low] = array[high];
-        array[high] = temp;
+void stopHardwareCounters(HardwareCounters *counters) {
+    for (int i = 0; i < HARDWARE_COUNTERS_SIZE; i++) {
+        if (hardwareCounterFds[i] >= 0) {
+            ioctl(hardwareCounterFds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
     }
-    if (array[mid] > array[high]) {
-        unsigned long int temp = array[mid];
-        array[mid] = array[high];
-        array[high] = temp;
+    for (int i = 0; i < HARDWARE_COUNTERS_SIZE; i++) {
+        // value, time enabled, time running
+        uint64_t reading[3];
+        if (hardwareCounterFds[i] < 0 || read(hardwareCounterFds[i], reading, sizeof(reading)) != (ssize_t)sizeof(reading)) {
+            continue;
+        }
+        double value = (double)reading[0];
+        if (reading[2] > 0 && reading[2] < reading[1]) {
+            value *= (double)reading[1] / (double)reading[2];
+        }
+        counters->values[i] += value;
     }
-    
-    // Median is now at mid, swap it with high so partitioning remains the same
-    unsigned long int temp = array[mid];
-    array[mid] = array[high];
-    array[high] = temp;
-    
-    return array[high]; // Pivot value
+    counters->runs++;
 }
-int quickSortPartition(unsigned long int *array, int low, int high) {
-    // Choose the median-of-three as pivot
-    unsigned long int pivot = medianOfThree(array, low, high);
-    int i = low - 1;
-
-    for (int j = low; j < high; j++) {
-        // If current element is smaller than the pivot, swap
-        if (array[j] < pivot) {
-            i++;
-            unsigned long int temp = array[i];
-            array[i] = array[j];
-            array[j] = temp;
+void closeHardwareCounters(void) {
+    for (int i = 0; i < HARDWARE_COUNTERS_SIZE; i++) {
+        if (hardwareCounterFds[i] >= 0) {
+            close(hardwareCounterFds[i]);
+            hardwareCounterFds[i] = -1;
         }
     }
-
-    // Place pivot at its correct position
-    unsigned long int temp = array[i + 1];
-    array[i + 1] = array[high];
-    array[high] = temp;
-
-    return i + 1;
+    hardwareCountersAvailable = 0;
 }
-void quickSortHelper(unsigned long int *array, int low, int high) {
-    if (low < high) {
-        // Partition the array and get the pivot index
-        int pivotIndex = quickSortPartition(array, low, high);
-        // Recursively sort elements before and after partition
-        quickSortHelper(array, low, pivotIndex - 1);
-        quickSortHelper(array, pivotIndex + 1, high);
-    }
+#else
+int openHardwareCounters(void) {
+    hardwareCountersAvailable = 0;
+    return 0;
 }
-void quickSort(unsigned long int *array, int n) {
-    quickSortHelper(array, 0, n - 1);
+void startHardwareCounters(void) {
 }
-void heapify(unsigned long int *array, int n, int root) {
-    int largest = root;
-    int leftChild = 2 * root + 1;
-    int rightChild = 2 * root + 2;
-
-    // Check if left child is larger than root
-    if (leftChild < n && array[leftChild] > array[largest]) {
-        largest = leftChild;
+void stopHardwareCounters(HardwareCounters *counters) {
+    (void)counters;
+}
+void closeHardwareCounters(void) {
+}
+#endif
+void displayHardwareCounters(const BenchmarkResult *results, int resultsSize) {
+    if (hardwareCountersAvailable == 0) {
+        return;
     }
 
-    // Check if right child is larger than the largest so far
-    if (rightChild < n && array[rightChild] > array[largest]) {
-        largest = rightChild;
+    printf("\nHardware Counters (per run)");
+    printf("\n--------------------------------------------------------------------------------------------------------------------------------------------------");
+    printf("\n|        Algorithm       | Threads |     Cycles     |  Instructions  |  IPC  |   L1D Misses   |   LLC Misses   |  Branch Misses |   dTLB Misses  |");
+    printf("\n--------------------------------------------------------------------------------------------------------------------------------------------------");
+    for (int i = 0; i < resultsSize; i++) {
+        const HardwareCounters *counters = &results[i].counters;
+        if (results[i].status != RESULT_COMPLETED) continue;
+        printf("\n| %22s |", results[i].algorithm->name);
+        if (results[i].threads > 0) {
+            printf(" %7d |", results[i].threads);
+        } else {
+            printf("       - |");
+        }
+        for (int c = 0; c < HARDWARE_COUNTERS_SIZE; c++) {
+            if (hardwareCounterFds[c] >= 0 && counters->runs > 0) {
+                printf(" %14.0lf |", counters->values[c] / counters->runs);
+            } else {
+                printf("              - |");
+            }
+            // Instructions per cycle goes right after the two counts it is computed from
+            if (c == 1) {
+                if (hardwareCounterFds[0] >= 0 && hardwareCounterFds[1] >= 0 && counters->values[0] > 0.0) {
+                    printf(" %5.2lf |", counters->values[1] / counters->values[0]);
+                } else {
+                    printf("     - |");
+                }
+            }
+        }
     }
+    printf("\n--------------------------------------------------------------------------------------------------------------------------------------------------\n");
+}
 
-    // Swap and continue heapifying if root is not the largest
-    if (largest != root) {
-        unsigned long int temp = array[root];
-        array[root] = array[largest];
-        array[largest] = temp;
+void displayOperationCounts(const BenchmarkResult *results, int resultsSize, int n) {
+    #ifndef COUNT_OPERATIONS
+        (void)results;
+        (void)resultsSize;
+        (void)n;
+    #else
+        // Comparisons divided by these show which growth rate an algorithm follows
+        double nLogN = n > 1 ? n * log2((double)n) : 1.0;
+        double nSquared = n > 1 ? (double)n * n : 1.0;
 
-        heapify(array, n, largest);
+        // The vector kernels count a comparison per lane, so the counts depend on the kernels
+        printf("\nOperation Counts (per run, %s kernels)", simdKernelLevel);
+        printf("\n---------------------------------------------------------------------------------------------------------------------------");
+        printf("\n|        Algorithm       | Threads |   Comparisons   |      Swaps      |      Moves      | Cmp / N log N |  Cmp / N^2  |");
+        printf("\n---------------------------------------------------------------------------------------------------------------------------");
+        for (int i = 0; i < resultsSize; i++) {
+            const BenchmarkResult *result = &results[i];
+            if (result->status != RESULT_COMPLETED) continue;
+            int runs = result->stats.samples > 0 ? result->stats.samples : 1;
+            double comparisons = (double)result->operations.comparisons / runs;
+            printf("\n| %22s |", result->algorithm->name);
+            if (result->threads > 0) {
+                printf(" %7d |", result->threads);
+            } else {
+                printf("       - |");
+            }
+            printf(" %15.0lf | %15.0lf | %15.0lf | %13.3lf | %11.6lf |", comparisons,
+                (double)result->operations.swaps / runs, (double)result->operations.moves / runs,
+                comparisons / nLogN, comparisons / nSquared);
+        }
+        printf("\n---------------------------------------------------------------------------------------------------------------------------\n");
+    #endif
+}
+void resetScratchMemory(void) {
+    pthread_mutex_lock(&scratchLock);
+    // The arena only moves when none of its blocks are in use
+    if (useScratchArena && scratchArena.used == 0 && scratchArena.wanted > scratchArena.capacity) {
+        if (scratchArena.memory != NULL) {
+            freeTimedArray(scratchArena.memory, scratchArena.capacity);
+        }
+        scratchArena.memory = (unsigned char *)allocateTimedArray(scratchArena.wanted);
+        scratchArena.capacity = scratchArena.memory != NULL ? scratchArena.wanted : 0;
+        scratchArena.top = 0;
+        if (scratchArena.memory != NULL) {
+            memset(scratchArena.memory, 0, scratchArena.capacity);
+        }
     }
+    memset(&scratchCounts, 0, sizeof(MemoryCounts));
+    scratchCounts.peakBytes = scratchBytesInUse;
+    pthread_mutex_unlock(&scratchLock);
 }
-void heapSort(unsigned long int *array, int n) {
-    // Build a max heap
-    for (int i = n / 2 - 1; i >= 0; i--) {
-        heapify(array, n, i);
+void addMemoryCounts(MemoryCounts *total, const MemoryCounts *run) {
+    if (run->peakBytes > total->peakBytes) {
+        total->peakBytes = run->peakBytes;
     }
-
-    // Extract elements one by one from heap
-    for (int i = n - 1; i > 0; i--) {
-        // Swap root (largest) with the last element
-        unsigned long int temp = array[0];
-        array[0] = array[i];
-        array[i] = temp;
-
-        // Heapify the reduced heap
-        heapify(array, i, 0);
+    total->allocations += run->allocations;
+    total->systemAllocations += run->systemAllocations;
+    total->allocatorTime += run->allocatorTime;
+}
+void displayMemoryUsage(const BenchmarkResult *results, int resultsSize, int n) {
+    printf("\nScratch Memory (per run, %s)", useScratchArena ? "arena" : "malloc");
+    printf("\n-------------------------------------------------------------------------------------------------------------");
+    printf("\n|        Algorithm       | Threads |   Peak Bytes   | Bytes / Key | Allocations | From malloc | Alloc Time |");
+    printf("\n-------------------------------------------------------------------------------------------------------------");
+    for (int i = 0; i < resultsSize; i++) {
+        const BenchmarkResult *result = &results[i];
+        if (result->status != RESULT_COMPLETED) continue;
+        int runs = result->stats.samples > 0 ? result->stats.samples : 1;
+        printf("\n| %22s |", result->algorithm->name);
+        if (result->threads > 0) {
+            printf(" %7d |", result->threads);
+        } else {
+            printf("       - |");
+        }
+        printf(" %14llu | %11.2lf | %11.1lf | %11.1lf | %10.6lf |", result->memory.peakBytes,
+            n > 0 ? (double)result->memory.peakBytes / n : 0.0, (double)result->memory.allocations / runs,
+            (double)result->memory.systemAllocations / runs, result->memory.allocatorTime / runs);
     }
+    printf("\n-------------------------------------------------------------------------------------------------------------\n");
 }
-
 /*
 *
 * UTILITIES
 *
 */
+void *mapFile(const char *filename, size_t *size) {
+    #ifdef _WIN32
+        FILE *file = fopen(filename, "rb");
+        if (file == NULL) {
+            return NULL;
+        }
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        char *contents = fileSize > 0 ? (char *)malloc(fileSize) : NULL;
+        if (contents == NULL || fread(contents, 1, fileSize, file) != (size_t)fileSize) {
+            free(contents);
+            fclose(file);
+            return NULL;
+        }
+        fclose(file);
+        *size = (size_t)fileSize;
+        return contents;
+    #else
+        int fileDescriptor = open(filename, O_RDONLY);
+        if (fileDescriptor < 0) {
+            return NULL;
+        }
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+            close(fileDescriptor);
+            return NULL;
+        }
+        void *mapping = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        close(fileDescriptor);
+        if (mapping == MAP_FAILED) {
+            return NULL;
+        }
+        // The file is read front to back, let the kernel read ahead aggressively
+        madvise(mapping, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+        *size = (size_t)fileStat.st_size;
+        return mapping;
+    #endif
+}
+void unmapFile(void *mapping, size_t size) {
+    #ifdef _WIN32
+        (void)size;
+        free(mapping);
+    #else
+        munmap(mapping, size);
+    #endif
+}
+void *allocateHugePages(size_t size) {
+    #ifdef __linux__
+        size_t roundedSize = size > 0 ? (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : HUGE_PAGE_SIZE;
+        static int isWarned = 0;
+        #ifdef MAP_HUGETLB
+            // Reserved huge pages (vm.nr_hugepages), there usually are none
+            void *reserved = mmap(NULL, roundedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (reserved != MAP_FAILED) {
+                return reserved;
+            }
+        #endif
+
+        // Transparent huge pages only back whole aligned huge pages, so map one more and trim both ends
+        unsigned char *mapping = mmap(NULL, roundedSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            return NULL;
+        }
+        size_t head = (HUGE_PAGE_SIZE - (uintptr_t)mapping % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+        if (head > 0) {
+            munmap(mapping, head);
+        }
+        munmap(mapping + head + roundedSize, HUGE_PAGE_SIZE - head);
+        int isAdvised = 0;
+        #ifdef MADV_HUGEPAGE
+            isAdvised = madvise(mapping + head, roundedSize, MADV_HUGEPAGE) == 0;
+        #endif
+        if (!isAdvised && !isWarned) {
+            fprintf(stderr, "Huge pages are not available, the huge timing mode uses normal pages\n");
+            isWarned = 1;
+        }
+        return mapping + head;
+    #else
+        return allocateCacheAligned(size);
+    #endif
+}
+void freeHugePages(void *memory, size_t size) {
+    #ifdef __linux__
+        size_t roundedSize = size > 0 ? (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : HUGE_PAGE_SIZE;
+        munmap(memory, roundedSize);
+    #else
+        (void)size;
+        freeCacheAligned(memory);
+    #endif
+}
+void *allocateTimedArray(size_t size) {
+    if (timingMode == TIMING_HUGE_PAGES) {
+        return allocateHugePages(size);
+    }
+    return allocateCacheAligned(size);
+}
+void freeTimedArray(void *memory, size_t size) {
+    if (timingMode == TIMING_HUGE_PAGES) {
+        freeHugePages(memory, size);
+    } else {
+        freeCacheAligned(memory);
+    }
+}
+void prepareCaches(void) {
+    if (timingMode != TIMING_COLD) {
+        return;
+    }
+    if (cacheFlushBuffer == NULL) {
+        cacheFlushSize = CACHE_FLUSH_FACTOR * getLastLevelCacheSize();
+        cacheFlushBuffer = (unsigned char *)allocateCacheAligned(cacheFlushSize);
+        if (cacheFlushBuffer == NULL) {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        // Untouched pages all read from the same zero page, which would evict nothing
+        memset(cacheFlushBuffer, 1, cacheFlushSize);
+    }
+
+    // Reading, not writing, so that the sort doesn't pay for writing the buffer back
+    unsigned char sum = 0;
+    for (size_t i = 0; i < cacheFlushSize; i += CACHE_LINE_SIZE) {
+        sum += cacheFlushBuffer[i];
+    }
+    cacheFlushSink = sum;
+}
+size_t getLastLevelCacheSize(void) {
+    size_t size = 0;
+    #ifdef _WIN32
+        DWORD length = 0;
+        GetLogicalProcessorInformation(NULL, &length);
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION *information = malloc(length > 0 ? length : 1);
+        if (information != NULL && GetLogicalProcessorInformation(information, &length)) {
+            for (DWORD i = 0; i < length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION); i++) {
+                if (information[i].Relationship == RelationCache && information[i].Cache.Size > size) {
+                    size = information[i].Cache.Size;
+                }
+            }
+        }
+        free(information);
+    #elif defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+        long levelThree = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        long levelTwo = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        size = levelThree > 0 ? (size_t)levelThree : levelTwo > 0 ? (size_t)levelTwo : 0;
+    #endif
+    return size > 0 ? size : DEFAULT_LAST_LEVEL_CACHE_SIZE;
+}
 void clearFile(const char *filename) {
     FILE *file = fopen(filename, "w");
     if (file == NULL) {
@@ -564,36 +5759,170 @@ void appendStringToFile(const char *filename, const char *format, ...) {
     fclose(file);
 }
 void appendArrayToFile(const char *filename, unsigned long int *array, int n) {
-    FILE *file = fopen(filename, "a");
-    if (file == NULL) {
+    #ifdef _WIN32
+        int fileDescriptor = _open(filename, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+    #else
+        int fileDescriptor = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    #endif
+    char *buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+    if (fileDescriptor < 0 || buffer == NULL) {
         fprintf(stderr, "Error opening file: %s\n", filename);
+        free(buffer);
+        if (fileDescriptor >= 0) close(fileDescriptor);
         return;
     }
 
+    // Format into a large chunk and write it out whenever less than a key's worth of room is left
+    size_t used = 0;
     for (int i = 0; i < n; i++) {
-        fprintf(file, "%lu", array[i]);
+        if (used > OUTPUT_BUFFER_SIZE - 32) {
+            writeChunk(fileDescriptor, buffer, used);
+            used = 0;
+        }
+        used += formatUnsignedLong(array[i], buffer + used);
         if (i < n - 1) {
-            fprintf(file, ",");
+            buffer[used++] = ',';
         }
         if ((i+1) % 20 == 0) {
-            fprintf(file, "\n");
+            buffer[used++] = '\n';
         }
     }
-    fprintf(file, "\n");
+    buffer[used++] = '\n';
+    writeChunk(fileDescriptor, buffer, used);
 
-    fclose(file);
+    free(buffer);
+    close(fileDescriptor);
+}
+int formatUnsignedLong(unsigned long int value, char *buffer) {
+    static const char digitPairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+    // Count the digits first so they can be written from the end
+    int length = 1;
+    for (unsigned long int rest = value; rest >= 10; rest /= 10) {
+        length++;
+    }
+
+    int position = length;
+    while (value >= 100) {
+        int pair = (int)(value % 100) * 2;
+        value /= 100;
+        buffer[--position] = digitPairs[pair + 1];
+        buffer[--position] = digitPairs[pair];
+    }
+    if (value >= 10) {
+        int pair = (int)value * 2;
+        buffer[--position] = digitPairs[pair + 1];
+        buffer[--position] = digitPairs[pair];
+    } else {
+        buffer[--position] = (char)('0' + value);
+    }
+    return length;
+}
+int writeChunk(int fileDescriptor, const char *buffer, size_t size) {
+    while (size > 0) {
+        #ifdef _WIN32
+            int written = _write(fileDescriptor, buffer, (unsigned int)size);
+        #else
+            ssize_t written = write(fileDescriptor, buffer, size);
+        #endif
+        if (written <= 0) {
+            perror("Error writing file");
+            return 0;
+        }
+        buffer += written;
+        size -= (size_t)written;
+    }
+    return 1;
+}
+void writeArrayToBinaryFile(const char *filename, const unsigned long int *array, int n) {
+    #ifdef _WIN32
+        int fileDescriptor = _open(filename, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+    #else
+        int fileDescriptor = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    #endif
+    if (fileDescriptor < 0) {
+        fprintf(stderr, "Error opening file: %s\n", filename);
+        return;
+    }
+
+    // On little-endian 64-bit keys the array already has the file layout
+    const uint16_t endianTest = 1;
+    if (sizeof(unsigned long int) == 8 && *(const unsigned char *)&endianTest == 1) {
+        writeChunk(fileDescriptor, (const char *)array, (size_t)n * 8);
+        close(fileDescriptor);
+        return;
+    }
+
+    // Otherwise convert chunk by chunk
+    unsigned char *buffer = (unsigned char *)malloc(OUTPUT_BUFFER_SIZE);
+    if (buffer == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        close(fileDescriptor);
+        return;
+    }
+    size_t used = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t key = (uint64_t)array[i];
+        for (int byte = 0; byte < 8; byte++) {
+            buffer[used++] = (unsigned char)(key >> (8 * byte));
+        }
+        if (used == OUTPUT_BUFFER_SIZE) {
+            writeChunk(fileDescriptor, (const char *)buffer, used);
+            used = 0;
+        }
+    }
+    writeChunk(fileDescriptor, (const char *)buffer, used);
+
+    free(buffer);
+    close(fileDescriptor);
+}
+void writeArrayOutput(const char *filename, const char *title, const unsigned long int *array, int n) {
+    if (outputFormat == OUTPUT_FORMAT_TEXT) {
+        clearFile(filename);
+        appendStringToFile(filename, "%s", title);
+        appendArrayToFile(filename, (unsigned long int *)array, n);
+    } else if (outputFormat == OUTPUT_FORMAT_BINARY) {
+        // Same name with the extension swapped for .bin
+        char binaryFilename[512];
+        snprintf(binaryFilename, sizeof(binaryFilename), "%s", filename);
+        char *extension = strrchr(binaryFilename, '.');
+        if (extension != NULL && strchr(extension, '/') == NULL) {
+            *extension = '\0';
+        }
+        strncat(binaryFilename, ".bin", sizeof(binaryFilename) - strlen(binaryFilename) - 1);
+        writeArrayToBinaryFile(binaryFilename, array, n);
+    }
 }
 unsigned long int *duplicateArray(const unsigned long int *array, int n) {
-    unsigned long int *copy = malloc(n * sizeof(unsigned long int));
+    unsigned long int *copy = malloc((n > 0 ? (size_t)n : 1) * sizeof(unsigned long int));
     if (copy == NULL) {
         fprintf(stderr, "Memory allocation failed\n");
         return NULL;
     }
-    for (int i = 0; i < n; i++) {
-        copy[i] = array[i];
-    }
+    memcpy(copy, array, (size_t)n * sizeof(unsigned long int));
     return copy;
 }
+int isArraySorted(const unsigned long int *array, int n) {
+    for (int i = 1; i < n; i++) {
+        if (array[i - 1] > array[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+int matchesName(const char *name, const char *query) {
+    if (*query == '\0') {
+        return 0;
+    }
+    for (; *query != '\0'; name++, query++) {
+        char queryChar = (*query == '-' || *query == '_') ? ' ' : *query;
+        char nameChar = *name == '-' ? ' ' : *name;
+        if (*name == '\0' || tolower((unsigned char)nameChar) != tolower((unsigned char)queryChar)) {
+            return 0;
+        }
+    }
+    return 1;
+}
 SortingAlgorithm *duplicateAlgorithmsArray(SortingAlgorithm *array, int n) {
     SortingAlgorithm *copy = malloc(n * sizeof(SortingAlgorithm));
     if (copy == NULL) {
@@ -626,17 +5955,25 @@ unsigned long int getPositiveInteger(const char *prompt) {
         }
     }
 }
-double getTimeInSeconds(void) {
-    #ifdef _WIN32
-        LARGE_INTEGER frequency, start;
-        QueryPerformanceFrequency(&frequency);
-        QueryPerformanceCounter(&start);
-        return (double)start.QuadPart / (double)frequency.QuadPart;
-    #else
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
-    #endif
+double getPositiveDouble(const char *prompt) {
+    while (1) {
+        double temp;
+
+        printf("%s", prompt);
+        if (scanf("%lf", &temp) != 1) {
+            // Invalid input: Non-numeric
+            printf("Invalid input. Please enter a non-negative number\n");
+            while (getchar() != '\n');
+            continue;
+        }
+
+        // Invalid input: Negative number
+        if (temp < 0.0) {
+            printf("Negative numbers are not allowed. Try again.\n");
+        } else {
+            return temp;
+        }
+    }
 }
 int compareByTime(const void *a, const void *b) {
     SortingAlgorithm *algorithmA = (SortingAlgorithm *)a;
@@ -647,6 +5984,24 @@ int compareByTime(const void *a, const void *b) {
     if (algorithmA->time > algorithmB->time) return 1;
     return 0;
 }
+int compareDoubles(const void *a, const void *b) {
+    double valueA = *(const double *)a;
+    double valueB = *(const double *)b;
+
+    if (valueA < valueB) return -1;
+    if (valueA > valueB) return 1;
+    return 0;
+}
+int compareResultsByMedian(const void *a, const void *b) {
+    const BenchmarkResult *resultA = (const BenchmarkResult *)a;
+    const BenchmarkResult *resultB = (const BenchmarkResult *)b;
+
+    // Timed out and skipped cells have no times and go last
+    if (resultA->status != resultB->status) return resultA->status - resultB->status;
+    if (resultA->stats.median < resultB->stats.median) return -1;
+    if (resultA->stats.median > resultB->stats.median) return 1;
+    return 0;
+}
 void clearScreen(void) {
     #ifdef _WIN32
 	    system("cls");
@@ -0,0 +1,3116 @@
+// pthread_setaffinity_np and the CPU_* macros of sched.h are GNU extensions
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "sorting.h"
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+// The processors a thread may run on, saved before pinning it to a single one
+#ifdef _WIN32
+    typedef DWORD_PTR ThreadAffinity;
+#elif defined(__linux__)
+    typedef cpu_set_t ThreadAffinity;
+#else
+    typedef int ThreadAffinity;
+#endif
+// The SIMD kernels work on 64-bit keys, unsigned long int is only 32 bits on Windows
+#if defined(__GNUC__) && defined(__x86_64__) && ULONG_MAX == 0xFFFFFFFFFFFFFFFFUL
+    #define SIMD_KERNELS_AVAILABLE
+    #include <immintrin.h>
+#endif
+
+// Largest block sorted by sortBlockKernel (a 16-key sorting network on AVX2)
+#define SIMD_BLOCK_SIZE 16
+// Partitions of this size or smaller are finished with sortBlockKernel in introSort.
+// It must not be larger than SIMD_BLOCK_SIZE.
+#define INTRO_SORT_INSERTION_CUTOFF 16
+// Partitions of this size or smaller are sorted serially by a single thread in parallelQuickSort
+#define PARALLEL_QUICK_SORT_GRAIN 16384
+// Ranges of this size or smaller are finished with insertion sort by the selection algorithms
+#define SELECTION_INSERTION_CUTOFF 16
+// Keys per group whose medians give the pivot of the median-of-medians selection
+#define MEDIAN_OF_MEDIANS_GROUP_SIZE 5
+// Number of bits of the key sorted per pass of the LSD radix sort (2048 buckets)
+#define LSD_RADIX_BITS 11
+// Number of bits of the key sorted per level of the MSD radix sort (256 buckets)
+#define MSD_RADIX_BITS 8
+// Buckets of this size or smaller are finished with insertion sort in the MSD radix sort
+#define MSD_RADIX_INSERTION_CUTOFF 32
+// Arrays shorter than this are sorted by Tim Sort with a single binary insertion sort
+#define TIM_SORT_MIN_MERGE 32
+// Elements taken in a row from the same run before a Tim Sort merge starts galloping
+#define TIM_SORT_MIN_GALLOP 7
+// Most runs waiting on the Tim Sort stack. The run lengths grow at least like the Fibonacci
+// numbers from the top of the stack down, so 64 is enough for any int length.
+#define TIM_SORT_MAX_RUNS 64
+// Merges where neither run is more than this many times longer than the other use mergeRunsKernel
+#define TIM_SORT_BALANCED_RATIO 4
+// Keys sampled per bucket to pick the splitters of parallelSampleSort
+#define SAMPLE_SORT_OVERSAMPLING 32
+// Buckets per thread of parallelSampleSort. Threads take the next unsorted bucket, so more
+// buckets than threads evens out buckets of uneven sizes.
+#define SAMPLE_SORT_BUCKETS_PER_THREAD 4
+// Most buckets of parallelSampleSort, the bucket of each key is kept in a byte
+#define SAMPLE_SORT_MAX_BUCKETS 256
+// Keys per thread below which the parallel sample and radix sorts use fewer threads
+#define PARALLEL_SORT_MIN_SLICE 4096
+// Bytes before every block of scratch memory, holding its size. A whole line keeps the blocks aligned.
+#define SCRATCH_HEADER_SIZE CACHE_LINE_SIZE
+
+/**
+ * @struct ScratchHeader
+ * @brief Stored in the SCRATCH_HEADER_SIZE bytes before every block of scratch memory
+ * @var size Bytes of the block, the header included
+ * @var previousTop ScratchArena.top before the block was allocated from the arena
+ */
+typedef struct {
+    size_t size;
+    size_t previousTop;
+    int isFromArena;
+    int isFreed;
+} ScratchHeader;
+
+/**
+ * @struct ParallelMergeSortTask
+ * @brief The shared state and thread id passed to each parallelMergeSortWorker
+ */
+typedef struct {
+    unsigned long int *array;
+    unsigned long int *scratch;
+    int n;
+    int threads;
+    int id;
+    pthread_barrier_t *barrier;
+} ParallelMergeSortTask;
+
+/**
+ * @struct QuickSortRange
+ * @brief A range array[low..high] left to sort, and the partitioning depth it has left
+ */
+typedef struct {
+    int low;
+    int high;
+    int depthLimit;
+} QuickSortRange;
+
+/**
+ * @struct WorkStealingDeque
+ * @brief The ranges waiting to be sorted by one thread. The owner pushes and pops at the
+ * bottom (newest, smallest ranges), other threads steal from the top (oldest, largest ranges).
+ */
+typedef struct {
+    QuickSortRange *ranges;
+    int top;
+    int bottom;
+    int capacity;
+    pthread_mutex_t lock;
+} WorkStealingDeque;
+
+/**
+ * @struct TimSortState
+ * @brief The runs found by Tim Sort and not merged yet, and the buffer of its merges
+ * @var scratch Holds one of the two runs being merged
+ * @var minGallop Elements taken in a row from one run before galloping. It shrinks while
+ * galloping pays off and grows when it doesn't.
+ */
+typedef struct {
+    unsigned long int *array;
+    unsigned long int *scratch;
+    int minGallop;
+    int runStart[TIM_SORT_MAX_RUNS];
+    int runLength[TIM_SORT_MAX_RUNS];
+    int runsCount;
+} TimSortState;
+
+/**
+ * @struct ParallelSampleSortTask
+ * @brief The shared state and thread id passed to each parallelSampleSortWorker
+ * @var splitters The bucketsCount - 1 keys separating the buckets, in ascending order
+ * @var bucketOf The bucket of every key, found while counting and reused by the scatter
+ * @var counts Keys of each bucket in the slice of each thread, a row of bucketsCount per thread
+ * @var nextBucket The next bucket no thread has claimed yet
+ */
+typedef struct {
+    unsigned long int *array;
+    unsigned long int *scratch;
+    unsigned char *bucketOf;
+    const unsigned long int *splitters;
+    int *counts;
+    int n;
+    int threads;
+    int bucketsCount;
+    int id;
+    atomic_int *nextBucket;
+    pthread_barrier_t *barrier;
+} ParallelSampleSortTask;
+
+/**
+ * @struct ParallelRadixSortTask
+ * @brief The shared state and thread id passed to each parallelLsdRadixSortWorker
+ * @var counts Keys of each digit in the slice of each thread during the current pass,
+ * a row of 2^LSD_RADIX_BITS per thread
+ */
+typedef struct {
+    unsigned long int *array;
+    unsigned long int *scratch;
+    int *counts;
+    int n;
+    int threads;
+    int id;
+    pthread_barrier_t *barrier;
+} ParallelRadixSortTask;
+
+/**
+ * @struct ParallelQuickSortTask
+ * @brief The shared state and thread id passed to each parallelQuickSortWorker
+ * @var pendingRanges Ranges pushed but not finished yet, the sort is done when it reaches 0
+ */
+typedef struct {
+    unsigned long int *array;
+    WorkStealingDeque *deques;
+    int threads;
+    int id;
+    atomic_int *pendingRanges;
+} ParallelQuickSortTask;
+
+/**
+ * @struct InputSample
+ * @brief What sort_u64 learns about the input from windows of keys spread evenly over it
+ * @var windows Number of sampled windows, of SORT_RUN_WINDOW keys each
+ * @var monotonicWindows Windows that are ascending or descending
+ * @var repeats First keys of the windows equal to the first key of another window
+ * @var keyBits Bits of the largest sampled key
+ */
+typedef struct {
+    int windows;
+    int monotonicWindows;
+    int repeats;
+    int keyBits;
+} InputSample;
+
+/*
+*
+* FUNCTION PROTOTYPES
+*
+*/
+/**
+ * @brief Samples up to SORT_SAMPLE_SIZE windows of the array, at most one key in 4 is read.
+ */
+void sampleInput(const unsigned long int *array, int n, InputSample *sample);
+
+/*
+*
+* SORTING ALGORITHMS
+*
+*/
+/**
+ * @brief Merges the sorted runs source[left..mid] and source[mid+1..right] into destination[left..right]
+ */
+void merge(const unsigned long int *source, unsigned long int *destination, int left, int mid, int right);
+/**
+ * @brief Sorts array[left..right], using scratch as the other buffer to merge into.
+ * Both buffers must hold the same elements on entry. The roles swap at every level
+ * so no copying back is needed.
+ */
+void mergeSortHelper(unsigned long int *array, unsigned long int *scratch, int left, int right);
+/**
+ * @brief Merges two separate sorted runs into the destination.
+ */
+void scalarMergeRuns(const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize, unsigned long int *destination);
+/**
+ * @brief Finds how many elements of left are among the first k elements of the
+ * stable merge of left and right (co-ranking). The rest come from right.
+ */
+int mergeCoRank(int k, const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize);
+/**
+ * @brief The work of one thread of the parallel merge sort (argument is a ParallelMergeSortTask)
+ */
+void *parallelMergeSortWorker(void *argument);
+unsigned long int medianOfThree(unsigned long int *array, int low, int high);
+int quickSortPartition(unsigned long int *array, int low, int high);
+void quickSortHelper(unsigned long int *array, int low, int high);
+/**
+ * @brief Partitions array[low..high] into three parts around a median-of-three pivot
+ * (Bentley-McIlroy): < pivot, == pivot and > pivot.
+ * @param lessEnd Where the first index of the == pivot part is stored
+ * @param greaterStart Where the last index of the == pivot part is stored
+ */
+void threeWayPartition(unsigned long int *array, int low, int high, int *lessEnd, int *greaterStart);
+/**
+ * @brief Quick sort on array[low..high] that switches to heap sort after depthLimit
+ * levels and to insertion sort on small partitions.
+ */
+void introSortHelper(unsigned long int *array, int low, int high, int depthLimit);
+/**
+ * @brief The work of one thread of the parallel quick sort (argument is a ParallelQuickSortTask).
+ * It takes ranges from its own deque, or steals them from the others when it runs out.
+ */
+void *parallelQuickSortWorker(void *argument);
+/**
+ * @brief Pushes a range at the bottom of a deque, growing it if needed.
+ */
+void pushRange(WorkStealingDeque *deque, QuickSortRange range);
+/**
+ * @brief Pops the newest range from the bottom of the thread's own deque.
+ * @return 1 if a range was popped, 0 if the deque is empty.
+ */
+int popRange(WorkStealingDeque *deque, QuickSortRange *range);
+/**
+ * @brief Steals the oldest range from the top of another thread's deque.
+ * @return 1 if a range was stolen, 0 if the deque is empty or busy.
+ */
+int stealRange(WorkStealingDeque *deque, QuickSortRange *range);
+/**
+ * @brief Heap sort on a heap where every node has arity children, with Floyd's bottom-up
+ * sift-down: the hole left at the root walks down to a leaf along the largest children,
+ * then the displaced key climbs back up from there. Keys rarely climb far, so this costs
+ * about one comparison per level instead of two.
+ * @param arity 2, 4 or 8. The 4-ary and 8-ary heaps are built in a cache-line-aligned buffer
+ * where the children of a node share a cache line, and the binary heap is built in place.
+ */
+static inline void dAryHeapSort(unsigned long int *array, int n, int arity);
+/**
+ * @brief Moves the key at the root of a d-ary heap down to its place with Floyd's bottom-up sift-down.
+ * @param heap The heap, the children of node i are heap[arity * i + 1 .. arity * i + arity]
+ * @param size Number of keys in the heap
+ */
+static inline void siftDownBottomUp(unsigned long int *heap, int size, int root, int arity);
+/**
+ * @brief Sorts the keys by the digit at shift and then each bucket by the next
+ * lower digit, permuting in place (American flag sort).
+ */
+void msdRadixSortHelper(unsigned long int *array, int n, int shift);
+/**
+ * @brief Finds the length of the run starting at low, before high. A strictly descending
+ * run is reversed in place, so that reversing keeps the sort stable.
+ */
+int countRunAndMakeAscending(unsigned long int *array, int low, int high);
+/**
+ * @brief Sorts array[low..high - 1], where array[low..start - 1] is already sorted, by
+ * inserting each following element at the position found by binary search.
+ */
+void binaryInsertionSort(unsigned long int *array, int low, int high, int start);
+/**
+ * @brief The minimum run length for n elements: between 16 and 32, so that n / minRun is
+ * a power of two or a bit less and the final merges are balanced.
+ */
+int computeMinRunLength(int n);
+/**
+ * @brief Merges the runs on top of the stack until their lengths decrease by more than the
+ * length of the next run, so that merges are between runs of similar lengths.
+ */
+void mergeCollapse(TimSortState *state);
+void mergeForceCollapse(TimSortState *state);
+/**
+ * @brief Merges the runs at i and i + 1 of the stack. The elements of the first run below the
+ * start of the second and those of the second above the end of the first are already in place.
+ */
+void mergeAt(TimSortState *state, int i);
+/**
+ * @brief Merges two adjacent runs by copying the first (shorter) run to the scratch buffer.
+ */
+void mergeLow(TimSortState *state, int base1, int length1, int base2, int length2);
+/**
+ * @brief Merges two adjacent runs from their ends by copying the second (shorter) run to the scratch buffer.
+ */
+void mergeHigh(TimSortState *state, int base1, int length1, int base2, int length2);
+/**
+ * @brief Finds where key goes in the sorted run, before any equal element, with an exponential
+ * search starting at hint then a binary search.
+ * @return k such that run[k - 1] < key <= run[k]
+ */
+int gallopLeft(unsigned long int key, const unsigned long int *run, int length, int hint);
+/**
+ * @brief Like gallopLeft(), but after any equal element.
+ * @return k such that run[k - 1] <= key < run[k]
+ */
+int gallopRight(unsigned long int key, const unsigned long int *run, int length, int hint);
+/**
+ * @brief The work of one thread of the parallel sample sort (argument is a ParallelSampleSortTask)
+ */
+void *parallelSampleSortWorker(void *argument);
+/**
+ * @brief Sorts one bucket of the parallel sample sort with simdQuickSort, unless it is already sorted.
+ */
+void sortSampleSortBucket(unsigned long int *keys, int n);
+/**
+ * @brief The work of one thread of the parallel LSD radix sort (argument is a ParallelRadixSortTask)
+ */
+void *parallelLsdRadixSortWorker(void *argument);
+
+/*
+*
+* SELECTION
+*
+*/
+/**
+ * @brief Selection of the key of rank k within array[low..high] with median-of-medians pivots,
+ * O(n) in the worst case.
+ */
+void medianOfMediansSelect(unsigned long int *array, int low, int high, int k);
+/**
+ * @brief Sorts each group of MEDIAN_OF_MEDIANS_GROUP_SIZE keys of array[low..high], gathers
+ * their medians at the start of the range and selects their median.
+ * @return The median of the medians, which has at least 3/10 of the keys on each side
+ */
+unsigned long int medianOfMedians(unsigned long int *array, int low, int high);
+/**
+ * @brief Partitions array[low..high] around a given pivot (Dijkstra's Dutch national flag):
+ * < pivot, == pivot and > pivot.
+ * @param lessEnd Where the first index of the == pivot part is stored
+ * @param greaterStart Where the last index of the == pivot part is stored
+ */
+void partitionAroundPivot(unsigned long int *array, int low, int high, unsigned long int pivot, int *lessEnd, int *greaterStart);
+
+/*
+*
+* SIMD KERNELS
+*
+*/
+/**
+ * @brief Two-way partition of array[low..high] around a pivot value.
+ * @param equalGoesRight 1 to send keys equal to the pivot right, 0 to send them left
+ * @return The first index of the right side
+ */
+int scalarPartition(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight);
+/**
+ * @brief Quick sort built on the selected kernels: vectorized two-way partitioning,
+ * sorting networks for small partitions and a heap sort fallback after too many levels.
+ */
+void simdQuickSortHelper(unsigned long int *array, int low, int high, int depthLimit);
+
+/*
+*
+* OPERATION COUNTING
+*
+*/
+/**
+ * @brief Adds the operations counted by the calling thread to the shared total. Every worker
+ * thread of a parallel algorithm calls it before it returns.
+ */
+void addWorkerOperationCounts(void);
+
+/*
+*
+* UTILITIES
+*
+*/
+/**
+ * @brief Pins the calling thread to one processor.
+ * @param processor The processor, wrapped around the number of processors
+ * @param previous Where the processors the thread could run on are saved
+ * @return 1 if the thread was pinned, 0 if not supported or if it failed.
+*/
+int pinThreadToProcessor(int processor, ThreadAffinity *previous);
+/**
+ * @brief Lets the calling thread run on the processors saved by pinThreadToProcessor() again.
+*/
+void restoreThreadAffinity(const ThreadAffinity *previous);
+
+/*
+*
+* TYPED SORTING ALGORITHMS
+*
+*/
+/**
+ * @brief Maps a float to an unsigned integer with the same order, for the radix sort:
+ * negative numbers have every bit flipped, the others only their sign bit.
+ */
+static inline uint32_t floatSortKey(float value);
+static inline uint64_t doubleSortKey(double value);
+
+/**
+ * Number of threads used by the parallel algorithms. Set at startup to the number
+ * of processors and changed by the batch mode when sweeping thread counts.
+*/
+int sortingThreads = 1;
+
+/**
+ * 1 if the threads of the parallel sample and radix sorts are pinned to one processor each.
+*/
+int pinThreads = 0;
+
+/**
+ * The kernels of the hot loops, selected at startup by selectSimdKernels() from what the CPU
+ * supports. They start as the scalar versions so they are always safe to call.
+*/
+void (*sortBlockKernel)(unsigned long int *array, int n) = insertionSort;
+int (*partitionKernel)(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight) = scalarPartition;
+void (*mergeRunsKernel)(const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize, unsigned long int *destination) = scalarMergeRuns;
+const char *simdKernelLevel = "scalar";
+
+#ifdef COUNT_OPERATIONS
+/**
+ * The operations counted by each thread, and the total of the worker threads that finished.
+*/
+_Thread_local OperationCounts threadOperationCounts;
+OperationCounts workerOperationCounts;
+pthread_mutex_t workerOperationCountsLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * The arena the sorts take their scratch space from, 1 if it is used (--arena), and the
+ * scratch memory counted since the last resetScratchMemory().
+*/
+ScratchArena scratchArena = {NULL, 0, 0, 0, 0};
+int useScratchArena = 1;
+MemoryCounts scratchCounts;
+unsigned long long scratchBytesInUse = 0;
+unsigned long long scratchSystemBytesInUse = 0;
+pthread_mutex_t scratchLock = PTHREAD_MUTEX_INITIALIZER;
+
+SortThresholds sortThresholds = {SORT_DEFAULT_INSERTION_CUTOFF, SORT_DEFAULT_RADIX_CUTOFF, SORT_DEFAULT_RADIX_LIMIT, SORT_DEFAULT_PARALLEL_CUTOFF};
+
+/*
+*
+* DISPATCH
+*
+*/
+void sort_u64(uint64_t *array, int n) {
+    #if ULONG_MAX == UINT64_MAX
+        autoSort((unsigned long int *)array, n);
+    #else
+        // The tuned algorithms sort unsigned long int, use the 64-bit typed versions instead
+        if (n >= sortThresholds.radixCutoff && n <= sortThresholds.radixLimit) {
+            lsdRadixSortU64(array, n);
+        } else {
+            introSortU64(array, n);
+        }
+    #endif
+}
+void autoSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+    if (n <= sortThresholds.insertionCutoff) {
+        insertionSort(array, n);
+        return;
+    }
+
+    int isParallel = sortingThreads > 1 && n >= sortThresholds.parallelCutoff;
+    int isRadix = n >= sortThresholds.radixCutoff && n <= sortThresholds.radixLimit;
+    if (n >= SORT_SAMPLE_MIN_SIZE) {
+        InputSample sample;
+        sampleInput(array, n, &sample);
+
+        // Sorted, reversed, organ pipe and sawtooth inputs take Tim Sort close to O(n)
+        if (sample.monotonicWindows >= sample.windows - sample.windows / 16) {
+            timSort(array, n);
+            return;
+        }
+        // Runs broken up by a few misplaced keys still give intro sort pivots close to the median
+        if (sample.monotonicWindows >= sample.windows / 2) {
+            introSort(array, n);
+            return;
+        }
+        // Repeated keys end partitions early but don't save the radix sort a single pass
+        if (sample.repeats >= sample.windows / 4) {
+            if (isParallel) {
+                parallelSampleSort(array, n);
+            } else {
+                simdQuickSort(array, n);
+            }
+            return;
+        }
+        // The radix limit is measured on 64-bit keys, narrower keys skip the passes of the high digits
+        if (n >= sortThresholds.radixCutoff && sample.keyBits <= 32) {
+            isRadix = 1;
+        }
+    }
+
+    if (isRadix) {
+        if (isParallel) {
+            parallelLsdRadixSort(array, n);
+        } else {
+            lsdRadixSort(array, n);
+        }
+    } else if (isParallel) {
+        parallelSampleSort(array, n);
+    } else {
+        simdQuickSort(array, n);
+    }
+}
+void sampleInput(const unsigned long int *array, int n, InputSample *sample) {
+    unsigned long int firstKeys[SORT_SAMPLE_SIZE];
+    unsigned long int largestKey = 0;
+    sample->windows = n / (4 * SORT_RUN_WINDOW) < SORT_SAMPLE_SIZE ? n / (4 * SORT_RUN_WINDOW) : SORT_SAMPLE_SIZE;
+    sample->monotonicWindows = 0;
+
+    // A window of random keys is monotonic with a probability of 2 / SORT_RUN_WINDOW!
+    for (int i = 0; i < sample->windows; i++) {
+        const unsigned long int *window = array + (long long)(n - SORT_RUN_WINDOW) * i / sample->windows;
+        int ascending = 1, descending = 1;
+        for (int j = 1; j < SORT_RUN_WINDOW; j++) {
+            ascending &= window[j - 1] <= window[j];
+            descending &= window[j - 1] >= window[j];
+        }
+        sample->monotonicWindows += ascending | descending;
+        firstKeys[i] = window[0];
+        largestKey |= window[0];
+    }
+
+    // Keys equal to the one before them once sorted
+    simdQuickSort(firstKeys, sample->windows);
+    sample->repeats = 0;
+    for (int i = 1; i < sample->windows; i++) {
+        sample->repeats += firstKeys[i] == firstKeys[i - 1];
+    }
+    sample->keyBits = 0;
+    while (largestKey != 0) {
+        sample->keyBits++;
+        largestKey >>= 1;
+    }
+}
+
+/*
+*
+* THRESHOLDS FILE
+*
+*/
+int loadSortThresholds(const char *filename, SortThresholds *thresholds) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    // Read into a copy so that an invalid file leaves the thresholds as they were
+    SortThresholds loaded = *thresholds;
+    char line[256];
+    int isValid = 1;
+    while (isValid && fgets(line, sizeof(line), file) != NULL) {
+        char name[64];
+        long value;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        if (sscanf(line, "%63s %ld", name, &value) != 2 || value < 1 || value > INT_MAX) {
+            isValid = 0;
+        } else if (strcmp(name, "insertion_cutoff") == 0) {
+            loaded.insertionCutoff = (int)value;
+        } else if (strcmp(name, "radix_cutoff") == 0) {
+            loaded.radixCutoff = (int)value;
+        } else if (strcmp(name, "radix_limit") == 0) {
+            loaded.radixLimit = (int)value;
+        } else if (strcmp(name, "parallel_cutoff") == 0) {
+            loaded.parallelCutoff = (int)value;
+        } else {
+            isValid = 0;
+        }
+    }
+    if (ferror(file) || loaded.radixCutoff > loaded.radixLimit) {
+        isValid = 0;
+    }
+    fclose(file);
+
+    if (isValid) {
+        *thresholds = loaded;
+    }
+    return isValid;
+}
+int saveSortThresholds(const char *filename, const SortThresholds *thresholds, const char *description) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        return 0;
+    }
+    fprintf(file, "# %s\n", description);
+    fprintf(file, "insertion_cutoff %d\n", thresholds->insertionCutoff);
+    fprintf(file, "radix_cutoff %d\n", thresholds->radixCutoff);
+    fprintf(file, "radix_limit %d\n", thresholds->radixLimit);
+    fprintf(file, "parallel_cutoff %d\n", thresholds->parallelCutoff);
+    return fclose(file) == 0;
+}
+
+/*
+*
+* SORTING ALGORITHMS
+*
+*/
+void selectionSort(unsigned long int *array, int n) {
+    for (int i = 0; i < n - 1; i++) {
+        int minIndex = i;
+        for (int j = i + 1; j < n; j++) {
+            if (COMPARE(array[j] < array[minIndex])) {
+                minIndex = j;
+            }
+        }
+        // Swap
+        unsigned long int temp = array[i];
+        array[i] = array[minIndex];
+        array[minIndex] = temp;
+        COUNT_SWAPS(1);
+    }
+}
+void bubbleSort(unsigned long int *array, int n) {
+    for (int i = 0; i < n - 1; i++) {
+        int swapped = 0;
+        for (int j = 0; j < n - i - 1; j++) {
+            if (COMPARE(array[j] > array[j + 1])) {
+                // Swap
+                unsigned long int temp = array[j];
+                array[j] = array[j + 1];
+                array[j + 1] = temp;
+                COUNT_SWAPS(1);
+                swapped = 1;
+            }
+        }
+        // Stop if already sorted
+        if (!swapped) break;
+    }
+}
+void insertionSort(unsigned long int *array, int n) {
+    for (int i = 1; i < n; i++) {
+        // Store the current element
+        unsigned long int key = array[i];
+        int j = i - 1;
+
+        // Shift elements greater than key to the right
+        while (j >= 0 && COMPARE(array[j] > key)) {
+            array[j + 1] = array[j];
+            COUNT_MOVES(1);
+            j--;
+        }
+
+        // Insert key at the correct position
+        array[j + 1] = key;
+        COUNT_MOVES(1);
+    }
+}
+void merge(const unsigned long int *source, unsigned long int *destination, int left, int mid, int right) {
+    // Merge the two runs of the source into the destination
+    mergeRunsKernel(source + left, mid - left + 1, source + mid + 1, right - mid, destination + left);
+}
+void mergeSortHelper(unsigned long int *array, unsigned long int *scratch, int left, int right) {
+    // Small ranges are sorted directly in the array
+    if (right - left + 1 <= SIMD_BLOCK_SIZE) {
+        sortBlockKernel(array + left, right - left + 1);
+        return;
+    }
+    if (left < right) {
+        // Find the middle index
+        int mid = left + (right - left) / 2;
+
+        // Recursively sort both halves into the scratch buffer, using the array as its scratch
+        mergeSortHelper(scratch, array, left, mid);
+        mergeSortHelper(scratch, array, mid + 1, right);
+
+        // Merge the sorted halves back into the array
+        merge(scratch, array, left, mid, right);
+    }
+}
+void mergeSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+
+    // A single scratch buffer for the whole sort, starting as a copy of the array
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    if (scratch == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(scratch, array, n * sizeof(unsigned long int));
+    COUNT_MOVES(n);
+
+    mergeSortHelper(array, scratch, 0, n - 1);
+
+    freeScratch(scratch);
+}
+void bottomUpMergeSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    if (scratch == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Sort blocks directly, then merge runs of width SIMD_BLOCK_SIZE, 2 * SIMD_BLOCK_SIZE, ...
+    // alternating between the two buffers
+    for (int left = 0; left < n; left += SIMD_BLOCK_SIZE) {
+        sortBlockKernel(array + left, n - left < SIMD_BLOCK_SIZE ? n - left : SIMD_BLOCK_SIZE);
+    }
+    unsigned long int *source = array;
+    unsigned long int *destination = scratch;
+    for (int width = SIMD_BLOCK_SIZE; width < n; width *= 2) {
+        for (int left = 0; left < n; left += 2 * width) {
+            int mid = left + width - 1;
+            int right = left + 2 * width - 1;
+            if (mid >= n - 1) {
+                // No right run, carry the left run over as is
+                memcpy(destination + left, source + left, (n - left) * sizeof(unsigned long int));
+                COUNT_MOVES(n - left);
+                break;
+            }
+            if (right > n - 1) {
+                right = n - 1;
+            }
+            merge(source, destination, left, mid, right);
+        }
+
+        unsigned long int *temp = source;
+        source = destination;
+        destination = temp;
+
+        // Guard against overflow of width on huge arrays
+        if (width > n / 2) break;
+    }
+
+    // The last pass may have left the result in the scratch buffer
+    if (source != array) {
+        memcpy(array, source, n * sizeof(unsigned long int));
+        COUNT_MOVES(n);
+    }
+    freeScratch(scratch);
+}
+void scalarMergeRuns(const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize, unsigned long int *destination) {
+    int i = 0, j = 0, k = 0;
+    while (i < leftSize && j < rightSize) {
+        if (COMPARE(left[i] <= right[j])) {
+            destination[k++] = left[i++];
+        } else {
+            destination[k++] = right[j++];
+        }
+    }
+    while (i < leftSize) {
+        destination[k++] = left[i++];
+    }
+    while (j < rightSize) {
+        destination[k++] = right[j++];
+    }
+    COUNT_MOVES(k);
+}
+int mergeCoRank(int k, const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize) {
+    // Binary search for the smallest i where left[i] no longer belongs before right[k - i - 1]
+    int low = k - rightSize > 0 ? k - rightSize : 0;
+    int high = k < leftSize ? k : leftSize;
+    while (low < high) {
+        int i = low + (high - low) / 2;
+        int j = k - i;
+        // Ties go to the left run to keep the merge stable
+        if (j > 0 && COMPARE(left[i] <= right[j - 1])) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+void *parallelMergeSortWorker(void *argument) {
+    ParallelMergeSortTask *task = (ParallelMergeSortTask *)argument;
+    long n = task->n;
+    int threads = task->threads;
+
+    // The array is split in one slice per thread, each slice is sorted serially
+    int sliceStart = (int)(n * task->id / threads);
+    int sliceEnd = (int)(n * (task->id + 1) / threads);
+    if (sliceEnd - sliceStart > 1) {
+        memcpy(task->scratch + sliceStart, task->array + sliceStart, (sliceEnd - sliceStart) * sizeof(unsigned long int));
+        COUNT_MOVES(sliceEnd - sliceStart);
+        mergeSortHelper(task->array, task->scratch, sliceStart, sliceEnd - 1);
+    }
+    pthread_barrier_wait(task->barrier);
+
+    // Each level merges pairs of runs of `width` slices. Every thread writes the same
+    // share of the output, so a thread may finish one merge and start the next.
+    int outputStart = sliceStart;
+    int outputEnd = sliceEnd;
+    unsigned long int *source = task->array;
+    unsigned long int *destination = task->scratch;
+    for (int width = 1; width < threads; width *= 2) {
+        for (int group = 0; group < threads; group += 2 * width) {
+            int left = (int)(n * group / threads);
+            int mid = (int)(n * (group + width < threads ? group + width : threads) / threads);
+            int right = (int)(n * (group + 2 * width < threads ? group + 2 * width : threads) / threads);
+
+            // Part of this group's output that belongs to this thread
+            int start = outputStart > left ? outputStart : left;
+            int end = outputEnd < right ? outputEnd : right;
+            if (start >= end) continue;
+
+            const unsigned long int *leftRun = source + left;
+            const unsigned long int *rightRun = source + mid;
+            int leftSize = mid - left;
+            int rightSize = right - mid;
+            int leftStart = mergeCoRank(start - left, leftRun, leftSize, rightRun, rightSize);
+            int leftEnd = mergeCoRank(end - left, leftRun, leftSize, rightRun, rightSize);
+            int rightStart = (start - left) - leftStart;
+            int rightEnd = (end - left) - leftEnd;
+            mergeRunsKernel(leftRun + leftStart, leftEnd - leftStart, rightRun + rightStart, rightEnd - rightStart, destination + start);
+        }
+
+        unsigned long int *temp = source;
+        source = destination;
+        destination = temp;
+        pthread_barrier_wait(task->barrier);
+    }
+
+    // An odd number of levels leaves the result in the scratch buffer
+    if (source != task->array && outputEnd > outputStart) {
+        memcpy(task->array + outputStart, source + outputStart, (outputEnd - outputStart) * sizeof(unsigned long int));
+        COUNT_MOVES(outputEnd - outputStart);
+    }
+    addWorkerOperationCounts();
+    return NULL;
+}
+void parallelMergeSort(unsigned long int *array, int n) {
+    int threads = sortingThreads;
+    if (threads > n / 2) {
+        threads = n / 2;
+    }
+    if (threads <= 1) {
+        mergeSort(array, n);
+        return;
+    }
+
+    // A single scratch buffer shared by all threads, each thread only touches its own ranges
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    pthread_t *workers = (pthread_t *)allocateScratch(threads * sizeof(pthread_t));
+    ParallelMergeSortTask *tasks = (ParallelMergeSortTask *)allocateScratch(threads * sizeof(ParallelMergeSortTask));
+    if (scratch == NULL || workers == NULL || tasks == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+    for (int i = 0; i < threads; i++) {
+        ParallelMergeSortTask task = {array, scratch, n, threads, i, &barrier};
+        tasks[i] = task;
+    }
+
+    // The calling thread works as thread 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, parallelMergeSortWorker, &tasks[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    parallelMergeSortWorker(&tasks[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    freeScratch(scratch);
+    freeScratch(workers);
+    freeScratch(tasks);
+}
+unsigned long int medianOfThree(unsigned long int *array, int low, int high) {
+    int mid = low + (high - low) / 2;
+    
+    // Arrange low, mid, high in sorted order
+    if (COMPARE(array[low] > array[mid])) {
+        unsigned long int temp = array[low];
+        array[low] = array[mid];
+        array[mid] = temp;
+        COUNT_SWAPS(1);
+    }
+    if (COMPARE(array[low] > array[high])) {
+        unsigned long int temp = array[low];
+        array[low] = array[high];
+        array[high] = temp;
+        COUNT_SWAPS(1);
+    }
+    if (COMPARE(array[mid] > array[high])) {
+        unsigned long int temp = array[mid];
+        array[mid] = array[high];
+        array[high] = temp;
+        COUNT_SWAPS(1);
+    }
+    
+    // Median is now at mid, swap it with high so partitioning remains the same
+    unsigned long int temp = array[mid];
+    array[mid] = array[high];
+    array[high] = temp;
+    COUNT_SWAPS(1);
+    
+    return array[high]; // Pivot value
+}
+int quickSortPartition(unsigned long int *array, int low, int high) {
+    // Choose the median-of-three as pivot
+    unsigned long int pivot = medianOfThree(array, low, high);
+    int i = low - 1;
+
+    for (int j = low; j < high; j++) {
+        // If current element is smaller than the pivot, swap
+        if (COMPARE(array[j] < pivot)) {
+            i++;
+            unsigned long int temp = array[i];
+            array[i] = array[j];
+            array[j] = temp;
+            COUNT_SWAPS(1);
+        }
+    }
+
+    // Place pivot at its correct position
+    unsigned long int temp = array[i + 1];
+    array[i + 1] = array[high];
+    array[high] = temp;
+    COUNT_SWAPS(1);
+
+    return i + 1;
+}
+void quickSortHelper(unsigned long int *array, int low, int high) {
+    if (low < high) {
+        // Partition the array and get the pivot index
+        int pivotIndex = quickSortPartition(array, low, high);
+        // Recursively sort elements before and after partition
+        quickSortHelper(array, low, pivotIndex - 1);
+        quickSortHelper(array, pivotIndex + 1, high);
+    }
+}
+void quickSort(unsigned long int *array, int n) {
+    quickSortHelper(array, 0, n - 1);
+}
+void threeWayPartition(unsigned long int *array, int low, int high, int *lessEnd, int *greaterStart) {
+    // Choose the median-of-three as pivot, it is left at array[high]
+    unsigned long int pivot = medianOfThree(array, low, high);
+    int i = low - 1, j = high;
+    int p = low - 1, q = high;
+
+    // Hoare-style scan from both ends. Elements equal to the pivot are parked at
+    // the two ends of the range, [low, p] and [q, high), as they are found.
+    while (1) {
+        while (COMPARE(array[++i] < pivot));
+        while (COMPARE(pivot < array[--j])) {
+            if (j == low) break;
+        }
+        if (i >= j) break;
+
+        unsigned long int temp = array[i];
+        array[i] = array[j];
+        array[j] = temp;
+        COUNT_SWAPS(1);
+
+        if (COMPARE(array[i] == pivot)) {
+            p++;
+            temp = array[p];
+            array[p] = array[i];
+            array[i] = temp;
+            COUNT_SWAPS(1);
+        }
+        if (COMPARE(array[j] == pivot)) {
+            q--;
+            temp = array[q];
+            array[q] = array[j];
+            array[j] = temp;
+            COUNT_SWAPS(1);
+        }
+    }
+
+    // Place the pivot at its correct position
+    unsigned long int temp = array[i];
+    array[i] = array[high];
+    array[high] = temp;
+    COUNT_SWAPS(1);
+
+    // Swap the parked equal elements from the ends into the middle
+    j = i - 1;
+    i = i + 1;
+    for (int k = low; k <= p; k++, j--) {
+        temp = array[k];
+        array[k] = array[j];
+        array[j] = temp;
+    }
+    for (int k = high - 1; k >= q; k--, i++) {
+        temp = array[k];
+        array[k] = array[i];
+        array[i] = temp;
+    }
+    COUNT_SWAPS((p - low + 1) + (high - q));
+
+    *lessEnd = j + 1;
+    *greaterStart = i - 1;
+}
+void introSortHelper(unsigned long int *array, int low, int high, int depthLimit) {
+    while (high - low + 1 > INTRO_SORT_INSERTION_CUTOFF) {
+        // Too many bad partitions, heap sort guarantees O(n log n) for the rest
+        if (depthLimit == 0) {
+            heapSort(array + low, high - low + 1);
+            return;
+        }
+        depthLimit--;
+
+        // Elements equal to the pivot are already in place and excluded from both sides
+        int lt, gt;
+        threeWayPartition(array, low, high, &lt, &gt);
+
+        // Recurse into the smaller side and loop on the larger one to keep the stack O(log n)
+        if (lt - low < high - gt) {
+            introSortHelper(array, low, lt - 1, depthLimit);
+            low = gt + 1;
+        } else {
+            introSortHelper(array, gt + 1, high, depthLimit);
+            high = lt - 1;
+        }
+    }
+
+    // Small partitions are fastest with insertion sort or a sorting network
+    if (high > low) {
+        sortBlockKernel(array + low, high - low + 1);
+    }
+}
+void introSort(unsigned long int *array, int n) {
+    // Allow 2 * floor(log2(n)) levels of partitioning before falling back to heap sort
+    int depthLimit = 0;
+    for (int size = n; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    introSortHelper(array, 0, n - 1, depthLimit);
+}
+void heapify(unsigned long int *array, int n, int root) {
+    int largest = root;
+    int leftChild = 2 * root + 1;
+    int rightChild = 2 * root + 2;
+
+    // Check if left child is larger than root
+    if (leftChild < n && COMPARE(array[leftChild] > array[largest])) {
+        largest = leftChild;
+    }
+
+    // Check if right child is larger than the largest so far
+    if (rightChild < n && COMPARE(array[rightChild] > array[largest])) {
+        largest = rightChild;
+    }
+
+    // Swap and continue heapifying if root is not the largest
+    if (largest != root) {
+        unsigned long int temp = array[root];
+        array[root] = array[largest];
+        array[largest] = temp;
+        COUNT_SWAPS(1);
+
+        heapify(array, n, largest);
+    }
+}
+void heapSort(unsigned long int *array, int n) {
+    // Build a max heap
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        heapify(array, n, i);
+    }
+
+    // Extract elements one by one from heap
+    for (int i = n - 1; i > 0; i--) {
+        // Swap root (largest) with the last element
+        unsigned long int temp = array[0];
+        array[0] = array[i];
+        array[i] = temp;
+        COUNT_SWAPS(1);
+
+        // Heapify the reduced heap
+        heapify(array, i, 0);
+    }
+}
+static inline void dAryHeapSort(unsigned long int *array, int n, int arity) {
+    if (n < 2) return;
+
+    // Node 0 goes at buffer[arity - 1], so the children of every node start at a multiple
+    // of arity keys from the aligned buffer and share one cache line
+    unsigned long int *buffer = NULL;
+    unsigned long int *heap = array;
+    if (arity > 2) {
+        buffer = (unsigned long int *)allocateScratch(((size_t)n + arity - 1) * sizeof(unsigned long int));
+        if (buffer == NULL) {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        heap = buffer + arity - 1;
+        memcpy(heap, array, n * sizeof(unsigned long int));
+        COUNT_MOVES(n);
+    }
+
+    // Build the heap from the last parent up, without recursion
+    for (int i = (n - 2) / arity; i >= 0; i--) {
+        siftDownBottomUp(heap, n, i, arity);
+    }
+
+    // The root (largest) goes after the heap, and the key it replaces sifts down from the root
+    for (int size = n - 1; size > 0; size--) {
+        unsigned long int last = heap[size];
+        heap[size] = heap[0];
+        heap[0] = last;
+        COUNT_SWAPS(1);
+        siftDownBottomUp(heap, size, 0, arity);
+    }
+
+    if (buffer != NULL) {
+        memcpy(array, heap, n * sizeof(unsigned long int));
+        COUNT_MOVES(n);
+        freeScratch(buffer);
+    }
+}
+static inline void siftDownBottomUp(unsigned long int *heap, int size, int root, int arity) {
+    unsigned long int key = heap[root];
+    int hole = root;
+
+    // Walk the hole down to a leaf, always moving up the largest child
+    long firstChild;
+    while ((firstChild = (long)arity * hole + 1) < size) {
+        // The grandchildren are a level of cache misses ahead, one line per child
+        long firstGrandchild = (long)arity * firstChild + 1;
+        for (int c = 0; c < arity && firstGrandchild + (long)c * arity < size; c++) {
+            PREFETCH(heap + firstGrandchild + (long)c * arity);
+        }
+
+        int largest = (int)firstChild;
+        int lastChild = firstChild + arity < size ? (int)firstChild + arity : size;
+        for (int child = (int)firstChild + 1; child < lastChild; child++) {
+            if (COMPARE(heap[child] > heap[largest])) largest = child;
+        }
+        heap[hole] = heap[largest];
+        COUNT_MOVES(1);
+        hole = largest;
+    }
+
+    // Then climb back up to where the key belongs, usually only a level or two
+    while (hole > root) {
+        int parent = (hole - 1) / arity;
+        if (!COMPARE(heap[parent] < key)) break;
+        heap[hole] = heap[parent];
+        COUNT_MOVES(1);
+        hole = parent;
+    }
+    heap[hole] = key;
+    COUNT_MOVES(1);
+}
+void bottomUpHeapSort(unsigned long int *array, int n) {
+    dAryHeapSort(array, n, 2);
+}
+void quaternaryHeapSort(unsigned long int *array, int n) {
+    dAryHeapSort(array, n, 4);
+}
+void octonaryHeapSort(unsigned long int *array, int n) {
+    dAryHeapSort(array, n, 8);
+}
+
+void pushRange(WorkStealingDeque *deque, QuickSortRange range) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom == deque->capacity) {
+        // Reclaim the slots freed by steals before growing
+        int size = deque->bottom - deque->top;
+        if (deque->top > 0) {
+            memmove(deque->ranges, deque->ranges + deque->top, size * sizeof(QuickSortRange));
+        } else {
+            deque->capacity *= 2;
+            QuickSortRange *grown = (QuickSortRange *)reallocateScratch(deque->ranges, deque->capacity * sizeof(QuickSortRange));
+            if (grown == NULL) {
+                perror("Memory allocation failed");
+                exit(EXIT_FAILURE);
+            }
+            deque->ranges = grown;
+        }
+        deque->top = 0;
+        deque->bottom = size;
+    }
+    deque->ranges[deque->bottom++] = range;
+    pthread_mutex_unlock(&deque->lock);
+}
+int popRange(WorkStealingDeque *deque, QuickSortRange *range) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        *range = deque->ranges[--deque->bottom];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+int stealRange(WorkStealingDeque *deque, QuickSortRange *range) {
+    int found = 0;
+    // Don't wait on a busy deque, the thief will try another one
+    if (pthread_mutex_trylock(&deque->lock) != 0) {
+        return 0;
+    }
+    if (deque->bottom > deque->top) {
+        *range = deque->ranges[deque->top++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+void *parallelQuickSortWorker(void *argument) {
+    ParallelQuickSortTask *task = (ParallelQuickSortTask *)argument;
+    WorkStealingDeque *ownDeque = &task->deques[task->id];
+    unsigned int victimSeed = (unsigned int)task->id * 2654435761u + 1;
+
+    while (atomic_load(task->pendingRanges) > 0) {
+        QuickSortRange range;
+        int found = popRange(ownDeque, &range);
+
+        // Out of work, try to steal from a random thread
+        for (int attempt = 0; !found && attempt < task->threads; attempt++) {
+            victimSeed = victimSeed * 1103515245u + 12345u;
+            int victim = (int)((victimSeed >> 16) % (unsigned int)task->threads);
+            if (victim != task->id) {
+                found = stealRange(&task->deques[victim], &range);
+            }
+        }
+        if (!found) {
+            sched_yield();
+            continue;
+        }
+
+        // Partition down to the grain size, pushing one side and continuing with the other
+        int low = range.low, high = range.high, depthLimit = range.depthLimit;
+        while (high - low + 1 > PARALLEL_QUICK_SORT_GRAIN && depthLimit > 0) {
+            depthLimit--;
+            int lt, gt;
+            threeWayPartition(task->array, low, high, &lt, &gt);
+
+            // Push the larger side so that thieves take big chunks of work
+            QuickSortRange pushed;
+            if (lt - low > high - gt) {
+                pushed.low = low;
+                pushed.high = lt - 1;
+                low = gt + 1;
+            } else {
+                pushed.low = gt + 1;
+                pushed.high = high;
+                high = lt - 1;
+            }
+            pushed.depthLimit = depthLimit;
+            if (pushed.high > pushed.low) {
+                atomic_fetch_add(task->pendingRanges, 1);
+                pushRange(ownDeque, pushed);
+            }
+        }
+
+        // Below the grain size (or out of depth), finish serially
+        if (high > low) {
+            introSortHelper(task->array, low, high, depthLimit);
+        }
+        atomic_fetch_sub(task->pendingRanges, 1);
+    }
+    addWorkerOperationCounts();
+    return NULL;
+}
+void parallelQuickSort(unsigned long int *array, int n) {
+    int threads = sortingThreads;
+    if (threads <= 1 || n <= PARALLEL_QUICK_SORT_GRAIN) {
+        introSort(array, n);
+        return;
+    }
+
+    pthread_t *workers = (pthread_t *)allocateScratch(threads * sizeof(pthread_t));
+    ParallelQuickSortTask *tasks = (ParallelQuickSortTask *)allocateScratch(threads * sizeof(ParallelQuickSortTask));
+    WorkStealingDeque *deques = (WorkStealingDeque *)allocateScratch(threads * sizeof(WorkStealingDeque));
+    if (workers == NULL || tasks == NULL || deques == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < threads; i++) {
+        deques[i].capacity = 64;
+        deques[i].ranges = (QuickSortRange *)allocateScratch(deques[i].capacity * sizeof(QuickSortRange));
+        deques[i].top = 0;
+        deques[i].bottom = 0;
+        if (deques[i].ranges == NULL) {
+            perror("Memory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        pthread_mutex_init(&deques[i].lock, NULL);
+    }
+
+    // Same depth limit as introSort, the whole array starts on thread 0's deque
+    int depthLimit = 0;
+    for (int size = n; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    QuickSortRange whole = {0, n - 1, depthLimit};
+    atomic_int pendingRanges = 1;
+    pushRange(&deques[0], whole);
+
+    for (int i = 0; i < threads; i++) {
+        ParallelQuickSortTask task = {array, deques, threads, i, &pendingRanges};
+        tasks[i] = task;
+    }
+
+    // The calling thread works as thread 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, parallelQuickSortWorker, &tasks[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    parallelQuickSortWorker(&tasks[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_destroy(&deques[i].lock);
+        freeScratch(deques[i].ranges);
+    }
+    freeScratch(deques);
+    freeScratch(workers);
+    freeScratch(tasks);
+}
+void lsdRadixSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+
+    const int passes = (KEY_BITS + LSD_RADIX_BITS - 1) / LSD_RADIX_BITS;
+    const int buckets = 1 << LSD_RADIX_BITS;
+    const unsigned long int mask = (unsigned long int)buckets - 1;
+
+    int *counts = (int *)allocateZeroedScratch((size_t)passes * buckets, sizeof(int));
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    if (counts == NULL || scratch == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Count the digits of every pass in one read of the array
+    for (int i = 0; i < n; i++) {
+        unsigned long int key = array[i];
+        for (int pass = 0; pass < passes; pass++) {
+            counts[pass * buckets + ((key >> (pass * LSD_RADIX_BITS)) & mask)]++;
+        }
+    }
+
+    unsigned long int *source = array;
+    unsigned long int *destination = scratch;
+    for (int pass = 0; pass < passes; pass++) {
+        int *count = counts + pass * buckets;
+        int shift = pass * LSD_RADIX_BITS;
+
+        // Every key has the same digit, this pass would not move anything
+        if (count[(source[0] >> shift) & mask] == n) continue;
+
+        // Turn the counts into the starting offset of each bucket
+        int offset = 0;
+        for (int b = 0; b < buckets; b++) {
+            int bucketSize = count[b];
+            count[b] = offset;
+            offset += bucketSize;
+        }
+
+        // Stable scatter into the other buffer
+        for (int i = 0; i < n; i++) {
+            unsigned long int key = source[i];
+            destination[count[(key >> shift) & mask]++] = key;
+        }
+        COUNT_MOVES(n);
+
+        unsigned long int *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (source != array) {
+        memcpy(array, source, n * sizeof(unsigned long int));
+        COUNT_MOVES(n);
+    }
+    freeScratch(counts);
+    freeScratch(scratch);
+}
+void msdRadixSortHelper(unsigned long int *array, int n, int shift) {
+    const int buckets = 1 << MSD_RADIX_BITS;
+    const unsigned long int mask = (unsigned long int)buckets - 1;
+
+    // Small buckets are fastest with insertion sort
+    if (n <= MSD_RADIX_INSERTION_CUTOFF) {
+        insertionSort(array, n);
+        return;
+    }
+
+    int count[1 << MSD_RADIX_BITS] = {0};
+    for (int i = 0; i < n; i++) {
+        count[(array[i] >> shift) & mask]++;
+    }
+
+    // head[b] is the next slot to fill in bucket b, tail[b] is the end of bucket b
+    int head[1 << MSD_RADIX_BITS];
+    int tail[1 << MSD_RADIX_BITS];
+    int offset = 0;
+    for (int b = 0; b < buckets; b++) {
+        head[b] = offset;
+        offset += count[b];
+        tail[b] = offset;
+    }
+
+    // Skip the permutation when every key has the same digit
+    if (count[(array[0] >> shift) & mask] != n) {
+        // Move each key straight to its bucket, following the cycle of displaced keys
+        for (int b = 0; b < buckets; b++) {
+            while (head[b] < tail[b]) {
+                unsigned long int key = array[head[b]];
+                int digit = (int)((key >> shift) & mask);
+                while (digit != b) {
+                    unsigned long int displaced = array[head[digit]];
+                    array[head[digit]++] = key;
+                    key = displaced;
+                    digit = (int)((key >> shift) & mask);
+                }
+                array[head[b]++] = key;
+            }
+        }
+        // Every slot of the range is written exactly once
+        COUNT_MOVES(n);
+    }
+
+    // Sort each bucket by the next digit
+    if (shift > 0) {
+        int nextShift = shift > MSD_RADIX_BITS ? shift - MSD_RADIX_BITS : 0;
+        int start = 0;
+        for (int b = 0; b < buckets; b++) {
+            if (count[b] > 1) {
+                msdRadixSortHelper(array + start, count[b], nextShift);
+            }
+            start += count[b];
+        }
+    }
+}
+void msdRadixSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+    msdRadixSortHelper(array, n, KEY_BITS - MSD_RADIX_BITS);
+}
+void timSort(unsigned long int *array, int n) {
+    if (n < 2) return;
+
+    // Too short to be worth merging
+    if (n < TIM_SORT_MIN_MERGE) {
+        int runLength = countRunAndMakeAscending(array, 0, n);
+        binaryInsertionSort(array, 0, n, runLength);
+        return;
+    }
+
+    TimSortState state;
+    state.array = array;
+    state.scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    state.minGallop = TIM_SORT_MIN_GALLOP;
+    state.runsCount = 0;
+    if (state.scratch == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    int minRun = computeMinRunLength(n);
+    for (int low = 0; low < n; ) {
+        // Short runs are extended to minRun elements
+        int runLength = countRunAndMakeAscending(array, low, n);
+        if (runLength < minRun) {
+            int forced = n - low < minRun ? n - low : minRun;
+            if (runLength < SIMD_BLOCK_SIZE && forced > SIMD_BLOCK_SIZE) {
+                // Mostly unordered, so two kernel-sorted blocks merged beat binary insertion
+                sortBlockKernel(array + low, SIMD_BLOCK_SIZE);
+                sortBlockKernel(array + low + SIMD_BLOCK_SIZE, forced - SIMD_BLOCK_SIZE);
+                memcpy(state.scratch, array + low, SIMD_BLOCK_SIZE * sizeof(unsigned long int));
+                COUNT_MOVES(SIMD_BLOCK_SIZE);
+                mergeRunsKernel(state.scratch, SIMD_BLOCK_SIZE, array + low + SIMD_BLOCK_SIZE, forced - SIMD_BLOCK_SIZE, array + low);
+            } else {
+                binaryInsertionSort(array, low, low + forced, low + runLength);
+            }
+            runLength = forced;
+        }
+
+        state.runStart[state.runsCount] = low;
+        state.runLength[state.runsCount] = runLength;
+        state.runsCount++;
+        mergeCollapse(&state);
+        low += runLength;
+    }
+    mergeForceCollapse(&state);
+    freeScratch(state.scratch);
+}
+int countRunAndMakeAscending(unsigned long int *array, int low, int high) {
+    int runHigh = low + 1;
+    if (runHigh == high) return 1;
+
+    if (COMPARE(array[runHigh++] < array[low])) {
+        // Only strictly descending, reversing equal elements would break stability
+        while (runHigh < high && COMPARE(array[runHigh] < array[runHigh - 1])) runHigh++;
+        for (int i = low, j = runHigh - 1; i < j; i++, j--) {
+            unsigned long int temp = array[i];
+            array[i] = array[j];
+            array[j] = temp;
+            COUNT_SWAPS(1);
+        }
+    } else {
+        while (runHigh < high && COMPARE(array[runHigh] >= array[runHigh - 1])) runHigh++;
+    }
+    return runHigh - low;
+}
+void binaryInsertionSort(unsigned long int *array, int low, int high, int start) {
+    if (start == low) start++;
+    for (; start < high; start++) {
+        unsigned long int pivot = array[start];
+
+        // After the equal elements, for stability
+        int left = low, right = start;
+        while (left < right) {
+            int mid = left + (right - left) / 2;
+            if (COMPARE(pivot < array[mid])) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        memmove(array + left + 1, array + left, (start - left) * sizeof(unsigned long int));
+        array[left] = pivot;
+        COUNT_MOVES(start - left + 1);
+    }
+}
+int computeMinRunLength(int n) {
+    // The 5 highest bits of n, plus 1 if any of the lower bits is set
+    int lowBits = 0;
+    while (n >= TIM_SORT_MIN_MERGE) {
+        lowBits |= n & 1;
+        n >>= 1;
+    }
+    return n + lowBits;
+}
+void mergeCollapse(TimSortState *state) {
+    int *length = state->runLength;
+    while (state->runsCount > 1) {
+        int i = state->runsCount - 2;
+        // Checking the fourth run from the top too keeps the invariant on the whole stack
+        if ((i > 0 && length[i - 1] <= length[i] + length[i + 1]) || (i > 1 && length[i - 2] <= length[i - 1] + length[i])) {
+            if (length[i - 1] < length[i + 1]) i--;
+        } else if (length[i] > length[i + 1]) {
+            break;
+        }
+        mergeAt(state, i);
+    }
+}
+void mergeForceCollapse(TimSortState *state) {
+    while (state->runsCount > 1) {
+        int i = state->runsCount - 2;
+        if (i > 0 && state->runLength[i - 1] < state->runLength[i + 1]) i--;
+        mergeAt(state, i);
+    }
+}
+void mergeAt(TimSortState *state, int i) {
+    unsigned long int *array = state->array;
+    int base1 = state->runStart[i];
+    int length1 = state->runLength[i];
+    int base2 = state->runStart[i + 1];
+    int length2 = state->runLength[i + 1];
+
+    // The merged run replaces both, the run above them (if any) moves down
+    state->runLength[i] = length1 + length2;
+    if (i == state->runsCount - 3) {
+        state->runStart[i + 1] = state->runStart[i + 2];
+        state->runLength[i + 1] = state->runLength[i + 2];
+    }
+    state->runsCount--;
+
+    // Skip the start of the first run and the end of the second run, already in place
+    int k = gallopRight(array[base2], array + base1, length1, 0);
+    base1 += k;
+    length1 -= k;
+    if (length1 == 0) return;
+    length2 = gallopLeft(array[base1 + length1 - 1], array + base2, length2, length2 - 1);
+    if (length2 == 0) return;
+
+    // Runs of similar lengths while galloping doesn't pay off (e.g. random data) merge fastest
+    // with the merge kernel. The first run is copied out and the merge writes behind the reads
+    // of the second run, which is safe for every merge kernel.
+    int isBalanced = length1 <= TIM_SORT_BALANCED_RATIO * length2 && length2 <= TIM_SORT_BALANCED_RATIO * length1;
+    if (isBalanced && state->minGallop >= TIM_SORT_MIN_GALLOP) {
+        memcpy(state->scratch, array + base1, length1 * sizeof(unsigned long int));
+        COUNT_MOVES(length1);
+        mergeRunsKernel(state->scratch, length1, array + base2, length2, array + base1);
+    } else if (length1 <= length2) {
+        mergeLow(state, base1, length1, base2, length2);
+    } else {
+        mergeHigh(state, base1, length1, base2, length2);
+    }
+}
+void mergeLow(TimSortState *state, int base1, int length1, int base2, int length2) {
+    unsigned long int *array = state->array;
+    unsigned long int *scratch = state->scratch;
+    memcpy(scratch, array + base1, length1 * sizeof(unsigned long int));
+    COUNT_MOVES(length1);
+
+    int cursor1 = 0;
+    int cursor2 = base2;
+    int destination = base1;
+    int minGallop = state->minGallop;
+
+    // The first element of the second run is the smallest (see mergeAt)
+    array[destination++] = array[cursor2++];
+    COUNT_MOVES(1);
+    length2--;
+
+    int isDone = length2 == 0 || length1 == 1;
+    while (!isDone) {
+        // One element at a time until a run wins minGallop times in a row
+        int count1 = 0, count2 = 0;
+        do {
+            if (COMPARE(array[cursor2] < scratch[cursor1])) {
+                array[destination++] = array[cursor2++];
+                count2++;
+                count1 = 0;
+                isDone = --length2 == 0;
+            } else {
+                array[destination++] = scratch[cursor1++];
+                count1++;
+                count2 = 0;
+                isDone = --length1 == 1;
+            }
+            COUNT_MOVES(1);
+        } while (!isDone && (count1 | count2) < minGallop);
+
+        // Then move whole stretches found by galloping, while they stay long
+        while (!isDone) {
+            count1 = gallopRight(array[cursor2], scratch + cursor1, length1, 0);
+            if (count1 != 0) {
+                memcpy(array + destination, scratch + cursor1, count1 * sizeof(unsigned long int));
+                COUNT_MOVES(count1);
+                destination += count1;
+                cursor1 += count1;
+                length1 -= count1;
+                if (length1 <= 1) { isDone = 1; break; }
+            }
+            array[destination++] = array[cursor2++];
+            COUNT_MOVES(1);
+            if (--length2 == 0) { isDone = 1; break; }
+
+            count2 = gallopLeft(scratch[cursor1], array + cursor2, length2, 0);
+            if (count2 != 0) {
+                memmove(array + destination, array + cursor2, count2 * sizeof(unsigned long int));
+                COUNT_MOVES(count2);
+                destination += count2;
+                cursor2 += count2;
+                length2 -= count2;
+                if (length2 == 0) { isDone = 1; break; }
+            }
+            array[destination++] = scratch[cursor1++];
+            COUNT_MOVES(1);
+            if (--length1 == 1) { isDone = 1; break; }
+
+            minGallop--;
+            if (count1 < TIM_SORT_MIN_GALLOP && count2 < TIM_SORT_MIN_GALLOP) break;
+        }
+        if (!isDone) {
+            // Galloping stopped paying off, make it harder to start again
+            if (minGallop < 0) minGallop = 0;
+            minGallop += 2;
+        }
+    }
+    state->minGallop = minGallop < 1 ? 1 : minGallop;
+
+    if (length1 == 1) {
+        // The last element of the first run is the largest of what is left
+        memmove(array + destination, array + cursor2, length2 * sizeof(unsigned long int));
+        array[destination + length2] = scratch[cursor1];
+        COUNT_MOVES(length2 + 1);
+    } else {
+        memcpy(array + destination, scratch + cursor1, length1 * sizeof(unsigned long int));
+        COUNT_MOVES(length1);
+    }
+}
+void mergeHigh(TimSortState *state, int base1, int length1, int base2, int length2) {
+    unsigned long int *array = state->array;
+    unsigned long int *scratch = state->scratch;
+    memcpy(scratch, array + base2, length2 * sizeof(unsigned long int));
+    COUNT_MOVES(length2);
+
+    int cursor1 = base1 + length1 - 1;
+    int cursor2 = length2 - 1;
+    int destination = base2 + length2 - 1;
+    int minGallop = state->minGallop;
+
+    // The last element of the first run is the largest (see mergeAt)
+    array[destination--] = array[cursor1--];
+    COUNT_MOVES(1);
+    length1--;
+
+    int isDone = length1 == 0 || length2 == 1;
+    while (!isDone) {
+        int count1 = 0, count2 = 0;
+        do {
+            if (COMPARE(scratch[cursor2] < array[cursor1])) {
+                array[destination--] = array[cursor1--];
+                count1++;
+                count2 = 0;
+                isDone = --length1 == 0;
+            } else {
+                array[destination--] = scratch[cursor2--];
+                count2++;
+                count1 = 0;
+                isDone = --length2 == 1;
+            }
+            COUNT_MOVES(1);
+        } while (!isDone && (count1 | count2) < minGallop);
+
+        while (!isDone) {
+            count1 = length1 - gallopRight(scratch[cursor2], array + base1, length1, length1 - 1);
+            if (count1 != 0) {
+                destination -= count1;
+                cursor1 -= count1;
+                length1 -= count1;
+                memmove(array + destination + 1, array + cursor1 + 1, count1 * sizeof(unsigned long int));
+                COUNT_MOVES(count1);
+                if (length1 == 0) { isDone = 1; break; }
+            }
+            array[destination--] = scratch[cursor2--];
+            COUNT_MOVES(1);
+            if (--length2 == 1) { isDone = 1; break; }
+
+            count2 = length2 - gallopLeft(array[cursor1], scratch, length2, length2 - 1);
+            if (count2 != 0) {
+                destination -= count2;
+                cursor2 -= count2;
+                length2 -= count2;
+                memcpy(array + destination + 1, scratch + cursor2 + 1, count2 * sizeof(unsigned long int));
+                COUNT_MOVES(count2);
+                if (length2 <= 1) { isDone = 1; break; }
+            }
+            array[destination--] = array[cursor1--];
+            COUNT_MOVES(1);
+            if (--length1 == 0) { isDone = 1; break; }
+
+            minGallop--;
+            if (count1 < TIM_SORT_MIN_GALLOP && count2 < TIM_SORT_MIN_GALLOP) break;
+        }
+        if (!isDone) {
+            if (minGallop < 0) minGallop = 0;
+            minGallop += 2;
+        }
+    }
+    state->minGallop = minGallop < 1 ? 1 : minGallop;
+
+    if (length2 == 1) {
+        // The first element of the second run is the smallest of what is left
+        destination -= length1;
+        cursor1 -= length1;
+        memmove(array + destination + 1, array + cursor1 + 1, length1 * sizeof(unsigned long int));
+        array[destination] = scratch[cursor2];
+        COUNT_MOVES(length1 + 1);
+    } else {
+        memcpy(array + destination - (length2 - 1), scratch, length2 * sizeof(unsigned long int));
+        COUNT_MOVES(length2);
+    }
+}
+int gallopLeft(unsigned long int key, const unsigned long int *run, int length, int hint) {
+    // Exponential search from the hint for a range holding the position
+    int lastOffset = 0, offset = 1;
+    if (COMPARE(key > run[hint])) {
+        int maxOffset = length - hint;
+        while (offset < maxOffset && COMPARE(key > run[hint + offset])) {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+            if (offset <= 0) offset = maxOffset;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        lastOffset += hint;
+        offset += hint;
+    } else {
+        int maxOffset = hint + 1;
+        while (offset < maxOffset && COMPARE(key <= run[hint - offset])) {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+            if (offset <= 0) offset = maxOffset;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        int temp = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - temp;
+    }
+
+    // Binary search in run[lastOffset + 1 .. offset]
+    lastOffset++;
+    while (lastOffset < offset) {
+        int mid = lastOffset + (offset - lastOffset) / 2;
+        if (COMPARE(key > run[mid])) {
+            lastOffset = mid + 1;
+        } else {
+            offset = mid;
+        }
+    }
+    return offset;
+}
+int gallopRight(unsigned long int key, const unsigned long int *run, int length, int hint) {
+    int lastOffset = 0, offset = 1;
+    if (COMPARE(key < run[hint])) {
+        int maxOffset = hint + 1;
+        while (offset < maxOffset && COMPARE(key < run[hint - offset])) {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+            if (offset <= 0) offset = maxOffset;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        int temp = lastOffset;
+        lastOffset = hint - offset;
+        offset = hint - temp;
+    } else {
+        int maxOffset = length - hint;
+        while (offset < maxOffset && COMPARE(key >= run[hint + offset])) {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+            if (offset <= 0) offset = maxOffset;
+        }
+        if (offset > maxOffset) offset = maxOffset;
+        lastOffset += hint;
+        offset += hint;
+    }
+
+    lastOffset++;
+    while (lastOffset < offset) {
+        int mid = lastOffset + (offset - lastOffset) / 2;
+        if (COMPARE(key < run[mid])) {
+            offset = mid;
+        } else {
+            lastOffset = mid + 1;
+        }
+    }
+    return offset;
+}
+void *parallelSampleSortWorker(void *argument) {
+    ParallelSampleSortTask *task = (ParallelSampleSortTask *)argument;
+    long n = task->n;
+    int threads = task->threads;
+    int bucketsCount = task->bucketsCount;
+    ThreadAffinity affinity;
+    int isPinned = pinThreads && pinThreadToProcessor(task->id, &affinity);
+
+    // Find the bucket of every key of this thread's slice. bucketsCount is a power of 2, so
+    // the splitters form a complete binary search tree searched in log2(bucketsCount) steps.
+    int sliceStart = (int)(n * task->id / threads);
+    int sliceEnd = (int)(n * (task->id + 1) / threads);
+    int *count = task->counts + task->id * bucketsCount;
+    for (int i = sliceStart; i < sliceEnd; i++) {
+        unsigned long int key = task->array[i];
+        int bucket = 0;
+        for (int step = bucketsCount / 2; step > 0; step /= 2) {
+            if (COMPARE(key >= task->splitters[bucket + step - 1])) bucket += step;
+        }
+        task->bucketOf[i] = (unsigned char)bucket;
+        count[bucket]++;
+    }
+    pthread_barrier_wait(task->barrier);
+
+    // This thread's keys of a bucket go after the smaller buckets and after the keys of
+    // the same bucket from the threads before it
+    int offsets[SAMPLE_SORT_MAX_BUCKETS];
+    int bucketStarts[SAMPLE_SORT_MAX_BUCKETS + 1];
+    int total = 0;
+    for (int bucket = 0; bucket < bucketsCount; bucket++) {
+        bucketStarts[bucket] = total;
+        for (int t = 0; t < threads; t++) {
+            if (t == task->id) offsets[bucket] = total;
+            total += task->counts[t * bucketsCount + bucket];
+        }
+    }
+    bucketStarts[bucketsCount] = total;
+    for (int i = sliceStart; i < sliceEnd; i++) {
+        task->scratch[offsets[task->bucketOf[i]]++] = task->array[i];
+    }
+    COUNT_MOVES(sliceEnd - sliceStart);
+    pthread_barrier_wait(task->barrier);
+
+    // Buckets are claimed one at a time, a thread with a large bucket takes fewer of them
+    int bucket;
+    while ((bucket = atomic_fetch_add(task->nextBucket, 1)) < bucketsCount) {
+        int start = bucketStarts[bucket];
+        int size = bucketStarts[bucket + 1] - start;
+        sortSampleSortBucket(task->scratch + start, size);
+        memcpy(task->array + start, task->scratch + start, size * sizeof(unsigned long int));
+        COUNT_MOVES(size);
+    }
+
+    if (isPinned) {
+        restoreThreadAffinity(&affinity);
+    }
+    addWorkerOperationCounts();
+    return NULL;
+}
+void sortSampleSortBucket(unsigned long int *keys, int n) {
+    // The scatter keeps the order of the keys, so presorted data gives sorted buckets
+    for (int i = 1; i < n; i++) {
+        if (COMPARE(keys[i] < keys[i - 1])) {
+            simdQuickSort(keys, n);
+            return;
+        }
+    }
+}
+void parallelSampleSort(unsigned long int *array, int n) {
+    int threads = sortingThreads;
+    if (threads > n / PARALLEL_SORT_MIN_SLICE) {
+        threads = n / PARALLEL_SORT_MIN_SLICE;
+    }
+    if (threads <= 1) {
+        sortSampleSortBucket(array, n);
+        return;
+    }
+
+    // The smallest power of 2 of at least SAMPLE_SORT_BUCKETS_PER_THREAD buckets per thread
+    int bucketsCount = 2;
+    while (bucketsCount < threads * SAMPLE_SORT_BUCKETS_PER_THREAD && bucketsCount < SAMPLE_SORT_MAX_BUCKETS) {
+        bucketsCount *= 2;
+    }
+
+    int sampleSize = bucketsCount * SAMPLE_SORT_OVERSAMPLING;
+    unsigned long int *sample = (unsigned long int *)allocateScratch(sampleSize * sizeof(unsigned long int));
+    unsigned long int *splitters = (unsigned long int *)allocateScratch(bucketsCount * sizeof(unsigned long int));
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    unsigned char *bucketOf = (unsigned char *)allocateScratch(n * sizeof(unsigned char));
+    int *counts = (int *)allocateZeroedScratch((size_t)threads * bucketsCount, sizeof(int));
+    pthread_t *workers = (pthread_t *)allocateScratch(threads * sizeof(pthread_t));
+    ParallelSampleSortTask *tasks = (ParallelSampleSortTask *)allocateScratch(threads * sizeof(ParallelSampleSortTask));
+    if (sample == NULL || splitters == NULL || scratch == NULL || bucketOf == NULL || counts == NULL || workers == NULL || tasks == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Every SAMPLE_SORT_OVERSAMPLING-th key of the sorted sample splits two buckets. The sample
+    // is drawn from a fixed stream so that every run of the same data gets the same buckets.
+    RandomGenerator generator;
+    seedRandomGenerator(&generator, (uint64_t)n, 0);
+    for (int i = 0; i < sampleSize; i++) {
+        sample[i] = array[nextRandom(&generator) % (uint64_t)n];
+    }
+    introSort(sample, sampleSize);
+    for (int bucket = 1; bucket < bucketsCount; bucket++) {
+        splitters[bucket - 1] = sample[bucket * SAMPLE_SORT_OVERSAMPLING];
+    }
+
+    atomic_int nextBucket;
+    atomic_init(&nextBucket, 0);
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+    for (int i = 0; i < threads; i++) {
+        ParallelSampleSortTask task = {array, scratch, bucketOf, splitters, counts, n, threads, bucketsCount, i, &nextBucket, &barrier};
+        tasks[i] = task;
+    }
+
+    // The calling thread works as thread 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, parallelSampleSortWorker, &tasks[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    parallelSampleSortWorker(&tasks[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    freeScratch(sample);
+    freeScratch(splitters);
+    freeScratch(scratch);
+    freeScratch(bucketOf);
+    freeScratch(counts);
+    freeScratch(workers);
+    freeScratch(tasks);
+}
+void *parallelLsdRadixSortWorker(void *argument) {
+    ParallelRadixSortTask *task = (ParallelRadixSortTask *)argument;
+    long n = task->n;
+    int threads = task->threads;
+    const int passes = (KEY_BITS + LSD_RADIX_BITS - 1) / LSD_RADIX_BITS;
+    const int buckets = 1 << LSD_RADIX_BITS;
+    const unsigned long int mask = (unsigned long int)buckets - 1;
+    ThreadAffinity affinity;
+    int isPinned = pinThreads && pinThreadToProcessor(task->id, &affinity);
+
+    int sliceStart = (int)(n * task->id / threads);
+    int sliceEnd = (int)(n * (task->id + 1) / threads);
+    int *count = task->counts + task->id * buckets;
+    int *offsets = (int *)allocateScratch(buckets * sizeof(int));
+    if (offsets == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long int *source = task->array;
+    unsigned long int *destination = task->scratch;
+    for (int pass = 0; pass < passes; pass++) {
+        int shift = pass * LSD_RADIX_BITS;
+
+        // The slices change with every pass, so the digits are counted again each time
+        memset(count, 0, buckets * sizeof(int));
+        for (int i = sliceStart; i < sliceEnd; i++) {
+            count[(source[i] >> shift) & mask]++;
+        }
+        pthread_barrier_wait(task->barrier);
+
+        // This thread's keys of a digit go after the smaller digits and after the keys of the
+        // same digit from the threads before it, which keeps the scatter stable
+        int total = 0;
+        int isSingleDigit = 0;
+        for (int b = 0; b < buckets; b++) {
+            int digitStart = total;
+            for (int t = 0; t < threads; t++) {
+                if (t == task->id) offsets[b] = total;
+                total += task->counts[t * buckets + b];
+            }
+            if (total - digitStart == n) isSingleDigit = 1;
+        }
+
+        // Every key has the same digit, this pass would not move anything. All the threads
+        // see the same counts and skip it together.
+        if (!isSingleDigit) {
+            for (int i = sliceStart; i < sliceEnd; i++) {
+                unsigned long int key = source[i];
+                destination[offsets[(key >> shift) & mask]++] = key;
+            }
+            COUNT_MOVES(sliceEnd - sliceStart);
+        }
+        // The counts are reused and the destination read by the next pass
+        pthread_barrier_wait(task->barrier);
+        if (!isSingleDigit) {
+            unsigned long int *temp = source;
+            source = destination;
+            destination = temp;
+        }
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (source != task->array && sliceEnd > sliceStart) {
+        memcpy(task->array + sliceStart, source + sliceStart, (sliceEnd - sliceStart) * sizeof(unsigned long int));
+        COUNT_MOVES(sliceEnd - sliceStart);
+    }
+
+    freeScratch(offsets);
+    if (isPinned) {
+        restoreThreadAffinity(&affinity);
+    }
+    addWorkerOperationCounts();
+    return NULL;
+}
+void parallelLsdRadixSort(unsigned long int *array, int n) {
+    int threads = sortingThreads;
+    if (threads > n / PARALLEL_SORT_MIN_SLICE) {
+        threads = n / PARALLEL_SORT_MIN_SLICE;
+    }
+    if (threads <= 1) {
+        lsdRadixSort(array, n);
+        return;
+    }
+
+    unsigned long int *scratch = (unsigned long int *)allocateScratch(n * sizeof(unsigned long int));
+    int *counts = (int *)allocateScratch((size_t)threads * (1 << LSD_RADIX_BITS) * sizeof(int));
+    pthread_t *workers = (pthread_t *)allocateScratch(threads * sizeof(pthread_t));
+    ParallelRadixSortTask *tasks = (ParallelRadixSortTask *)allocateScratch(threads * sizeof(ParallelRadixSortTask));
+    if (scratch == NULL || counts == NULL || workers == NULL || tasks == NULL) {
+        perror("Memory allocation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, threads);
+    for (int i = 0; i < threads; i++) {
+        ParallelRadixSortTask task = {array, scratch, counts, n, threads, i, &barrier};
+        tasks[i] = task;
+    }
+
+    // The calling thread works as thread 0
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, parallelLsdRadixSortWorker, &tasks[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    parallelLsdRadixSortWorker(&tasks[0]);
+    for (int i = 1; i < threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    freeScratch(scratch);
+    freeScratch(counts);
+    freeScratch(workers);
+    freeScratch(tasks);
+}
+
+/*
+*
+* SELECTION
+*
+*/
+void introSelect(unsigned long int *array, int n, int k) {
+    if (k < 0 || k >= n) return;
+
+    // Allow 2 * floor(log2(n)) partitions before falling back to median of medians, like introSort
+    int depthLimit = 0;
+    for (int size = n; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+
+    int low = 0, high = n - 1;
+    while (high - low + 1 > SELECTION_INSERTION_CUTOFF) {
+        if (depthLimit == 0) {
+            medianOfMediansSelect(array, low, high, k);
+            return;
+        }
+        depthLimit--;
+
+        // Only the side holding k is left to partition, and k may land among the keys equal to the pivot
+        int lt, gt;
+        threeWayPartition(array, low, high, &lt, &gt);
+        if (k < lt) {
+            high = lt - 1;
+        } else if (k > gt) {
+            low = gt + 1;
+        } else {
+            return;
+        }
+    }
+    insertionSort(array + low, high - low + 1);
+}
+void medianOfMediansSelect(unsigned long int *array, int low, int high, int k) {
+    while (high - low + 1 > SELECTION_INSERTION_CUTOFF) {
+        unsigned long int pivot = medianOfMedians(array, low, high);
+        int lt, gt;
+        partitionAroundPivot(array, low, high, pivot, &lt, &gt);
+        if (k < lt) {
+            high = lt - 1;
+        } else if (k > gt) {
+            low = gt + 1;
+        } else {
+            return;
+        }
+    }
+    insertionSort(array + low, high - low + 1);
+}
+unsigned long int medianOfMedians(unsigned long int *array, int low, int high) {
+    int groups = 0;
+    for (int start = low; start <= high; start += MEDIAN_OF_MEDIANS_GROUP_SIZE) {
+        int size = high - start + 1 < MEDIAN_OF_MEDIANS_GROUP_SIZE ? high - start + 1 : MEDIAN_OF_MEDIANS_GROUP_SIZE;
+        insertionSort(array + start, size);
+
+        // The median of the group goes to the next place at the start of the range
+        int median = start + (size - 1) / 2;
+        unsigned long int temp = array[low + groups];
+        array[low + groups] = array[median];
+        array[median] = temp;
+        COUNT_SWAPS(1);
+        groups++;
+    }
+
+    int middle = low + (groups - 1) / 2;
+    medianOfMediansSelect(array, low, low + groups - 1, middle);
+    return array[middle];
+}
+void partitionAroundPivot(unsigned long int *array, int low, int high, unsigned long int pivot, int *lessEnd, int *greaterStart) {
+    // array[low..less-1] < pivot, array[less..equal-1] == pivot, array[greater+1..high] > pivot
+    int less = low, equal = low, greater = high;
+    while (equal <= greater) {
+        unsigned long int key = array[equal];
+        if (COMPARE(key < pivot)) {
+            array[equal++] = array[less];
+            array[less++] = key;
+            COUNT_SWAPS(1);
+        } else if (COMPARE(key > pivot)) {
+            array[equal] = array[greater];
+            array[greater--] = key;
+            COUNT_SWAPS(1);
+        } else {
+            equal++;
+        }
+    }
+    *lessEnd = less;
+    *greaterStart = greater;
+}
+void topK(const unsigned long int *array, int n, int k, unsigned long int *smallest) {
+    if (k <= 0) return;
+    if (k > n) k = n;
+
+    // A max heap of the first k keys, its root is the largest of the k smallest so far
+    memcpy(smallest, array, (size_t)k * sizeof(unsigned long int));
+    COUNT_MOVES(k);
+    for (int i = k / 2 - 1; i >= 0; i--) {
+        heapify(smallest, k, i);
+    }
+
+    // Most keys are larger than the root once the heap holds small keys, they cost one comparison
+    for (int i = k; i < n; i++) {
+        if (COMPARE(array[i] < smallest[0])) {
+            smallest[0] = array[i];
+            COUNT_MOVES(1);
+            heapify(smallest, k, 0);
+        }
+    }
+}
+void partialSort(unsigned long int *array, int n, int k) {
+    if (k <= 0) return;
+    if (k < n) {
+        introSelect(array, n, k - 1);
+    } else {
+        k = n;
+    }
+    introSort(array, k);
+}
+
+/*
+*
+* TYPED SORTING ALGORITHMS
+*
+*/
+// The comparisons and radix keys of the element types
+#define LESS_THAN(a, b) ((a) < (b))
+#define RECORD_LESS_THAN(a, b) ((a).key < (b).key)
+#define IDENTITY_SORT_KEY(element) (element)
+#define RECORD_SORT_KEY(element) ((element).key)
+// The conversions of the generated keys. Floating-point keys are centered on 0 so that half
+// of the random keys are negative.
+#define TO_U32(key, index) ((uint32_t)(key))
+#define TO_U64(key, index) ((uint64_t)(key))
+#define TO_F32(key, index) ((float)((double)(key) - 2147483648.0))
+#define TO_F64(key, index) ((double)(key) - 2147483648.0)
+#define TO_KEY_VALUE(key, index) ((KeyValueRecord){(uint64_t)(key), (uint64_t)(index)})
+#define TO_RECORD32(key, index) ((Record32){(uint64_t)(key), (uint64_t)(index), {0}})
+#define TO_RECORD64(key, index) ((Record64){(uint64_t)(key), (uint64_t)(index), {0}})
+#define TO_RECORD128(key, index) ((Record128){(uint64_t)(key), (uint64_t)(index), {0}})
+#define TO_RECORD256(key, index) ((Record256){(uint64_t)(key), (uint64_t)(index), {0}})
+
+/**
+ * Generates the typed sorting algorithms of DECLARE_TYPED_SORTING_ALGORITHMS
+ * @param Suffix Appended to the function names, e.g. introSortU32
+ * @param Type The element type
+ * @param LESS Macro comparing two elements, LESS(a, b) is true when a sorts before b
+ * @param KeyType Unsigned integer type of the radix key
+ * @param SORT_KEY Macro mapping an element to its radix key, in the same order as LESS
+ * @param CONVERT Macro converting a generated key and its position into an element
+*/
+#define DEFINE_TYPED_SORTING_ALGORITHMS(Suffix, Type, LESS, KeyType, SORT_KEY, CONVERT) \
+static inline void swap##Suffix(Type *a, Type *b) { \
+    Type temp = *a; \
+    *a = *b; \
+    *b = temp; \
+    COUNT_SWAPS(1); \
+} \
+static void insertionSort##Suffix(Type *array, int n) { \
+    for (int i = 1; i < n; i++) { \
+        Type key = array[i]; \
+        int j = i - 1; \
+        while (j >= 0 && COMPARE(LESS(key, array[j]))) { \
+            array[j + 1] = array[j]; \
+            COUNT_MOVES(1); \
+            j--; \
+        } \
+        array[j + 1] = key; \
+        COUNT_MOVES(1); \
+    } \
+} \
+static void merge##Suffix(const Type *source, Type *destination, int left, int mid, int right) { \
+    int i = left, j = mid + 1, k = left; \
+    /* Ties take the left element first, which keeps the sort stable */ \
+    while (i <= mid && j <= right) { \
+        if (COMPARE(LESS(source[j], source[i]))) { \
+            destination[k++] = source[j++]; \
+        } else { \
+            destination[k++] = source[i++]; \
+        } \
+    } \
+    while (i <= mid) destination[k++] = source[i++]; \
+    while (j <= right) destination[k++] = source[j++]; \
+    COUNT_MOVES(right - left + 1); \
+} \
+void mergeSort##Suffix(void *elements, int n) { \
+    Type *array = (Type *)elements; \
+    if (n < 2) return; \
+    Type *scratch = (Type *)allocateScratch((size_t)n * sizeof(Type)); \
+    if (scratch == NULL) { \
+        perror("Memory allocation failed"); \
+        exit(EXIT_FAILURE); \
+    } \
+    /* Sort blocks with insertion sort, then merge runs of doubling width between the two buffers */ \
+    for (int left = 0; left < n; left += SIMD_BLOCK_SIZE) { \
+        insertionSort##Suffix(array + left, n - left < SIMD_BLOCK_SIZE ? n - left : SIMD_BLOCK_SIZE); \
+    } \
+    Type *source = array; \
+    Type *destination = scratch; \
+    for (int width = SIMD_BLOCK_SIZE; width < n; width *= 2) { \
+        for (int left = 0; left < n; left += 2 * width) { \
+            int mid = left + width - 1; \
+            int right = left + 2 * width - 1; \
+            if (mid >= n - 1) { \
+                memcpy(destination + left, source + left, (size_t)(n - left) * sizeof(Type)); \
+                COUNT_MOVES(n - left); \
+                break; \
+            } \
+            if (right > n - 1) right = n - 1; \
+            merge##Suffix(source, destination, left, mid, right); \
+        } \
+        Type *temp = source; \
+        source = destination; \
+        destination = temp; \
+        if (width > n / 2) break; \
+    } \
+    if (source != array) { \
+        memcpy(array, source, (size_t)n * sizeof(Type)); \
+        COUNT_MOVES(n); \
+    } \
+    freeScratch(scratch); \
+} \
+void heapSort##Suffix(void *elements, int n) { \
+    Type *array = (Type *)elements; \
+    for (int end = n, i = n / 2 - 1; end > 1; ) { \
+        /* Build the max heap first, then move its root behind the shrinking heap */ \
+        int root; \
+        if (i >= 0) { \
+            root = i--; \
+        } else { \
+            end--; \
+            swap##Suffix(&array[0], &array[end]); \
+            root = 0; \
+        } \
+        Type value = array[root]; \
+        for (int child = 2 * root + 1; child < end; child = 2 * root + 1) { \
+            if (child + 1 < end && COMPARE(LESS(array[child], array[child + 1]))) child++; \
+            if (!COMPARE(LESS(value, array[child]))) break; \
+            array[root] = array[child]; \
+            COUNT_MOVES(1); \
+            root = child; \
+        } \
+        array[root] = value; \
+    } \
+} \
+static void introSortHelper##Suffix(Type *array, int low, int high, int depthLimit) { \
+    while (high - low + 1 > INTRO_SORT_INSERTION_CUTOFF) { \
+        if (depthLimit == 0) { \
+            heapSort##Suffix(array + low, high - low + 1); \
+            return; \
+        } \
+        depthLimit--; \
+        /* Median of three, which also stops both scans below at the ends */ \
+        int mid = low + (high - low) / 2; \
+        if (COMPARE(LESS(array[mid], array[low]))) swap##Suffix(&array[mid], &array[low]); \
+        if (COMPARE(LESS(array[high], array[low]))) swap##Suffix(&array[high], &array[low]); \
+        if (COMPARE(LESS(array[high], array[mid]))) swap##Suffix(&array[high], &array[mid]); \
+        Type pivot = array[mid]; \
+        /* Hoare partition: keys equal to the pivot are split between both sides */ \
+        int i = low, j = high; \
+        while (i <= j) { \
+            while (COMPARE(LESS(array[i], pivot))) i++; \
+            while (COMPARE(LESS(pivot, array[j]))) j--; \
+            if (i <= j) { \
+                swap##Suffix(&array[i], &array[j]); \
+                i++; \
+                j--; \
+            } \
+        } \
+        /* Recurse into the smaller side and loop on the larger one */ \
+        if (j - low < high - i) { \
+            introSortHelper##Suffix(array, low, j, depthLimit); \
+            low = i; \
+        } else { \
+            introSortHelper##Suffix(array, i, high, depthLimit); \
+            high = j; \
+        } \
+    } \
+    if (high > low) { \
+        insertionSort##Suffix(array + low, high - low + 1); \
+    } \
+} \
+void introSort##Suffix(void *elements, int n) { \
+    int depthLimit = 0; \
+    for (int size = n; size > 1; size /= 2) { \
+        depthLimit += 2; \
+    } \
+    introSortHelper##Suffix((Type *)elements, 0, n - 1, depthLimit); \
+} \
+void lsdRadixSort##Suffix(void *elements, int n) { \
+    Type *array = (Type *)elements; \
+    if (n < 2) return; \
+    const int passes = ((int)sizeof(KeyType) * CHAR_BIT + LSD_RADIX_BITS - 1) / LSD_RADIX_BITS; \
+    const int buckets = 1 << LSD_RADIX_BITS; \
+    const KeyType mask = (KeyType)buckets - 1; \
+    int *counts = (int *)allocateZeroedScratch((size_t)passes * buckets, sizeof(int)); \
+    Type *scratch = (Type *)allocateScratch((size_t)n * sizeof(Type)); \
+    if (counts == NULL || scratch == NULL) { \
+        perror("Memory allocation failed"); \
+        exit(EXIT_FAILURE); \
+    } \
+    for (int i = 0; i < n; i++) { \
+        KeyType key = SORT_KEY(array[i]); \
+        for (int pass = 0; pass < passes; pass++) { \
+            counts[pass * buckets + (int)((key >> (pass * LSD_RADIX_BITS)) & mask)]++; \
+        } \
+    } \
+    Type *source = array; \
+    Type *destination = scratch; \
+    for (int pass = 0; pass < passes; pass++) { \
+        int *count = counts + pass * buckets; \
+        int shift = pass * LSD_RADIX_BITS; \
+        if (count[(int)((SORT_KEY(source[0]) >> shift) & mask)] == n) continue; \
+        int offset = 0; \
+        for (int b = 0; b < buckets; b++) { \
+            int bucketSize = count[b]; \
+            count[b] = offset; \
+            offset += bucketSize; \
+        } \
+        for (int i = 0; i < n; i++) { \
+            destination[count[(int)((SORT_KEY(source[i]) >> shift) & mask)]++] = source[i]; \
+        } \
+        COUNT_MOVES(n); \
+        Type *temp = source; \
+        source = destination; \
+        destination = temp; \
+    } \
+    if (source != array) { \
+        memcpy(array, source, (size_t)n * sizeof(Type)); \
+        COUNT_MOVES(n); \
+    } \
+    freeScratch(counts); \
+    freeScratch(scratch); \
+} \
+void fill##Suffix(void *elements, const unsigned long int *keys, int n) { \
+    Type *array = (Type *)elements; \
+    for (int i = 0; i < n; i++) { \
+        array[i] = CONVERT(keys[i], i); \
+    } \
+} \
+int isSorted##Suffix(const void *elements, int n) { \
+    const Type *array = (const Type *)elements; \
+    for (int i = 1; i < n; i++) { \
+        if (LESS(array[i], array[i - 1])) return 0; \
+    } \
+    return 1; \
+} \
+uint64_t sortKey##Suffix(const void *elements, int i) { \
+    return (uint64_t)SORT_KEY(((const Type *)elements)[i]); \
+}
+
+static inline uint32_t floatSortKey(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((uint32_t)-(int32_t)(bits >> 31) | 0x80000000u);
+}
+static inline uint64_t doubleSortKey(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits ^ ((uint64_t)-(int64_t)(bits >> 63) | 0x8000000000000000ull);
+}
+
+DEFINE_TYPED_SORTING_ALGORITHMS(U32, uint32_t, LESS_THAN, uint32_t, IDENTITY_SORT_KEY, TO_U32)
+DEFINE_TYPED_SORTING_ALGORITHMS(U64, uint64_t, LESS_THAN, uint64_t, IDENTITY_SORT_KEY, TO_U64)
+DEFINE_TYPED_SORTING_ALGORITHMS(F32, float, LESS_THAN, uint32_t, floatSortKey, TO_F32)
+DEFINE_TYPED_SORTING_ALGORITHMS(F64, double, LESS_THAN, uint64_t, doubleSortKey, TO_F64)
+DEFINE_TYPED_SORTING_ALGORITHMS(KeyValue, KeyValueRecord, RECORD_LESS_THAN, uint64_t, RECORD_SORT_KEY, TO_KEY_VALUE)
+DEFINE_TYPED_SORTING_ALGORITHMS(Record32, Record32, RECORD_LESS_THAN, uint64_t, RECORD_SORT_KEY, TO_RECORD32)
+DEFINE_TYPED_SORTING_ALGORITHMS(Record64, Record64, RECORD_LESS_THAN, uint64_t, RECORD_SORT_KEY, TO_RECORD64)
+DEFINE_TYPED_SORTING_ALGORITHMS(Record128, Record128, RECORD_LESS_THAN, uint64_t, RECORD_SORT_KEY, TO_RECORD128)
+DEFINE_TYPED_SORTING_ALGORITHMS(Record256, Record256, RECORD_LESS_THAN, uint64_t, RECORD_SORT_KEY, TO_RECORD256)
+
+/*
+*
+* SIMD KERNELS
+*
+*/
+int scalarPartition(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight) {
+    int i = low;
+    for (int j = low; j <= high; j++) {
+        int goesLeft = COMPARE(equalGoesRight ? array[j] < pivot : array[j] <= pivot);
+        if (goesLeft) {
+            unsigned long int temp = array[i];
+            array[i] = array[j];
+            array[j] = temp;
+            COUNT_SWAPS(1);
+            i++;
+        }
+    }
+    return i;
+}
+
+#ifdef SIMD_KERNELS_AVAILABLE
+/**
+ * For each 4-bit mask of lanes going right, the 32-bit lane order that packs the
+ * lanes going left at the front and the lanes going right at the back.
+*/
+int avx2PartitionPermutations[16][8];
+
+void buildAvx2PartitionPermutations(void) {
+    for (int mask = 0; mask < 16; mask++) {
+        int position = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int lane = 0; lane < 4; lane++) {
+                int goesRight = (mask >> lane) & 1;
+                if (goesRight == pass) {
+                    avx2PartitionPermutations[mask][position++] = 2 * lane;
+                    avx2PartitionPermutations[mask][position++] = 2 * lane + 1;
+                }
+            }
+        }
+    }
+}
+
+// AVX2 only compares signed 64-bit lanes, flipping the sign bit makes it an unsigned compare
+static inline __attribute__((target("avx2"))) __m256i avx2Greater(__m256i a, __m256i b) {
+    const __m256i signBit = _mm256_set1_epi64x(LLONG_MIN);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(a, signBit), _mm256_xor_si256(b, signBit));
+}
+static inline __attribute__((target("avx2"))) void avx2MinMax(__m256i *a, __m256i *b) {
+    // One comparison per lane
+    COUNT_COMPARISONS(4);
+    __m256i greater = avx2Greater(*a, *b);
+    __m256i minimum = _mm256_blendv_epi8(*a, *b, greater);
+    __m256i maximum = _mm256_blendv_epi8(*b, *a, greater);
+    *a = minimum;
+    *b = maximum;
+}
+static inline __attribute__((target("avx2"))) __m256i avx2Reverse(__m256i v) {
+    return _mm256_permute4x64_epi64(v, 0x1B);
+}
+// Sorts a bitonic vector of 4 keys: compare-exchange at distance 2, then at distance 1
+static inline __attribute__((target("avx2"))) __m256i avx2BitonicClean(__m256i v) {
+    __m256i low = v;
+    __m256i high = _mm256_permute4x64_epi64(v, 0x4E);
+    avx2MinMax(&low, &high);
+    v = _mm256_blend_epi32(low, high, 0xF0);
+
+    low = v;
+    high = _mm256_permute4x64_epi64(v, 0xB1);
+    avx2MinMax(&low, &high);
+    return _mm256_blend_epi32(low, high, 0xCC);
+}
+// Merges two sorted vectors, the smallest 4 keys end up in a and the largest 4 in b
+static inline __attribute__((target("avx2"))) void avx2BitonicMerge(__m256i *a, __m256i *b) {
+    *b = avx2Reverse(*b);
+    avx2MinMax(a, b);
+    *a = avx2BitonicClean(*a);
+    *b = avx2BitonicClean(*b);
+}
+
+__attribute__((target("avx2"))) void avx2SortBlock(unsigned long int *array, int n) {
+    if (n < 2) return;
+
+    // Pad to 16 keys with the largest key so the padding stays at the end
+    unsigned long int block[SIMD_BLOCK_SIZE];
+    memcpy(block, array, n * sizeof(unsigned long int));
+    for (int i = n; i < SIMD_BLOCK_SIZE; i++) {
+        block[i] = ULONG_MAX;
+    }
+    __m256i r0 = _mm256_loadu_si256((const __m256i *)(block + 0));
+    __m256i r1 = _mm256_loadu_si256((const __m256i *)(block + 4));
+    __m256i r2 = _mm256_loadu_si256((const __m256i *)(block + 8));
+    __m256i r3 = _mm256_loadu_si256((const __m256i *)(block + 12));
+
+    // Sort the 4 columns with a 4-input sorting network
+    avx2MinMax(&r0, &r1);
+    avx2MinMax(&r2, &r3);
+    avx2MinMax(&r0, &r2);
+    avx2MinMax(&r1, &r3);
+    avx2MinMax(&r1, &r2);
+
+    // Transpose so that every vector holds a sorted run of 4
+    __m256i t0 = _mm256_unpacklo_epi64(r0, r1);
+    __m256i t1 = _mm256_unpackhi_epi64(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi64(r2, r3);
+    __m256i t3 = _mm256_unpackhi_epi64(r2, r3);
+    r0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+
+    // Merge the runs of 4 into runs of 8
+    avx2BitonicMerge(&r0, &r1);
+    avx2BitonicMerge(&r2, &r3);
+
+    // Merge the two runs of 8: compare against the reversed second run, then clean both halves
+    __m256i h0 = avx2Reverse(r3);
+    __m256i h1 = avx2Reverse(r2);
+    avx2MinMax(&r0, &h0);
+    avx2MinMax(&r1, &h1);
+    avx2MinMax(&r0, &r1);
+    avx2MinMax(&h0, &h1);
+    _mm256_storeu_si256((__m256i *)(block + 0), avx2BitonicClean(r0));
+    _mm256_storeu_si256((__m256i *)(block + 4), avx2BitonicClean(r1));
+    _mm256_storeu_si256((__m256i *)(block + 8), avx2BitonicClean(h0));
+    _mm256_storeu_si256((__m256i *)(block + 12), avx2BitonicClean(h1));
+
+    memcpy(array, block, n * sizeof(unsigned long int));
+    COUNT_MOVES(n);
+}
+
+__attribute__((target("avx2"))) void avx2MergeRuns(const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize, unsigned long int *destination) {
+    if (leftSize < 4 || rightSize < 4) {
+        scalarMergeRuns(left, leftSize, right, rightSize, destination);
+        return;
+    }
+
+    // Keep the 4 largest keys seen so far in a register, and merge in 4 keys at a time
+    // from the run whose next key is smaller. The 4 smallest are always safe to output.
+    __m256i current = _mm256_loadu_si256((const __m256i *)left);
+    __m256i next = _mm256_loadu_si256((const __m256i *)right);
+    int i = 4, j = 4, k = 0;
+    avx2BitonicMerge(&current, &next);
+    _mm256_storeu_si256((__m256i *)destination, current);
+    k += 4;
+    current = next;
+
+    while (i + 4 <= leftSize && j + 4 <= rightSize) {
+        if (COMPARE(left[i] <= right[j])) {
+            next = _mm256_loadu_si256((const __m256i *)(left + i));
+            i += 4;
+        } else {
+            next = _mm256_loadu_si256((const __m256i *)(right + j));
+            j += 4;
+        }
+        avx2BitonicMerge(&next, &current);
+        _mm256_storeu_si256((__m256i *)(destination + k), next);
+        k += 4;
+    }
+    COUNT_MOVES(k);
+
+    // Finish with the 4 keys in the register, the short run and then the long run
+    unsigned long int pending[4];
+    unsigned long int shortMerged[8];
+    _mm256_storeu_si256((__m256i *)pending, current);
+    if (leftSize - i < 4) {
+        scalarMergeRuns(pending, 4, left + i, leftSize - i, shortMerged);
+        scalarMergeRuns(shortMerged, 4 + leftSize - i, right + j, rightSize - j, destination + k);
+    } else {
+        scalarMergeRuns(pending, 4, right + j, rightSize - j, shortMerged);
+        scalarMergeRuns(shortMerged, 4 + rightSize - j, left + i, leftSize - i, destination + k);
+    }
+}
+
+__attribute__((target("avx2"))) int avx2Partition(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight) {
+    int size = high - low + 1;
+    if (size < 4 * 4) {
+        return scalarPartition(array, low, high, pivot, equalGoesRight);
+    }
+
+    unsigned long int *base = array + low;
+    const __m256i signBit = _mm256_set1_epi64x(LLONG_MIN);
+    const __m256i pivotVector = _mm256_xor_si256(_mm256_set1_epi64x((long long)pivot), signBit);
+
+    // Set aside the first and last vectors so there is always room for a full
+    // vector store on both sides. Free space on the two sides adds up to 8 keys.
+    __m256i first = _mm256_loadu_si256((const __m256i *)base);
+    __m256i last = _mm256_loadu_si256((const __m256i *)(base + size - 4));
+    int readLeft = 4, readRight = size - 4;
+    int writeLeft = 0, writeRight = size;
+
+    while (readRight - readLeft >= 4) {
+        // Read from the side with less free space, so both sides can take a full vector
+        __m256i v;
+        if (readLeft - writeLeft <= writeRight - readRight) {
+            v = _mm256_loadu_si256((const __m256i *)(base + readLeft));
+            readLeft += 4;
+        } else {
+            readRight -= 4;
+            v = _mm256_loadu_si256((const __m256i *)(base + readRight));
+        }
+
+        __m256i flipped = _mm256_xor_si256(v, signBit);
+        __m256i goesRight = equalGoesRight
+            ? _mm256_xor_si256(_mm256_cmpgt_epi64(pivotVector, flipped), _mm256_set1_epi64x(-1))
+            : _mm256_cmpgt_epi64(flipped, pivotVector);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(goesRight));
+        int rightCount = __builtin_popcount(mask);
+        COUNT_COMPARISONS(4);
+        COUNT_MOVES(4);
+
+        // One permutation packs the left keys at the front and the right keys at the back,
+        // the same vector is stored on both sides and only the packed part is kept
+        __m256i packed = _mm256_permutevar8x32_epi32(v, _mm256_loadu_si256((const __m256i *)avx2PartitionPermutations[mask]));
+        _mm256_storeu_si256((__m256i *)(base + writeLeft), packed);
+        writeLeft += 4 - rightCount;
+        _mm256_storeu_si256((__m256i *)(base + writeRight - 4), packed);
+        writeRight -= rightCount;
+    }
+
+    // The set-aside vectors and the last few keys fill the gap left between both sides
+    unsigned long int remaining[3 * 4];
+    int remainingSize = 0;
+    _mm256_storeu_si256((__m256i *)remaining, first);
+    _mm256_storeu_si256((__m256i *)(remaining + 4), last);
+    remainingSize = 8;
+    for (int i = readLeft; i < readRight; i++) {
+        remaining[remainingSize++] = base[i];
+    }
+    for (int i = 0; i < remainingSize; i++) {
+        int goesLeft = COMPARE(equalGoesRight ? remaining[i] < pivot : remaining[i] <= pivot);
+        if (goesLeft) {
+            base[writeLeft++] = remaining[i];
+        } else {
+            base[--writeRight] = remaining[i];
+        }
+    }
+    COUNT_MOVES(remainingSize);
+    return low + writeLeft;
+}
+
+__attribute__((target("avx512f"))) int avx512Partition(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight) {
+    int size = high - low + 1;
+    if (size < 4 * 8) {
+        return scalarPartition(array, low, high, pivot, equalGoesRight);
+    }
+
+    // Same scheme as avx2Partition, with compress stores writing only the selected lanes
+    unsigned long int *base = array + low;
+    const __m512i pivotVector = _mm512_set1_epi64((long long)pivot);
+    __m512i first = _mm512_loadu_si512(base);
+    __m512i last = _mm512_loadu_si512(base + size - 8);
+    int readLeft = 8, readRight = size - 8;
+    int writeLeft = 0, writeRight = size;
+
+    while (readRight - readLeft >= 8) {
+        __m512i v;
+        if (readLeft - writeLeft <= writeRight - readRight) {
+            v = _mm512_loadu_si512(base + readLeft);
+            readLeft += 8;
+        } else {
+            readRight -= 8;
+            v = _mm512_loadu_si512(base + readRight);
+        }
+
+        __mmask8 goesRight = equalGoesRight
+            ? _mm512_cmpge_epu64_mask(v, pivotVector)
+            : _mm512_cmpgt_epu64_mask(v, pivotVector);
+        int rightCount = __builtin_popcount(goesRight);
+        COUNT_COMPARISONS(8);
+        COUNT_MOVES(8);
+        _mm512_mask_compressstoreu_epi64(base + writeLeft, (__mmask8)~goesRight, v);
+        writeLeft += 8 - rightCount;
+        _mm512_mask_compressstoreu_epi64(base + writeRight - rightCount, goesRight, v);
+        writeRight -= rightCount;
+    }
+
+    unsigned long int remaining[3 * 8];
+    int remainingSize = 16;
+    _mm512_storeu_si512(remaining, first);
+    _mm512_storeu_si512(remaining + 8, last);
+    for (int i = readLeft; i < readRight; i++) {
+        remaining[remainingSize++] = base[i];
+    }
+    for (int i = 0; i < remainingSize; i++) {
+        int goesLeft = COMPARE(equalGoesRight ? remaining[i] < pivot : remaining[i] <= pivot);
+        if (goesLeft) {
+            base[writeLeft++] = remaining[i];
+        } else {
+            base[--writeRight] = remaining[i];
+        }
+    }
+    COUNT_MOVES(remainingSize);
+    return low + writeLeft;
+}
+#endif
+
+int selectSimdKernels(const char *level) {
+    int isAuto = strcmp(level, "auto") == 0;
+    int wantsAvx512 = isAuto || strcmp(level, "avx512") == 0;
+    int wantsAvx2 = wantsAvx512 || strcmp(level, "avx2") == 0;
+    if (!wantsAvx2 && strcmp(level, "scalar") != 0) {
+        return 0;
+    }
+
+    int hasAvx2 = 0, hasAvx512 = 0;
+    #ifdef SIMD_KERNELS_AVAILABLE
+        __builtin_cpu_init();
+        hasAvx2 = __builtin_cpu_supports("avx2");
+        hasAvx512 = hasAvx2 && __builtin_cpu_supports("avx512f");
+    #endif
+    if (!isAuto && ((wantsAvx512 && !hasAvx512) || (wantsAvx2 && !hasAvx2))) {
+        return 0;
+    }
+
+    sortBlockKernel = insertionSort;
+    partitionKernel = scalarPartition;
+    mergeRunsKernel = scalarMergeRuns;
+    simdKernelLevel = "scalar";
+    #ifdef SIMD_KERNELS_AVAILABLE
+        // AVX-512 only replaces the partition, where compress stores help the most
+        if (wantsAvx2 && hasAvx2) {
+            buildAvx2PartitionPermutations();
+            sortBlockKernel = avx2SortBlock;
+            partitionKernel = avx2Partition;
+            mergeRunsKernel = avx2MergeRuns;
+            simdKernelLevel = "avx2";
+        }
+        if (wantsAvx512 && hasAvx512) {
+            partitionKernel = avx512Partition;
+            simdKernelLevel = "avx512";
+        }
+    #endif
+    return 1;
+}
+void simdQuickSortHelper(unsigned long int *array, int low, int high, int depthLimit) {
+    while (high - low + 1 > SIMD_BLOCK_SIZE) {
+        // Too many bad partitions, heap sort guarantees O(n log n) for the rest
+        if (depthLimit == 0) {
+            heapSort(array + low, high - low + 1);
+            return;
+        }
+        depthLimit--;
+
+        // Choose the median-of-three as pivot, it is left at array[high]
+        unsigned long int pivot = medianOfThree(array, low, high);
+
+        // Every key in the range is >= array[low - 1]. If that key equals the pivot, the
+        // keys equal to the pivot are already in their final place once moved to the left.
+        if (low > 0 && COMPARE(array[low - 1] == pivot)) {
+            low = partitionKernel(array, low, high, pivot, 0);
+            continue;
+        }
+
+        int pivotIndex = partitionKernel(array, low, high - 1, pivot, 1);
+        unsigned long int temp = array[pivotIndex];
+        array[pivotIndex] = array[high];
+        array[high] = temp;
+        COUNT_SWAPS(1);
+
+        // Recurse into the smaller side and loop on the larger one to keep the stack O(log n)
+        if (pivotIndex - low < high - pivotIndex) {
+            simdQuickSortHelper(array, low, pivotIndex - 1, depthLimit);
+            low = pivotIndex + 1;
+        } else {
+            simdQuickSortHelper(array, pivotIndex + 1, high, depthLimit);
+            high = pivotIndex - 1;
+        }
+    }
+
+    if (high > low) {
+        sortBlockKernel(array + low, high - low + 1);
+    }
+}
+void simdQuickSort(unsigned long int *array, int n) {
+    int depthLimit = 0;
+    for (int size = n; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    simdQuickSortHelper(array, 0, n - 1, depthLimit);
+}
+
+/*
+*
+* OPERATION COUNTING
+*
+*/
+void resetOperationCounts(void) {
+    #ifdef COUNT_OPERATIONS
+        memset(&threadOperationCounts, 0, sizeof(OperationCounts));
+        pthread_mutex_lock(&workerOperationCountsLock);
+        memset(&workerOperationCounts, 0, sizeof(OperationCounts));
+        pthread_mutex_unlock(&workerOperationCountsLock);
+    #endif
+}
+void addWorkerOperationCounts(void) {
+    #ifdef COUNT_OPERATIONS
+        pthread_mutex_lock(&workerOperationCountsLock);
+        workerOperationCounts.comparisons += threadOperationCounts.comparisons;
+        workerOperationCounts.swaps += threadOperationCounts.swaps;
+        workerOperationCounts.moves += threadOperationCounts.moves;
+        pthread_mutex_unlock(&workerOperationCountsLock);
+        memset(&threadOperationCounts, 0, sizeof(OperationCounts));
+    #endif
+}
+OperationCounts collectOperationCounts(void) {
+    OperationCounts operations = {0, 0, 0};
+    #ifdef COUNT_OPERATIONS
+        addWorkerOperationCounts();
+        pthread_mutex_lock(&workerOperationCountsLock);
+        operations = workerOperationCounts;
+        memset(&workerOperationCounts, 0, sizeof(OperationCounts));
+        pthread_mutex_unlock(&workerOperationCountsLock);
+    #endif
+    return operations;
+}
+
+/*
+*
+* SCRATCH MEMORY
+*
+*/
+void *allocateScratch(size_t size) {
+    double startTime = getTimeInSeconds();
+    size_t blockSize = SCRATCH_HEADER_SIZE + (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    if (blockSize < size) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&scratchLock);
+    ScratchHeader *header;
+    if (useScratchArena && scratchArena.capacity - scratchArena.used >= blockSize) {
+        header = (ScratchHeader *)(scratchArena.memory + scratchArena.used);
+        header->isFromArena = 1;
+        header->previousTop = scratchArena.top;
+        scratchArena.top = scratchArena.used;
+        scratchArena.used += blockSize;
+    } else {
+        header = (ScratchHeader *)allocateCacheAligned(blockSize);
+        if (header == NULL) {
+            pthread_mutex_unlock(&scratchLock);
+            return NULL;
+        }
+        header->isFromArena = 0;
+        scratchCounts.systemAllocations++;
+        scratchSystemBytesInUse += blockSize;
+    }
+    header->size = blockSize;
+    header->isFreed = 0;
+
+    scratchCounts.allocations++;
+    scratchBytesInUse += blockSize;
+    if (scratchBytesInUse > scratchCounts.peakBytes) {
+        scratchCounts.peakBytes = scratchBytesInUse;
+    }
+    if (scratchArena.used + scratchSystemBytesInUse > scratchArena.wanted) {
+        scratchArena.wanted = scratchArena.used + scratchSystemBytesInUse;
+    }
+    scratchCounts.allocatorTime += getTimeInSeconds() - startTime;
+    pthread_mutex_unlock(&scratchLock);
+    return (unsigned char *)header + SCRATCH_HEADER_SIZE;
+}
+void *allocateZeroedScratch(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *memory = allocateScratch(count * size);
+    if (memory != NULL) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+void *reallocateScratch(void *memory, size_t size) {
+    void *grown = allocateScratch(size);
+    if (grown == NULL || memory == NULL) {
+        return grown;
+    }
+    const ScratchHeader *header = (const ScratchHeader *)((unsigned char *)memory - SCRATCH_HEADER_SIZE);
+    size_t oldSize = header->size - SCRATCH_HEADER_SIZE;
+    memcpy(grown, memory, oldSize < size ? oldSize : size);
+    freeScratch(memory);
+    return grown;
+}
+void freeScratch(void *memory) {
+    if (memory == NULL) {
+        return;
+    }
+    double startTime = getTimeInSeconds();
+    ScratchHeader *header = (ScratchHeader *)((unsigned char *)memory - SCRATCH_HEADER_SIZE);
+
+    pthread_mutex_lock(&scratchLock);
+    scratchBytesInUse -= header->size;
+    if (header->isFromArena) {
+        // Give back the space of the last block and of the freed blocks right below it
+        header->isFreed = 1;
+        while (scratchArena.used > 0) {
+            ScratchHeader *top = (ScratchHeader *)(scratchArena.memory + scratchArena.top);
+            if (!top->isFreed) break;
+            scratchArena.used = scratchArena.top;
+            scratchArena.top = top->previousTop;
+        }
+    } else {
+        scratchSystemBytesInUse -= header->size;
+        freeCacheAligned(header);
+    }
+    scratchCounts.allocatorTime += getTimeInSeconds() - startTime;
+    pthread_mutex_unlock(&scratchLock);
+}
+MemoryCounts collectMemoryCounts(void) {
+    pthread_mutex_lock(&scratchLock);
+    MemoryCounts memory = scratchCounts;
+    pthread_mutex_unlock(&scratchLock);
+    return memory;
+}
+
+/*
+*
+* UTILITIES
+*
+*/
+void *allocateCacheAligned(size_t size) {
+    // aligned_alloc() needs a multiple of the alignment
+    size = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    #ifdef _WIN32
+        return _aligned_malloc(size, CACHE_LINE_SIZE);
+    #else
+        return aligned_alloc(CACHE_LINE_SIZE, size);
+    #endif
+}
+void freeCacheAligned(void *memory) {
+    #ifdef _WIN32
+        _aligned_free(memory);
+    #else
+        free(memory);
+    #endif
+}
+
+double getTimeInSeconds(void) {
+    #ifdef _WIN32
+        LARGE_INTEGER frequency, start;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+        return (double)start.QuadPart / (double)frequency.QuadPart;
+    #else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+    #endif
+}
+int getProcessorCount(void) {
+    #ifdef _WIN32
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+    #else
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (int)count : 1;
+    #endif
+}
+int pinThreadToProcessor(int processor, ThreadAffinity *previous) {
+    processor %= getProcessorCount();
+    #ifdef _WIN32
+        // The mask only covers the first processor group
+        if (processor >= (int)(8 * sizeof(DWORD_PTR))) return 0;
+        *previous = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor);
+        return *previous != 0;
+    #elif defined(__linux__)
+        if (pthread_getaffinity_np(pthread_self(), sizeof(ThreadAffinity), previous) != 0) return 0;
+        cpu_set_t processors;
+        CPU_ZERO(&processors);
+        CPU_SET(processor, &processors);
+        return pthread_setaffinity_np(pthread_self(), sizeof(processors), &processors) == 0;
+    #else
+        (void)processor;
+        (void)previous;
+        return 0;
+    #endif
+}
+void restoreThreadAffinity(const ThreadAffinity *previous) {
+    #ifdef _WIN32
+        SetThreadAffinityMask(GetCurrentThread(), *previous);
+    #elif defined(__linux__)
+        pthread_setaffinity_np(pthread_self(), sizeof(ThreadAffinity), previous);
+    #else
+        (void)previous;
+    #endif
+}
+
+/*
+*
+* RANDOM NUMBERS
+*
+*/
+void seedRandomGenerator(RandomGenerator *generator, uint64_t seed, uint64_t stream) {
+    uint64_t x = (seed << 32) ^ ((stream + 1) * 0x9E3779B97F4A7C15ULL);
+    for (int i = 0; i < 4; i++) {
+        x += 0x9E3779B97F4A7C15ULL;
+        generator->state[i] = scrambleKey(x);
+    }
+}
+uint64_t nextRandom(RandomGenerator *generator) {
+    uint64_t *state = generator->state;
+    uint64_t x = state[1] * 5;
+    uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = (state[3] << 45) | (state[3] >> 19);
+    return result;
+}
+double nextRandomDouble(RandomGenerator *generator) {
+    // The top 53 bits fill the mantissa of the double
+    return (double)(nextRandom(generator) >> 11) * (1.0 / 9007199254740992.0);
+}
+uint64_t scrambleKey(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
@@ -0,0 +1,444 @@
+#ifndef SORTING_H
+#define SORTING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+
+// Thresholds used until a calibration file is loaded
+#define SORT_DEFAULT_INSERTION_CUTOFF 8
+#define SORT_DEFAULT_RADIX_CUTOFF 65536
+#define SORT_DEFAULT_RADIX_LIMIT INT_MAX
+#define SORT_DEFAULT_PARALLEL_CUTOFF 4194304
+// Arrays shorter than this are sorted without sampling them first
+#define SORT_SAMPLE_MIN_SIZE 256
+// Most windows sampled to estimate how presorted the input is and how many keys repeat
+#define SORT_SAMPLE_SIZE 256
+// Consecutive keys looked at from each sampled position to tell runs from random data
+#define SORT_RUN_WINDOW 8
+// Size of a cache line. The children of a node of the d-ary heaps are kept in one line.
+#define CACHE_LINE_SIZE 64
+// Number of bits in a key. unsigned long int is 64 bits on Linux but 32 bits on Windows.
+#define KEY_BITS ((int)(sizeof(unsigned long int) * CHAR_BIT))
+#if defined(__GNUC__)
+    #define PREFETCH(address) __builtin_prefetch(address)
+#else
+    #define PREFETCH(address) ((void)(address))
+#endif
+
+// Building with -DCOUNT_OPERATIONS counts the key comparisons, swaps and moves (keys written
+// outside of a swap) of every algorithm. Otherwise the counting macros expand to nothing and
+// the hot loops are the same as without them.
+#ifdef COUNT_OPERATIONS
+    #define COUNT_COMPARISONS(count) (threadOperationCounts.comparisons += (unsigned long long)(count))
+    #define COUNT_SWAPS(count) (threadOperationCounts.swaps += (unsigned long long)(count))
+    #define COUNT_MOVES(count) (threadOperationCounts.moves += (unsigned long long)(count))
+#else
+    #define COUNT_COMPARISONS(count) ((void)0)
+    #define COUNT_SWAPS(count) ((void)0)
+    #define COUNT_MOVES(count) ((void)0)
+#endif
+// Counts one comparison and evaluates to its result, e.g. if (COMPARE(array[j] < pivot))
+#define COMPARE(comparison) (COUNT_COMPARISONS(1), (comparison))
+
+/**
+ * @struct KeyValueRecord
+ * @brief A 16-byte record sorted by its key. The value travels with the key, the typed
+ * algorithms set it to the position of the key in the unsorted data.
+ */
+typedef struct {
+    uint64_t key;
+    uint64_t value;
+} KeyValueRecord;
+
+/**
+ * @struct Record32
+ * @brief Records of 32 to 256 bytes sorted by their key, for comparing direct and indirect
+ * sorting of large records. index is the position of the record in the unsorted data, the
+ * rest of the payload is zeroed.
+ */
+typedef struct {
+    uint64_t key;
+    uint64_t index;
+    unsigned char payload[16];
+} Record32;
+typedef struct {
+    uint64_t key;
+    uint64_t index;
+    unsigned char payload[48];
+} Record64;
+typedef struct {
+    uint64_t key;
+    uint64_t index;
+    unsigned char payload[112];
+} Record128;
+typedef struct {
+    uint64_t key;
+    uint64_t index;
+    unsigned char payload[240];
+} Record256;
+
+/**
+ * @struct RandomGenerator
+ * @brief The state of a xoshiro256** random stream
+ */
+typedef struct {
+    uint64_t state[4];
+} RandomGenerator;
+
+/**
+ * @struct OperationCounts
+ * @brief The key operations of a sort, only counted when built with -DCOUNT_OPERATIONS
+ * @var comparisons Comparisons between two keys
+ * @var swaps Exchanges of two keys
+ * @var moves Keys written to the array or a buffer outside of a swap
+ */
+typedef struct {
+    unsigned long long comparisons;
+    unsigned long long swaps;
+    unsigned long long moves;
+} OperationCounts;
+
+/**
+ * @struct MemoryCounts
+ * @brief The scratch memory a sort took from allocateScratch()
+ * @var peakBytes Most bytes in use at once, headers and rounding included
+ * @var allocations Blocks allocated
+ * @var systemAllocations Blocks that did not fit in the scratch arena and came from malloc
+ * @var allocatorTime Seconds spent in allocateScratch() and freeScratch()
+ */
+typedef struct {
+    unsigned long long peakBytes;
+    unsigned long long allocations;
+    unsigned long long systemAllocations;
+    double allocatorTime;
+} MemoryCounts;
+
+/**
+ * @struct ScratchArena
+ * @brief Memory the sorts take their scratch space from by bumping an offset. Blocks freed
+ * in the reverse order of their allocation give their space back at once, the others when
+ * every block above them is freed.
+ * @var used Bytes from the start of the arena to the end of the last block in use
+ * @var top Offset of the last block in use
+ * @var wanted Most bytes the runs since the arena was last grown needed at once, from the
+ * arena and malloc together. resetScratchMemory() grows the arena to it.
+ */
+typedef struct {
+    unsigned char *memory;
+    size_t capacity;
+    size_t used;
+    size_t top;
+    size_t wanted;
+} ScratchArena;
+
+/**
+ * @struct SortThresholds
+ * @brief The crossovers sort_u64 picks its algorithm with, measured on the local machine by
+ * the calibration run (./main --calibrate FILE)
+ * @var insertionCutoff Largest n sorted with insertion sort
+ * @var radixCutoff Smallest n sorted with LSD radix sort instead of the SIMD quick sort
+ * @var radixLimit Largest n sorted with LSD radix sort, past it the scatter misses the caches
+ * and the TLB too often. INT_MAX if there is no such n.
+ * @var parallelCutoff Smallest n sorted on every thread, INT_MAX if threads never pay off
+ */
+typedef struct {
+    int insertionCutoff;
+    int radixCutoff;
+    int radixLimit;
+    int parallelCutoff;
+} SortThresholds;
+
+/**
+ * The thresholds of sort_u64 and autoSort, the defaults until loadSortThresholds() is called.
+*/
+extern SortThresholds sortThresholds;
+
+/**
+ * Number of threads used by the parallel algorithms. Set at startup to the number
+ * of processors and changed by the batch mode when sweeping thread counts.
+*/
+extern int sortingThreads;
+
+/**
+ * 1 if the threads of the parallel sample and radix sorts are pinned to one processor each.
+*/
+extern int pinThreads;
+
+/**
+ * The kernels of the hot loops, selected at startup by selectSimdKernels() from what the CPU
+ * supports. They start as the scalar versions so they are always safe to call.
+*/
+extern void (*sortBlockKernel)(unsigned long int *array, int n);
+extern int (*partitionKernel)(unsigned long int *array, int low, int high, unsigned long int pivot, int equalGoesRight);
+extern void (*mergeRunsKernel)(const unsigned long int *left, int leftSize, const unsigned long int *right, int rightSize, unsigned long int *destination);
+extern const char *simdKernelLevel;
+#ifdef COUNT_OPERATIONS
+/**
+ * The operations counted by each thread, and the total of the worker threads that finished.
+*/
+extern _Thread_local OperationCounts threadOperationCounts;
+extern OperationCounts workerOperationCounts;
+extern pthread_mutex_t workerOperationCountsLock;
+#endif
+
+/**
+ * The arena the sorts take their scratch space from, 1 if it is used (--arena), and the
+ * scratch memory counted since the last resetScratchMemory().
+*/
+extern ScratchArena scratchArena;
+extern int useScratchArena;
+extern MemoryCounts scratchCounts;
+extern unsigned long long scratchBytesInUse;
+extern unsigned long long scratchSystemBytesInUse;
+extern pthread_mutex_t scratchLock;
+
+/**
+ * @brief Sorts 64-bit keys in ascending order with the algorithm sortThresholds gives for n
+ * and a sample of the input: Tim Sort when the sample is made of long runs, intro sort when
+ * it is mostly sorted, the SIMD quick sort when many keys repeat, and otherwise insertion,
+ * SIMD quick or LSD radix sort by size, on every thread past the parallel cutoff.
+ */
+void sort_u64(uint64_t *array, int n);
+/**
+ * @brief sort_u64 on the keys of the benchmarks, which are only 32 bits on Windows.
+ */
+void autoSort(unsigned long int *array, int n);
+/**
+ * @brief Reads the thresholds written by saveSortThresholds(). Thresholds missing from the
+ * file keep their current value. A file with an unknown name, a value out of range or a
+ * radix_cutoff above its radix_limit is invalid and changes none of them.
+ * @return 1 if the file was read, 0 if it could not be opened or is invalid.
+ */
+int loadSortThresholds(const char *filename, SortThresholds *thresholds);
+/**
+ * @brief Writes thresholds to a file, one "name value" line each.
+ * @param description Written as a comment on the first line, e.g. the CPU they were measured on
+ * @return 1 if the file was written, 0 otherwise.
+ */
+int saveSortThresholds(const char *filename, const SortThresholds *thresholds, const char *description);
+
+/*
+*
+* SORTING ALGORITHMS
+*
+*/
+void selectionSort(unsigned long int *array, int n);
+void bubbleSort(unsigned long int *array, int n);
+void insertionSort(unsigned long int *array, int n);
+void mergeSort(unsigned long int *array, int n);
+void bottomUpMergeSort(unsigned long int *array, int n);
+/**
+ * @brief Merge sort on sortingThreads threads. Each thread sorts a slice, then the
+ * slices are merged pairwise with every merge split evenly across all threads.
+ */
+void parallelMergeSort(unsigned long int *array, int n);
+void quickSort(unsigned long int *array, int n);
+void introSort(unsigned long int *array, int n);
+/**
+ * @brief Quick sort on sortingThreads threads. Each partition step pushes one side as a
+ * task onto the thread's work-stealing deque and continues with the other side.
+ */
+void parallelQuickSort(unsigned long int *array, int n);
+void heapSort(unsigned long int *array, int n);
+/**
+ * @brief dAryHeapSort on a binary heap
+ */
+void bottomUpHeapSort(unsigned long int *array, int n);
+/**
+ * @brief dAryHeapSort on a 4-ary heap
+ */
+void quaternaryHeapSort(unsigned long int *array, int n);
+/**
+ * @brief dAryHeapSort on an 8-ary heap
+ */
+void octonaryHeapSort(unsigned long int *array, int n);
+/**
+ * @brief Least significant digit first radix sort. All the digit histograms are
+ * counted in a single pass, and passes where every key has the same digit are skipped.
+ */
+void lsdRadixSort(unsigned long int *array, int n);
+void msdRadixSort(unsigned long int *array, int n);
+/**
+ * @brief Adaptive natural merge sort. It finds the runs already in the array (reversing the
+ * strictly descending ones), extends short runs to a minimum length with binary insertion sort,
+ * and merges them while keeping the run lengths balanced. Merges gallop when one run keeps
+ * winning. Sorted or reversed input is a single run and takes n - 1 comparisons.
+ */
+void timSort(unsigned long int *array, int n);
+/**
+ * @brief Sample sort on sortingThreads threads. Splitters picked from a sorted random sample cut
+ * the keys into buckets, each thread scatters its slice into the buckets, and then the threads
+ * sort the buckets independently, so there is no merge phase.
+ */
+void parallelSampleSort(unsigned long int *array, int n);
+/**
+ * @brief LSD radix sort on sortingThreads threads. In every pass each thread counts the digits of
+ * its slice, and the prefix sums over all the threads' counts give each thread where to scatter.
+ */
+void parallelLsdRadixSort(unsigned long int *array, int n);
+
+/*
+*
+* SELECTION
+*
+*/
+/**
+ * @brief Introselect: moves the key of rank k (0-based) to array[k], with the smaller or equal
+ * keys before it and the larger or equal keys after it, like std::nth_element. Quickselect on
+ * threeWayPartition, which falls back to medianOfMediansSelect after 2 * log2(n) partitions so
+ * that the worst case stays O(n).
+ */
+void introSelect(unsigned long int *array, int n, int k);
+/**
+ * @brief Copies the k smallest keys of array to smallest, in no particular order. They are kept
+ * in a max heap (heapify) that every smaller key replaces the root of, O(n log k).
+ * @param smallest Room for k keys
+ */
+void topK(const unsigned long int *array, int n, int k, unsigned long int *smallest);
+/**
+ * @brief Puts the k smallest keys at the start of array in order, like std::partial_sort. The
+ * rest are left in no particular order. introSelect then introSort of the k, O(n + k log k).
+ */
+void partialSort(unsigned long int *array, int n, int k);
+
+/*
+*
+* SIMD KERNELS
+*
+*/
+/**
+ * @brief Selects the kernels used by sortBlockKernel, partitionKernel and mergeRunsKernel.
+ * @param level "auto" for the best supported, or one of "avx512", "avx2" and "scalar"
+ * @return 1 if the level is supported by this CPU and build, 0 otherwise (the kernels are left as is)
+ */
+int selectSimdKernels(const char *level);
+/**
+ * @brief Quick sort built on the kernels chosen by selectSimdKernels(): vectorized two-way
+ * partitioning, sorting networks for small partitions and a heap sort fallback.
+ */
+void simdQuickSort(unsigned long int *array, int n);
+
+/*
+*
+* OPERATION COUNTING
+*
+*/
+/**
+ * @brief Clears the operations counted so far by the calling thread and the finished workers.
+ */
+void resetOperationCounts(void);
+/**
+ * @brief Takes the operations counted since the last reset, by the calling thread and its workers.
+ * @return The counted operations, all 0 when not built with -DCOUNT_OPERATIONS
+ */
+OperationCounts collectOperationCounts(void);
+
+/*
+*
+* SCRATCH MEMORY
+*
+*/
+/**
+ * @brief Allocates scratch space for a sort, from the scratch arena when it has room and
+ * useScratchArena is set, from malloc otherwise. The block is counted in scratchCounts.
+ * Safe to call from the worker threads.
+ * @return The block, aligned on a cache line, or NULL if there is no memory left.
+ */
+void *allocateScratch(size_t size);
+/**
+ * @brief allocateScratch() for count elements of size bytes, all set to 0.
+ */
+void *allocateZeroedScratch(size_t count, size_t size);
+/**
+ * @brief Moves a block of scratch memory to a block of size bytes, keeping its contents.
+ * @return The new block, or NULL if there is no memory left (the old block is then unchanged).
+ */
+void *reallocateScratch(void *memory, size_t size);
+/**
+ * @brief Releases a block returned by allocateScratch(). NULL is ignored.
+ */
+void freeScratch(void *memory);
+/**
+ * @brief Takes the scratch memory counted since the last reset.
+ */
+MemoryCounts collectMemoryCounts(void);
+
+/*
+*
+* UTILITIES
+*
+*/
+/**
+ * @brief Allocates memory starting on a cache line boundary.
+ * @return The memory, to be released with freeCacheAligned(), or NULL on error.
+ */
+void *allocateCacheAligned(size_t size);
+/**
+ * @brief Releases memory returned by allocateCacheAligned().
+ */
+void freeCacheAligned(void *memory);
+/**
+ * @brief Gives the current time in seconds.
+ * @returns The calculated time.
+*/
+double getTimeInSeconds(void);
+/**
+ * @brief Gives the number of processors available to the program.
+ * @returns The number of online processors, at least 1.
+*/
+int getProcessorCount(void);
+
+/*
+*
+* TYPED SORTING ALGORITHMS
+*
+*/
+/**
+ * The merge, intro, heap and LSD radix sorts generated for each element type by
+ * DEFINE_TYPED_SORTING_ALGORITHMS. The comparison and the radix key are macros, so they are
+ * inlined in the hot loops instead of being called through a comparator pointer. They take
+ * void * so that the algorithms of every element type have the same signature.
+*/
+#define DECLARE_TYPED_SORTING_ALGORITHMS(Suffix) \
+    void mergeSort##Suffix(void *elements, int n); \
+    void introSort##Suffix(void *elements, int n); \
+    void heapSort##Suffix(void *elements, int n); \
+    void lsdRadixSort##Suffix(void *elements, int n); \
+    void fill##Suffix(void *elements, const unsigned long int *keys, int n); \
+    int isSorted##Suffix(const void *elements, int n); \
+    uint64_t sortKey##Suffix(const void *elements, int i);
+DECLARE_TYPED_SORTING_ALGORITHMS(U32)
+DECLARE_TYPED_SORTING_ALGORITHMS(U64)
+DECLARE_TYPED_SORTING_ALGORITHMS(F32)
+DECLARE_TYPED_SORTING_ALGORITHMS(F64)
+DECLARE_TYPED_SORTING_ALGORITHMS(KeyValue)
+DECLARE_TYPED_SORTING_ALGORITHMS(Record32)
+DECLARE_TYPED_SORTING_ALGORITHMS(Record64)
+DECLARE_TYPED_SORTING_ALGORITHMS(Record128)
+DECLARE_TYPED_SORTING_ALGORITHMS(Record256)
+
+/*
+*
+* RANDOM NUMBERS
+*
+*/
+/**
+ * @brief Seeds a random stream with splitmix64. Each (seed, stream) pair gives an independent stream.
+ */
+void seedRandomGenerator(RandomGenerator *generator, uint64_t seed, uint64_t stream);
+/**
+ * @brief Draws the next 64 random bits of a xoshiro256** stream.
+ */
+uint64_t nextRandom(RandomGenerator *generator);
+/**
+ * @brief Draws a random double in [0, 1).
+ */
+double nextRandomDouble(RandomGenerator *generator);
+/**
+ * @brief Mixes the bits of a value with the splitmix64 finalizer. Different values stay different.
+ */
+uint64_t scrambleKey(uint64_t value);
+
+#endif